@@ -2,25 +2,31 @@
 #ifndef NOTE_INFO_ADAPTER_HPP
 #define NOTE_INFO_ADAPTER_HPP
 
+#include <span>
+#include <string>
 #include <vector>
 
+#include "audio/note_info.hpp"
+
 namespace FileReading::Parser {
 class SongNode;
 }
 
-namespace Audio {
-struct NoteInfo;
-}
-
 namespace Adapter {
 class NoteInfoAdapter {
 private:
   FileReading::Parser::SongNode *_song;
+  std::vector<std::string> _warnings;
 
 public:
   NoteInfoAdapter(FileReading::Parser::SongNode *song);
 
-  std::vector<Audio::NoteInfo *> convert();
+  /// One [Audio::Voice] per line of the song. A chord of N notes spreads over
+  /// N voices, padded with rests wherever that part of the song has fewer.
+  std::vector<Audio::Voice> convert();
+
+  /// Non-fatal issues found by the last [convert] call.
+  std::span<const std::string> warnings() const;
 };
 
 } // namespace Adapter
@@ -2,8 +2,18 @@
 #ifndef ARG_PARSER_HPP
 #define ARG_PARSER_HPP
 
+#include <cstddef>
 #include <string>
 #include <string_view>
+#include <vector>
+
+#include "audio/biquad.hpp"
+#include "audio/envelope.hpp"
+#include "audio/pcm_format.hpp"
+#include "audio/quantizer.hpp"
+#include "audio/resampler.hpp"
+#include "audio/timbre.hpp"
+#include "file_reading/logging/dump_writer.hpp"
 
 struct Args {
   std::string_view input_file;
@@ -13,7 +23,37 @@ struct Args {
   bool output_file_provided = false;
   bool lex_only = false;
   bool parse_only = false;
+  FileReading::Logging::DumpFormat dump_format =
+      FileReading::Logging::DumpFormat::Text; // of -l and -p
+  bool raw = false;        // header-less PCM16 output
+  std::string_view format; // "wav" or "flac", empty => from the file name
+  bool no_pipeline = false; // write files from the rendering thread
   double amplitude = 0.25;
+  Audio::Adsr envelope = Audio::fade_envelope(0.005);
+  Audio::Timbre timbre = Audio::Timbre::Sine;
+  std::string_view wavetable_cache; // empty => build the tables every run
+  std::vector<Audio::BiquadSettings> eq; // filter sections, in order
+  std::string_view reverb;          // preset, RT60 or IR file, empty => none
+  double reverb_mix = 0.3;
+  bool limit = false;
+  bool normalize = false;
+  double loudness_db = -16.0; // target RMS with normalize
+  std::uint32_t sample_rate = Audio::kSampleRate; // of the output
+  Audio::ResampleQuality resample_quality = Audio::ResampleQuality::Standard;
+  unsigned int bits = 16; // per sample in WAV and raw output
+  Audio::Dither dither = Audio::Dither::None;
+  std::string_view serve_socket;
+  bool serve = false;
+  std::string_view connect_socket;
+  bool connect = false;
+  unsigned int threads = 0;
+  bool no_cache = false;
+  std::string_view cache_dir; // empty => RenderCache::default_dir()
+  bool incremental = false;   // patch the output using its sidecar index
+  bool watch = false;         // render again on every save of the input
+  bool json_diagnostics = false; // score errors as JSON lines on stderr
+  bool check = false;            // validate the score and do nothing else
+  std::size_t max_errors = 10;   // where --check gives up
 };
 
 Args parse_args(int argc, char *argv[]);
@@ -0,0 +1,58 @@
+#pragma once
+#ifndef ADDITIVE_OSCILLATOR_HPP
+#define ADDITIVE_OSCILLATOR_HPP
+
+#include <array>
+#include <cstddef>
+#include <span>
+
+#include "audio/timbre.hpp"
+
+namespace Audio {
+
+/// Sums up to [kMaxPartials] sines for one note.
+///
+/// Every partial is a phasor that gets rotated by a fixed complex step each
+/// sample, so a sample costs a complex multiply per partial and no calls to
+/// `std::sin`. The phasors are laid out four to a SIMD register and advanced
+/// together, which makes a full 16 partial voice only four vector multiplies
+/// per sample. Decays are folded into the step's magnitude.
+class AdditiveOscillator {
+public:
+  static constexpr std::size_t kMaxPartials = 16;
+
+private:
+  static constexpr std::size_t kLanes = 4;
+  static constexpr std::size_t kChunk = 256; // samples per pass over a lane
+
+  // Phasor of every partial, the imaginary part is the partial's output
+  alignas(16) std::array<float, kMaxPartials> _re{};
+  alignas(16) std::array<float, kMaxPartials> _im{};
+  // Per sample rotation (and decay) of every partial
+  alignas(16) std::array<float, kMaxPartials> _step_re{};
+  alignas(16) std::array<float, kMaxPartials> _step_im{};
+  alignas(16) std::array<float, kChunk * kLanes> _sums{};
+
+  // Magnitude every phasor should have, tracked in double precision so the
+  // float phasors can be pulled back onto it after every pass
+  std::array<double, kMaxPartials> _magnitude{};
+  std::array<double, kMaxPartials> _decay{};
+  std::size_t _groups = 0; // groups of [kLanes] partials that are in use
+  // Renormalizing happens every [kChunk] samples of the note, wherever the
+  // caller's blocks end, so a note comes out the same however it's split
+  std::size_t _since_renormalize = 0;
+
+  void renormalize(std::size_t samples);
+
+public:
+  /// Starts a note at phase 0. Partials at or above Nyquist are dropped, the
+  /// rest are scaled so their gains sum to 1 and the output can't clip.
+  void start(std::span<const Partial> partials, double freq_hz);
+
+  /// Writes the next `out.size()` samples of the note.
+  void render(std::span<float> out);
+};
+
+} // namespace Audio
+
+#endif
@@ -0,0 +1,70 @@
+#pragma once
+#ifndef BIQUAD_HPP
+#define BIQUAD_HPP
+
+#include <array>
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "audio/effect.hpp"
+
+namespace Audio {
+
+enum class BiquadKind : unsigned int { LowPass, HighPass, Peaking };
+
+struct BiquadSettings {
+  BiquadKind kind = BiquadKind::LowPass;
+  double freq_hz = 1000.0;
+  double gain_db = 0.0; // only used by peaking filters
+  double q = 0.7071067811865476;
+};
+
+/// Parses "lp:FREQ[:Q]", "hp:FREQ[:Q]" or "peak:FREQ:GAIN_DB[:Q]".
+std::optional<BiquadSettings> parse_biquad(std::string_view spec);
+
+/// Normalized coefficients (a0 = 1) from the RBJ audio EQ cookbook.
+struct BiquadCoefficients {
+  float b0, b1, b2, a1, a2;
+};
+
+BiquadCoefficients biquad_coefficients(const BiquadSettings &settings);
+
+/// A cascade of biquads in transposed direct form II.
+///
+/// A cascade on a single signal is serial by nature, so instead of vectorizing
+/// across samples the sections are skewed across SIMD lanes: lane k holds
+/// section k, and on each step it filters the sample lane k - 1 produced on
+/// the step before. Four sections then cost one vector update per sample,
+/// at the price of a delay of one sample per extra section (a few
+/// microseconds, reported as part of the tail). Longer cascades run as
+/// several such groups one after the other. `make bench` measures it
+/// against plain scalar sections.
+class BiquadChain final : public Effect {
+public:
+  static constexpr std::size_t kLanes = 4;
+
+private:
+  struct Group {
+    alignas(16) std::array<float, kLanes> b0{}, b1{}, b2{}, a1{}, a2{};
+    alignas(16) std::array<float, kLanes> z1{}, z2{}, y{};
+    std::size_t sections = 0;
+  };
+
+  std::vector<Group> _groups;
+
+  static void process_group(Group &group, std::span<float> block);
+
+public:
+  explicit BiquadChain(std::span<const BiquadSettings> sections);
+
+  void process(std::span<float> block) override;
+
+  std::size_t tail_samples() const override;
+};
+
+} // namespace Audio
+
+#endif
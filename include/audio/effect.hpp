@@ -0,0 +1,27 @@
+#pragma once
+#ifndef EFFECT_HPP
+#define EFFECT_HPP
+
+#include <cstddef>
+#include <span>
+
+namespace Audio {
+
+/// A post-processing stage on the mixed float signal, run block by block
+/// before the final conversion to PCM.
+class Effect {
+public:
+  virtual ~Effect() = default;
+
+  /// Processes the next samples of the stream in place. Blocks can be any
+  /// size; the effect keeps whatever state it needs between calls.
+  virtual void process(std::span<float> block) = 0;
+
+  /// How long the effect keeps ringing once its input goes silent. The song
+  /// is extended by this many samples so the tail isn't cut off.
+  virtual std::size_t tail_samples() const { return 0; }
+};
+
+} // namespace Audio
+
+#endif
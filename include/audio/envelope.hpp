@@ -0,0 +1,62 @@
+#pragma once
+#ifndef ENVELOPE_HPP
+#define ENVELOPE_HPP
+
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace Audio {
+
+enum class EnvelopeCurve : unsigned int { Linear, Exponential };
+
+/// Attack/decay/sustain/release settings. Notes have a fixed length, so the
+/// release happens inside the note: it ends exactly when the note does.
+struct Adsr {
+  double attack_s = 0.005;
+  double decay_s = 0.0;
+  double sustain = 1.0; // level held between decay and release, in [0,1]
+  double release_s = 0.005;
+  EnvelopeCurve curve = EnvelopeCurve::Linear;
+};
+
+/// The original envelope: linear fades of [fade_s] in and out.
+Adsr fade_envelope(double fade_s);
+
+/// Parses a preset name ("fade", "pluck" or "pad") or
+/// "attack,decay,sustain,release[,lin|exp]" with times in seconds.
+std::optional<Adsr> parse_envelope(std::string_view spec);
+
+/// Evaluates an [Adsr] for a note a block at a time.
+///
+/// Every segment's ramp is computed once up front, so filling a block is a
+/// handful of straight loops over table entries, one per segment the block
+/// touches, with nothing decided per sample.
+class Envelope {
+private:
+  int _attack;
+  int _decay;
+  int _release;
+  double _sustain;
+  std::vector<double> _attack_ramp;  // 0 -> 1
+  std::vector<double> _decay_ramp;   // 1 -> sustain
+  std::vector<double> _release_ramp; // indexed by samples left in the note
+
+  int _note_samples = 0;
+  double _release_level = 1.0;
+
+public:
+  explicit Envelope(const Adsr &adsr);
+
+  /// Lays the segments out over a note [note_samples] long. Notes too short
+  /// for the whole envelope start their release early, from full level.
+  void start(int note_samples);
+
+  /// Gains for samples [offset, offset + out.size()) of the current note.
+  void render(std::span<double> out, int offset) const;
+};
+
+} // namespace Audio
+
+#endif
@@ -0,0 +1,49 @@
+#pragma once
+#ifndef FFT_HPP
+#define FFT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace Audio {
+
+/// FFT of real signals, [size] points in and `size / 2 + 1` bins out.
+///
+/// Runs an iterative radix-2 complex FFT of half the size on the signal's
+/// even/odd samples packed as real/imaginary parts, then untangles the two
+/// spectra. Spectra are kept as separate real and imaginary arrays so the
+/// loops working on them vectorize.
+///
+/// Not thread safe: every instance has a scratch buffer.
+class RealFft {
+private:
+  std::size_t _size;
+  std::size_t _half; // size of the complex FFT doing the work
+  std::vector<float> _cos, _sin;           // twiddles of the half size FFT
+  std::vector<float> _split_cos, _split_sin; // e^-2pi*i*k/size, k < half
+  std::vector<std::uint32_t> _bit_reverse;
+  std::vector<float> _work_re, _work_im;
+
+  void transform(bool inverse);
+
+public:
+  /// [size] has to be a power of two, at least 4.
+  explicit RealFft(std::size_t size);
+
+  std::size_t size() const;
+  std::size_t bins() const;
+
+  /// Spectrum of [in] (`size()` samples) into `bins()` long [re]/[im].
+  void forward(std::span<const float> in, std::span<float> re,
+               std::span<float> im);
+
+  /// Inverse of [forward], including the 1/size scaling.
+  void inverse(std::span<const float> re, std::span<const float> im,
+               std::span<float> out);
+};
+
+} // namespace Audio
+
+#endif
@@ -0,0 +1,56 @@
+#pragma once
+#ifndef FLAC_WRITER_HPP
+#define FLAC_WRITER_HPP
+
+#include <cstdint>
+#include <iosfwd>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "audio/pcm_format.hpp"
+
+namespace Audio {
+
+/// Streams mono PCM16 samples out as a FLAC file.
+///
+/// Samples are cut into fixed size frames, each predicted with the best of
+/// FLAC's fixed polynomial predictors (order 0-4) and Rice coded. Frames don't
+/// depend on each other, so a batch of them is encoded in parallel across
+/// [threads] cores and then written in order. Memory is bounded by the batch
+/// size, not by the length of the song.
+///
+/// Decoding the output gives back exactly the samples that went in.
+class FlacWriter {
+private:
+  std::ostream &_out;
+  std::uint64_t _total_samples;
+  unsigned int _threads;
+  std::uint32_t _sample_rate;
+  std::vector<std::int16_t> _pending; // samples not yet handed to a frame
+  std::uint64_t _frames_written = 0;
+  std::uint64_t _samples_written = 0;
+  bool _finished = false;
+
+  void write_stream_header();
+  void encode_batch(std::size_t samples);
+
+public:
+  /// FLAC wants the sample count up front, in the STREAMINFO block.
+  FlacWriter(std::ostream &out, std::uint64_t total_samples,
+             unsigned int threads = 0, std::uint32_t sample_rate = kSampleRate);
+
+  void write(std::span<const std::int16_t> samples);
+
+  /// Flushes the last (possibly short) frame. Must be called once all of the
+  /// samples were written.
+  void finish();
+};
+
+void write_pcm16_mono_flac(const std::string &path,
+                           const std::vector<std::int16_t> &samples,
+                           unsigned int threads = 0);
+
+} // namespace Audio
+
+#endif
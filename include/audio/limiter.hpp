@@ -0,0 +1,57 @@
+#pragma once
+#ifndef LIMITER_HPP
+#define LIMITER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "audio/effect.hpp"
+
+namespace Audio {
+
+struct LimiterSettings {
+  float ceiling = 0.891f;     // -1dBFS, under the mix's soft knee
+  double lookahead_s = 0.005; // how early gain reduction starts
+  double release_s = 0.05;    // time constant of the recovery afterwards
+};
+
+/// Streaming look-ahead peak limiter: no sample ever leaves above
+/// [LimiterSettings::ceiling], and gain changes are ramps instead of steps.
+///
+/// The signal is delayed by the look-ahead window of L samples. The gain
+/// each sample needs is run through a sliding minimum over the last L and
+/// then a moving average of length L, which both smooths the attack and
+/// guarantees the gain has come down far enough by the time the peak that
+/// asked for it comes out of the delay. Recovery is an exponential release.
+/// Everything is O(1) per sample.
+class LookaheadLimiter final : public Effect {
+private:
+  struct Held {
+    std::uint64_t index;
+    float gain;
+  };
+
+  float _ceiling;
+  std::size_t _window;
+  float _release; // per-sample step towards the target when recovering
+  std::vector<float> _delay;
+  std::vector<Held> _minimum; // ring of increasing gains, a monotonic queue
+  std::size_t _min_head = 0;
+  std::size_t _min_size = 0;
+  std::vector<float> _averaged; // ring of the last _window minimums
+  double _sum;
+  float _gain = 1.0f;
+  std::uint64_t _index = 0;
+
+public:
+  explicit LookaheadLimiter(const LimiterSettings &settings = {});
+
+  void process(std::span<float> block) override;
+
+  std::size_t tail_samples() const override;
+};
+
+} // namespace Audio
+
+#endif
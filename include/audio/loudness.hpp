@@ -0,0 +1,45 @@
+#pragma once
+#ifndef LOUDNESS_HPP
+#define LOUDNESS_HPP
+
+#include <map>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "audio/envelope.hpp"
+#include "audio/note_info.hpp"
+#include "audio/timbre.hpp"
+
+namespace Audio {
+
+/// Mean square of single notes rendered at unit amplitude with one song's
+/// envelope and timbre. Each distinct pitch and length is rendered once, on
+/// its own, the first time it's asked for; songs repeat the same few notes,
+/// so this stays a small fraction of rendering the song.
+class NoteLoudnessCache {
+private:
+  Adsr _envelope;
+  Timbre _timbre;
+  std::map<std::pair<double, int>, double> _mean_squares;
+  std::vector<float> _scratch;
+
+public:
+  NoteLoudnessCache(const Adsr &envelope, Timbre timbre);
+
+  double mean_square(const NoteInfo &note);
+};
+
+/// RMS level the mix of [voices] will have at unit amplitude, over the time
+/// at least one voice is playing (silence doesn't count). Voices are taken to
+/// be uncorrelated, so their powers add. Effects aren't accounted for.
+double estimate_rms(std::span<const Voice> voices, NoteLoudnessCache &cache);
+
+/// Amplitude that brings the mix of [voices] to [target_db] dBFS RMS, from a
+/// pass over the note table instead of a trial render.
+double normalized_amplitude(std::span<const Voice> voices, const Adsr &envelope,
+                            Timbre timbre, double target_db);
+
+} // namespace Audio
+
+#endif
@@ -0,0 +1,64 @@
+#pragma once
+#ifndef MELODY_RENDERER_HPP
+#define MELODY_RENDERER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+
+#include "audio/additive_oscillator.hpp"
+#include "audio/envelope.hpp"
+#include "audio/timbre.hpp"
+#include "audio/wavetable.hpp"
+
+namespace Audio {
+struct NoteInfo;
+
+/// Renders a note table into PCM16 samples a block at a time, so callers can
+/// stream a song out without holding all of it in memory.
+///
+/// The renderer only borrows [notes]; the table has to outlive it.
+class MelodyRenderer {
+private:
+  std::span<const NoteInfo> _notes;
+  double _amplitude;
+  Envelope _envelope;
+  Timbre _timbre;
+  std::optional<Waveform> _waveform; // set for the wavetable timbres
+  AdditiveOscillator _additive;
+  WavetableOscillator _wavetable;
+  std::size_t _note = 0; // index of the note currently being rendered
+  int _pos = 0;          // sample offset inside the current note
+  std::uint64_t _total_samples = 0;
+
+  void start_note(double freq_hz);
+  void render_note(std::span<float> out);
+  template <typename Sample> std::size_t render_into(std::span<Sample> out);
+
+public:
+  /// Wavetable timbres play from [WavetableBank::shared], which gets built
+  /// here if nothing has loaded it yet.
+  MelodyRenderer(std::span<const NoteInfo> notes, double amplitude = 0.25,
+                 const Adsr &envelope = fade_envelope(0.005),
+                 Timbre timbre = Timbre::Sine);
+
+  /// Fills [out] with the next samples of the song and returns how many were
+  /// written. Only returns less than `out.size()` once the song is over.
+  std::size_t render(std::span<std::int16_t> out);
+
+  /// Same as the PCM16 overload, but unquantized in [-1, 1] for mixing.
+  std::size_t render(std::span<float> out);
+
+  bool done() const;
+
+  /// Number of samples the whole song renders to.
+  std::uint64_t total_samples() const;
+};
+
+/// Number of samples a single note renders to.
+int note_samples(const NoteInfo &note);
+
+} // namespace Audio
+
+#endif
@@ -0,0 +1,126 @@
+#pragma once
+#ifndef MIX_RENDERER_HPP
+#define MIX_RENDERER_HPP
+
+#include <barrier>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include "audio/effect.hpp"
+#include "audio/melody_renderer.hpp"
+#include "audio/note_info.hpp"
+#include "audio/pcm_format.hpp"
+#include "audio/quantizer.hpp"
+#include "audio/resampler.hpp"
+
+namespace Audio {
+
+/// Number of samples [voices] render to when played together.
+std::uint64_t song_samples(std::span<const Voice> voices);
+
+/// Renders several voices at once and mixes them down to PCM16 or PCM24.
+///
+/// Every voice gets its own [MelodyRenderer] writing float blocks into a
+/// scratch buffer, so memory use is the block size times the number of
+/// voices no matter how long the song is. The blocks are summed, run through
+/// any [Effect]s added, optionally resampled to another output rate, then a
+/// soft limiter and a [Quantizer], four samples at a time with SSE2. A single
+/// voice without effects skips the soft limiter, so it comes out exactly as
+/// [MelodyRenderer] renders it.
+///
+/// Voices are spread over [threads] threads (this one included), each
+/// rendering its share of every block. Voices always render at
+/// [kSampleRate].
+///
+/// Like [MelodyRenderer], the voices are only borrowed.
+class MixRenderer {
+public:
+  static constexpr std::size_t kBlockSamples = 4096;
+
+  /// Level (of full scale) below which the limiter leaves samples untouched.
+  /// Above it, peaks get bent smoothly towards full scale instead of
+  /// wrapping around.
+  static constexpr float kLimiterThreshold = 0.9f;
+
+private:
+  // Rounded up to whole SSE registers
+  static constexpr std::size_t kScratchSamples = (kBlockSamples + 3) / 4 * 4;
+
+  std::vector<MelodyRenderer> _voices;
+  std::vector<std::vector<float>> _scratch; // one block per voice
+  std::vector<float> _mix;
+  std::vector<std::unique_ptr<Effect>> _effects;
+  std::uint64_t _song_samples = 0;
+  std::uint64_t _total_samples = 0; // including the effects' tails
+  std::uint64_t _position = 0;
+
+  // Only set for an output rate other than kSampleRate
+  std::unique_ptr<Resampler> _resampler;
+  std::uint32_t _output_rate = kSampleRate;
+  std::vector<float> _resampled; // output not yet quantized
+  std::size_t _resampled_read = 0;
+  std::uint64_t _output_position = 0;
+  Quantizer _quantizer;
+
+  std::size_t _threads;
+  std::size_t _job_samples = 0;
+  bool _stopping = false;
+  std::barrier<> _start;
+  std::barrier<> _finish;
+  std::vector<std::thread> _workers;
+
+  void render_share(std::size_t thread);
+  template <typename Sink>
+  std::size_t render_blocks(std::size_t samples, Sink &&sink);
+  std::span<float> next_block(std::size_t samples);
+  std::span<float> mix_block(std::size_t samples);
+  void sum_voices(std::span<float> mix);
+
+public:
+  /// [threads] = 0 uses one per core; never more than there are voices.
+  MixRenderer(std::span<const Voice> voices, double amplitude,
+              const Adsr &envelope, Timbre timbre, unsigned int threads = 1);
+  ~MixRenderer();
+  MixRenderer(const MixRenderer &) = delete;
+  MixRenderer &operator=(const MixRenderer &) = delete;
+
+  /// Appends a stage to the post-processing chain the mix runs through
+  /// before it's quantized. The song gets longer by the effect's tail. Has to
+  /// happen before anything is rendered.
+  void add_effect(std::unique_ptr<Effect> effect);
+
+  /// Resamples the mix to [rate] on its way out, see [Resampler]. Has to
+  /// happen before anything is rendered.
+  void set_output_rate(std::uint32_t rate,
+                       ResampleQuality quality = ResampleQuality::Standard);
+
+  std::uint32_t output_rate() const;
+
+  /// Dither for the final conversion; none by default.
+  void set_dither(Dither dither);
+
+  /// Fills [out] with the next samples of the song and returns how many were
+  /// written. Only returns less than `out.size()` once the song is over.
+  std::size_t render(std::span<std::int16_t> out);
+
+  /// Same as the PCM16 overload, as packed little endian PCM24. Returns the
+  /// number of samples, [kPcm24Bytes] each.
+  std::size_t render_pcm24(std::span<std::uint8_t> out);
+
+  bool done() const;
+
+  /// Soft limits a finished mix in place, see [kLimiterThreshold].
+  static void limit(std::span<float> mix);
+
+  /// Number of samples the longest voice renders to, plus the longest
+  /// effect tail, at the output rate.
+  std::uint64_t total_samples() const;
+};
+
+} // namespace Audio
+
+#endif
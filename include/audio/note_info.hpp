@@ -2,12 +2,18 @@
 #ifndef NOTE_INFO_HPP
 #define NOTE_INFO_HPP
 
+#include <vector>
+
 namespace Audio {
 struct NoteInfo {
   NoteInfo(double freq, double dur) : freq_hz(freq), dur_s(dur) {}
   double freq_hz; // Frequency in hertz
   double dur_s;   // Duration in seconds
 };
+
+/// One monophonic line of a song. Songs play as a set of these, all starting
+/// at time 0; a rest has a frequency of 0.
+using Voice = std::vector<NoteInfo>;
 } // namespace Audio
 
 #endif
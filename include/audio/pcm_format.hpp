@@ -0,0 +1,17 @@
+#pragma once
+#ifndef PCM_FORMAT_HPP
+#define PCM_FORMAT_HPP
+
+#include <cstdint>
+
+namespace Audio {
+inline constexpr std::uint32_t kSampleRate = 44'100;
+inline constexpr std::uint16_t kChannels = 1;
+inline constexpr std::uint16_t kBitsPerSample = 16;
+inline constexpr std::uint16_t kBytesPerSample = kBitsPerSample / 8;
+inline constexpr std::uint16_t kBlockAlign = static_cast<std::uint16_t>(
+    kChannels * kBytesPerSample); // bytes per audio frame
+inline constexpr std::uint32_t kByteRate = kSampleRate * kBlockAlign;
+} // namespace Audio
+
+#endif
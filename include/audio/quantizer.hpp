@@ -0,0 +1,61 @@
+#pragma once
+#ifndef QUANTIZER_HPP
+#define QUANTIZER_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace Audio {
+
+enum class Dither : unsigned int {
+  None,   // plain rounding
+  Tpdf,   // triangular noise of +-1 LSB, decorrelates the rounding error
+  Shaped, // TPDF plus first order error feedback, pushing the noise up
+};
+
+std::optional<Dither> parse_dither(std::string_view name);
+
+/// Bytes of one packed little endian PCM24 sample.
+inline constexpr std::size_t kPcm24Bytes = 3;
+
+/// Final conversion of float samples in [-1, 1] to PCM16 or PCM24.
+///
+/// Samples are rounded to nearest and saturate at full scale instead of
+/// wrapping, four at a time with SSE2 (`_mm_cvtps_epi32` and, for PCM16,
+/// `_mm_packs_epi32`). Dither comes from four xorshift32 generators run side
+/// by side in one register; the difference of two uniform draws gives the
+/// triangular distribution. Noise shaping feeds each sample's rounding error
+/// into the next one, which is inherently serial, so that mode converts one
+/// sample at a time.
+///
+/// The generator and shaping state carry over between calls, so blocks of
+/// any size stream through.
+class Quantizer {
+private:
+  Dither _dither;
+  alignas(16) std::array<std::uint32_t, 4> _state;
+  float _error = 0.0f;
+  std::vector<float> _noise;
+
+  void fill_noise(std::size_t samples);
+  template <typename Store>
+  void shape(std::span<const float> in, float full_scale, float low,
+             float high, Store &&store);
+
+public:
+  explicit Quantizer(Dither dither = Dither::None, std::uint32_t seed = 1);
+
+  void to_pcm16(std::span<const float> in, std::span<std::int16_t> out);
+
+  /// [out] holds `kPcm24Bytes * in.size()` bytes.
+  void to_pcm24(std::span<const float> in, std::span<std::uint8_t> out);
+};
+
+} // namespace Audio
+
+#endif
@@ -0,0 +1,76 @@
+#pragma once
+#ifndef RESAMPLER_HPP
+#define RESAMPLER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace Audio {
+
+/// Trades filter length (and so speed) for stopband rejection and how much
+/// of the passband survives.
+enum class ResampleQuality : unsigned int {
+  Fast,     // 8 taps, passband to 85% of Nyquist, ~-45dB stopband
+  Standard, // 32 taps, passband to 92% of Nyquist, ~-80dB stopband
+  Best,     // 64 taps, passband to 95% of Nyquist, ~-100dB stopband
+};
+
+std::optional<ResampleQuality> parse_resample_quality(std::string_view name);
+
+/// Streaming polyphase windowed-sinc sample rate converter.
+///
+/// The rate ratio is reduced to [up]/[down] and the Kaiser windowed sinc
+/// is precomputed at [up] fractional offsets, so every output sample is one
+/// inner product (four taps at a time with SSE2) against a table picked by
+/// its phase. Ratios too awkward for that many tables (44100 -> 44101, say)
+/// get the closest of kMaxPhases tables instead, a timing error of at most
+/// 1/2048 of a sample (about -80dB on a 1kHz tone). When going down in rate
+/// the cutoff follows the output Nyquist and the filter gets longer by the
+/// same factor.
+///
+/// Output sample j sits at input time j * in_rate / out_rate: there is no
+/// delay, and [finish] flushes the filter so exactly [output_samples] come
+/// out in total.
+class Resampler {
+public:
+  static constexpr std::size_t kMaxPhases = 1024;
+
+private:
+  std::uint64_t _up;
+  std::uint64_t _down;
+  std::size_t _phases;
+  std::size_t _taps;
+  std::vector<float> _coefficients; // _phases + 1 tables of _taps
+  std::vector<float> _history;      // input the next outputs still need
+  std::size_t _start = 0;           // first tap of the next output
+  std::uint64_t _frac = 0;          // its offset past _start, in 1/_up
+  std::uint64_t _consumed = 0;
+  std::uint64_t _produced = 0;
+
+  void drain(std::vector<float> &out, std::uint64_t limit);
+
+public:
+  Resampler(std::uint32_t in_rate, std::uint32_t out_rate,
+            ResampleQuality quality = ResampleQuality::Standard);
+
+  /// Samples a stream of [input] samples at [in_rate] turns into.
+  static std::uint64_t output_samples(std::uint64_t input,
+                                      std::uint32_t in_rate,
+                                      std::uint32_t out_rate);
+
+  /// Appends to [out] every output sample [in] completes.
+  void process(std::span<const float> in, std::vector<float> &out);
+
+  /// Appends the outputs still held back by the end of the input.
+  void finish(std::vector<float> &out);
+
+  std::size_t taps() const;
+};
+
+} // namespace Audio
+
+#endif
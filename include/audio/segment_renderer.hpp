@@ -0,0 +1,64 @@
+#pragma once
+#ifndef SEGMENT_RENDERER_HPP
+#define SEGMENT_RENDERER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "audio/envelope.hpp"
+#include "audio/melody_renderer.hpp"
+#include "audio/note_info.hpp"
+#include "audio/quantizer.hpp"
+#include "audio/timbre.hpp"
+
+namespace Audio {
+
+/// Renders any stretch of the song a plain [MixRenderer] (no effects, no
+/// resampling, no dither) would produce for the same voices, sample for
+/// sample the same, without rendering what comes before it.
+///
+/// A note sounds the same wherever it starts and however its blocks are cut,
+/// so each voice only has to start from the note under the first sample
+/// asked for; whatever of that note lies before it is rendered and thrown
+/// away. The cost of a stretch is its length plus up to one note per voice,
+/// and nothing extra when it starts where the last one ended.
+///
+/// Like [MixRenderer], the voices are only borrowed.
+class SegmentRenderer {
+private:
+  std::span<const Voice> _voices;
+  std::vector<std::vector<std::uint64_t>> _starts; // first sample of each note
+  double _amplitude;
+  Adsr _envelope;
+  Timbre _timbre;
+  std::vector<std::vector<float>> _scratch; // one block per voice
+  std::vector<float> _mix;
+  Quantizer _quantizer;
+  // Where each voice stopped, so a call picking up at [_position] just
+  // carries on
+  std::vector<std::optional<MelodyRenderer>> _renderers;
+  std::uint64_t _position = 0;
+
+  void seek(std::uint64_t start);
+  template <typename Sink>
+  void render_range(std::uint64_t start, std::size_t samples, Sink &&sink);
+
+public:
+  SegmentRenderer(std::span<const Voice> voices, double amplitude,
+                  const Adsr &envelope, Timbre timbre);
+
+  /// Fills [out] with the song from sample [start] on; past the end of the
+  /// song is silence.
+  void render(std::uint64_t start, std::span<std::int16_t> out);
+
+  /// Same as the PCM16 overload, as packed little endian PCM24, [kPcm24Bytes]
+  /// per sample.
+  void render_pcm24(std::uint64_t start, std::span<std::uint8_t> out);
+};
+
+} // namespace Audio
+
+#endif
@@ -0,0 +1,39 @@
+#pragma once
+#ifndef TIMBRE_HPP
+#define TIMBRE_HPP
+
+#include <optional>
+#include <span>
+#include <string_view>
+
+namespace Audio {
+
+/// One sine component of a timbre, relative to the note it's played on.
+struct Partial {
+  double ratio;   // frequency as a multiple of the note's
+  double gain;    // relative level, the table gets normalized to a peak of 1
+  double decay_s; // time constant of an exponential decay, 0 => sustained
+};
+
+enum class Timbre : unsigned int {
+  Sine, // a single pure sine, the original sound
+  Organ,
+  SoftSquare, // odd harmonics only, rolling off like a square wave
+  Bell,       // inharmonic, every partial dying away at its own rate
+  // Band-limited wavetables, see audio/wavetable.hpp
+  Saw,
+  Square,
+  Triangle,
+};
+
+/// Partial table for [timbre]. Empty for [Timbre::Sine], which is rendered
+/// straight from `std::sin`, and for the wavetable timbres.
+std::span<const Partial> timbre_partials(Timbre timbre);
+
+std::optional<Timbre> parse_timbre(std::string_view name);
+
+std::string_view timbre_name(Timbre timbre);
+
+} // namespace Audio
+
+#endif
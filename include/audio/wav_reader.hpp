@@ -0,0 +1,22 @@
+#pragma once
+#ifndef WAV_READER_HPP
+#define WAV_READER_HPP
+
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+namespace Audio {
+
+struct WavData {
+  std::uint32_t sample_rate = 0;
+  std::vector<float> samples; // mono, in [-1, 1]
+};
+
+/// Reads a PCM16, PCM24 or 32 bit float WAV file, averaging all channels
+/// down to one. Throws `std::runtime_error` for anything else.
+WavData read_wav_mono(const std::filesystem::path &path);
+
+} // namespace Audio
+
+#endif
@@ -3,18 +3,49 @@
 #define WAV_WRITER_HPP
 
 #include <cstdint>
+#include <functional>
+#include <ostream>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include "audio/pcm_format.hpp"
+
 namespace Audio {
 struct NoteInfo;
 
+/// Size of a plain RIFF header.
+inline constexpr std::size_t kWavHeaderBytes = 44;
+
+/// Writes the RIFF/fmt/data headers for a mono PCM16 file holding
+/// [num_samples] samples. The sample payload is expected to follow directly.
+///
+/// Payloads too big for RIFF's 32 bit size fields get an RF64 header instead,
+/// which is [wav_header_bytes] long.
+void write_pcm16_mono_header(std::ostream &os, std::uint64_t num_samples,
+                             std::uint32_t sample_rate = kSampleRate);
+
+/// Same for a file of [bits_per_sample] (16 or 24) bit samples.
+void write_pcm_mono_header(std::ostream &os, std::uint64_t num_samples,
+                           std::uint32_t sample_rate,
+                           std::uint16_t bits_per_sample);
+
+std::size_t wav_header_bytes(std::uint64_t num_samples,
+                             std::uint16_t bits_per_sample = kBitsPerSample);
+
+/// Number of samples in a file of [file_bytes] bytes written by
+/// [write_pcm16_mono_header] plus its payload.
+std::uint64_t wav_samples_in_file(std::uint64_t file_bytes);
+
 void write_pcm16_mono_wav(const std::string &path,
                           const std::vector<std::int16_t> &samples);
 
-std::vector<std::int16_t> encode_melody(const std::vector<NoteInfo *> &notes,
-                                        double amplitude = 0.25,
-                                        double fade_s = 0.005);
+/// Renders [notes] in one go. An amplitude outside [0,1] is rendered anyway
+/// and passed to [on_warning], if there is one, rather than printed.
+std::vector<std::int16_t>
+encode_melody(const std::vector<NoteInfo> &notes, double amplitude = 0.25,
+              double fade_s = 0.005,
+              const std::function<void(std::string_view)> &on_warning = {});
 
 } // namespace Audio
 
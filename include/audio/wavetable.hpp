@@ -0,0 +1,84 @@
+#pragma once
+#ifndef WAVETABLE_HPP
+#define WAVETABLE_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "audio/timbre.hpp"
+
+namespace Audio {
+
+enum class Waveform : unsigned int { Saw, Square, Triangle };
+
+/// Waveform a wavetable [timbre] plays, or nothing for the other timbres.
+std::optional<Waveform> timbre_waveform(Timbre timbre);
+
+/// Band-limited single cycle tables for every [Waveform], one per octave.
+///
+/// The table for an octave only holds the harmonics that stay below Nyquist
+/// for the highest note in that octave, so playing any note from its own
+/// octave's table can't alias.
+class WavetableBank {
+public:
+  static constexpr std::size_t kTableBits = 11;
+  static constexpr std::size_t kTableSize = std::size_t{1} << kTableBits;
+  static constexpr std::size_t kOctaves = 11;
+  static constexpr double kLowestHz = 16.351597831287414; // C0
+
+private:
+  static constexpr std::size_t kWaveforms = 3;
+  // Every table carries a copy of its first sample at the end, so
+  // interpolation never has to wrap
+  static constexpr std::size_t kStride = kTableSize + 1;
+
+  std::vector<float> _samples;
+
+  WavetableBank();
+
+public:
+  /// Computes every table from its Fourier series.
+  static WavetableBank build();
+
+  /// Reads a blob written by [save]. Returns nothing if it's missing or was
+  /// written with different table dimensions.
+  static std::optional<WavetableBank> load(const std::filesystem::path &path);
+
+  /// Writes the tables to [path] through a temporary file, so concurrent
+  /// readers never see half of a blob. Returns false on failure.
+  bool save(const std::filesystem::path &path) const;
+
+  /// Bank shared by every renderer in the process, built on first use.
+  static const WavetableBank &shared();
+
+  /// Same as [shared], but the first call loads the bank from [cache] if it
+  /// holds a valid blob, and otherwise builds it and writes it there.
+  static const WavetableBank &shared(const std::filesystem::path &cache);
+
+  /// Table to play [freq_hz] with; [kTableSize] + 1 samples long.
+  std::span<const float> table(Waveform waveform, double freq_hz) const;
+};
+
+/// Plays a note from a [WavetableBank]: one table read and a linear
+/// interpolation per sample.
+class WavetableOscillator {
+private:
+  const float *_table = nullptr;
+  std::uint32_t _phase = 0; // position in the cycle as a 0.32 fixed point
+  std::uint32_t _step = 0;
+
+public:
+  /// Starts a note at phase 0. [bank] has to outlive the note.
+  void start(const WavetableBank &bank, Waveform waveform, double freq_hz);
+
+  void render(std::span<float> out);
+};
+
+} // namespace Audio
+
+#endif
@@ -0,0 +1,77 @@
+#pragma once
+#ifndef RENDER_CACHE_HPP
+#define RENDER_CACHE_HPP
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Cache {
+
+/// Score text with everything that can't change the song taken out: comments,
+/// carriage returns, indentation, trailing and repeated blanks, empty lines.
+/// Line breaks stay, the lexer looks at them.
+std::string normalize_score(std::string_view text);
+
+/// Identity of the running executable (path, size and modification time), so
+/// a rebuilt binary never serves what an older one rendered. Computed once.
+std::uint64_t binary_fingerprint();
+
+/// Finished renders on disk, addressed by a hash of everything that went into
+/// them (see [normalize_score] and [binary_fingerprint]).
+///
+/// Entries are whole output files named after their key, next to the
+/// warnings the render printed, if any, so a hit can print them again. They
+/// are written to a temporary name and renamed into place, so concurrent
+/// renders of the same song at worst both store it, and a reader never sees
+/// half a file. A hit hard links the entry to the output (or copies it across
+/// file systems) and bumps its modification time; once the directory outgrows
+/// its cap the least recently used entries go first.
+class RenderCache {
+public:
+  static constexpr std::uint64_t kDefaultMaxBytes = 1ull << 30;
+
+private:
+  std::filesystem::path _dir;
+  std::uint64_t _max_bytes;
+
+  std::filesystem::path entry(std::uint64_t key) const;
+  std::filesystem::path warnings_entry(std::uint64_t key) const;
+  void evict();
+
+public:
+  explicit RenderCache(std::filesystem::path dir,
+                       std::uint64_t max_bytes = kDefaultMaxBytes);
+
+  /// $XDG_CACHE_HOME/music-gen, or ~/.cache/music-gen.
+  static std::filesystem::path default_dir();
+
+  /// Puts the entry for [key] at [output] and gives back the warnings stored
+  /// with it; nullopt on a miss.
+  std::optional<std::vector<std::string>>
+  fetch(std::uint64_t key, const std::filesystem::path &output);
+
+  /// Makes [output] and the [warnings] printed while rendering it the entry
+  /// for [key]. Failing to store only costs a future hit, so errors are
+  /// swallowed.
+  void store(std::uint64_t key, const std::filesystem::path &output,
+             std::span<const std::string> warnings = {});
+
+  /// Unlinks [output] if it shares its data with another name, so that
+  /// writing it afterwards can't change a cache entry behind our back. Call
+  /// before overwriting a file [fetch] or [store] may have linked.
+  static void detach(const std::filesystem::path &output);
+
+  /// Like [detach], for a file that is about to be patched rather than
+  /// rewritten: [output] keeps its contents, in a copy of its own. False if
+  /// it couldn't be copied.
+  static bool unshare(const std::filesystem::path &output);
+};
+
+} // namespace Cache
+
+#endif
@@ -0,0 +1,85 @@
+#pragma once
+#ifndef RENDER_INDEX_HPP
+#define RENDER_INDEX_HPP
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "audio/note_info.hpp"
+
+namespace Cache {
+
+/// One note of an indexed render: a hash of what it sounds like, and how many
+/// samples it takes.
+struct IndexedNote {
+  std::uint64_t hash;
+  std::uint64_t samples;
+
+  bool operator==(const IndexedNote &) const = default;
+};
+
+/// Sidecar of a rendered file (`<output>.idx`) listing every note of every
+/// voice, so the next render of an edited score can tell which samples of
+/// the file are still right.
+///
+/// Only meaningful for renders whose samples each depend on the notes
+/// playing at that instant alone: no effects, resampling or dither. The file
+/// it describes is pinned by size and modification time, anything else
+/// touching it makes the index stale.
+struct RenderIndex {
+  std::uint64_t options = 0; // hash of every render setting but the score
+  std::uint64_t file_bytes = 0;
+  std::int64_t mtime_ns = 0;
+  std::vector<std::vector<IndexedNote>> voices;
+
+  static RenderIndex of(std::span<const Audio::Voice> voices,
+                        std::uint64_t options);
+
+  /// Nothing if [path] is missing or isn't an index this build wrote.
+  static std::optional<RenderIndex> load(const std::filesystem::path &path);
+
+  /// Written to a temporary name and renamed into place. False if it
+  /// couldn't be written, which only costs the next render its shortcut.
+  bool save(const std::filesystem::path &path) const;
+
+  /// Records [output]'s current size and modification time.
+  void pin(const std::filesystem::path &output);
+
+  /// True if [output] is still the file this index was pinned to.
+  bool describes(const std::filesystem::path &output) const;
+
+  std::uint64_t song_samples() const;
+};
+
+/// Where the index of [output] lives.
+std::filesystem::path index_path(const std::filesystem::path &output);
+
+/// How to turn the file an old index describes into the render of a new one.
+///
+/// The song from [tail_from] on in the old file is the same as the new song
+/// from [tail_to] on, [tail_samples] long, so it can be moved over as is.
+/// Before the tail, everything outside [dirty] is already right.
+struct RenderPatch {
+  std::uint64_t tail_from = 0;
+  std::uint64_t tail_to = 0;
+  std::uint64_t tail_samples = 0;
+  std::vector<std::pair<std::uint64_t, std::uint64_t>> dirty; // [begin, end)
+
+  std::uint64_t dirty_samples() const;
+};
+
+/// Diffs two note tables. A note is kept when the other table has the same
+/// note at the same sample in the same voice; the tail is the longest stretch
+/// at the end of the song every voice either plays unchanged, shifted by the
+/// same number of samples, or is silent through. Nothing if the tables have
+/// different numbers of voices.
+std::optional<RenderPatch> plan_patch(const RenderIndex &old_index,
+                                      const RenderIndex &new_index);
+
+} // namespace Cache
+
+#endif
@@ -0,0 +1,16 @@
+#pragma once
+#ifndef XXHASH_HPP
+#define XXHASH_HPP
+
+#include <cstdint>
+#include <string_view>
+
+namespace Cache {
+
+/// 64 bit xxHash (XXH64) of [data]. Not cryptographic: it's for telling
+/// contents apart quickly, at several GB/s.
+std::uint64_t xxh64(std::string_view data, std::uint64_t seed = 0);
+
+} // namespace Cache
+
+#endif
@@ -0,0 +1,76 @@
+#pragma once
+#ifndef DIAGNOSTIC_HPP
+#define DIAGNOSTIC_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "file_reading/lexer/token.hpp"
+
+namespace FileReading {
+
+enum class DiagnosticCode : std::uint8_t {
+  UnexpectedCharacter, // lexer: [actual] starts no token
+  ExpectedCharacter,   // lexer: [expected] was needed, [actual] came
+  UnexpectedEof,       // lexer: [expected] was needed, the input ended
+  UnexpectedToken,     // parser: token kinds [expected] and [actual]
+  EmptyChord,          // parser: a chord without notes
+};
+
+/// Stable name of [code], like "unexpected_token", for tools to match on.
+std::string diagnostic_code_to_str(DiagnosticCode code);
+
+/// One error found in a score, kept as what went wrong and where; [message]
+/// only puts it into words when someone asks.
+struct Diagnostic {
+  DiagnosticCode code;
+  Lexer::SourceLocation loc;
+  std::size_t offset = 0; // bytes into the source
+  // Characters for the lexer's codes, Lexer::TokenKind values for
+  // UnexpectedToken; unused where the code doesn't mention them
+  std::uint32_t expected = 0;
+  std::uint32_t actual = 0;
+
+  std::string message() const;
+};
+
+/// The errors of one lex or parse. Input that isn't much of a score can have
+/// an error every few bytes, so only the first [kLimit] are kept and the rest
+/// are just counted.
+class Diagnostics {
+public:
+  static constexpr std::size_t kLimit = 100;
+
+private:
+  std::vector<Diagnostic> _kept;
+  std::size_t _count = 0;
+
+public:
+  void report(const Diagnostic &diagnostic);
+  void clear();
+
+  /// Adds [other]'s diagnostics, keeping the whole list in source order (both
+  /// are assumed to be already), and the first [kLimit] of it.
+  void merge(const Diagnostics &other);
+
+  bool empty() const;
+
+  /// Everything reported, kept or not.
+  std::size_t count() const;
+
+  std::span<const Diagnostic> kept() const;
+
+  /// How many were reported past [kLimit].
+  std::size_t dropped() const;
+
+  /// The kept diagnostics' messages, then one saying how many more there
+  /// were if any got dropped.
+  std::vector<std::string> messages() const;
+};
+
+} // namespace FileReading
+
+#endif
@@ -2,19 +2,32 @@
 #ifndef LEXER_HPP
 #define LEXER_HPP
 
+#include <deque>
+#include <memory_resource>
 #include <string_view>
 #include <vector>
 
+#include "file_reading/diagnostic.hpp"
+#include "file_reading/lexer/token.hpp"
+
 namespace FileReading::Lexer {
-struct Token; // Forward declaration
-struct SourceLocation;
 
+/// Tokens handed out by [lex] are owned by the lexer and stay valid for as
+/// long as the lexer itself is alive. Their lexemes point into the input
+/// rather than copying it, so that has to stay alive (and unchanged) too.
+/// Tokens and the lists of them come out of the memory resource given to
+/// the constructor.
 class Lexer final {
 private:
   std::string_view _input;
   std::size_t _i = 0;
-  SourceLocation *_loc;
-  std::vector<std::string> _diagnostics;
+  SourceLocation _loc;
+  std::pmr::deque<Token> _tokens;
+  Diagnostics _diagnostics;
+  Token *make_token(TokenKind kind, SourceLocation loc,
+                    std::string_view lexeme);
+  void report(DiagnosticCode code, SourceLocation loc, char expected,
+              char actual);
   void eat_whitespace();
   Token *next_token();
   Token *lex_bpm();
@@ -33,12 +46,33 @@ private:
   bool _lexing_identifier = false;
 
 public:
-  Lexer(std::string_view input);
-  std::vector<Token *> lex();
-  std::vector<std::string> diagnostics() const;
+  explicit Lexer(std::string_view input,
+                 std::pmr::memory_resource *memory =
+                     std::pmr::get_default_resource());
+  Lexer(const Lexer &) = delete;
+  Lexer &operator=(const Lexer &) = delete;
+
+  std::pmr::vector<Token *> lex();
+
+  /// Lexes [fragment], a run of whole lines that starts at [from] in some
+  /// larger text, as if it were that text. The tokens, up to and including
+  /// an Eof where the fragment ends, join the ones this lexer already owns.
+  std::pmr::vector<Token *> lex_fragment(std::string_view fragment,
+                                         SourceLocation from);
+
+  /// Forgets every token and diagnostic and starts over on [input].
+  void reset(std::string_view input);
+
+  const Diagnostics &diagnostics() const;
   bool error() const;
 };
 
+/// Whether the '[' at [open] opens a chord rather than a label: up to the
+/// ']' (or the end of the line) it holds nothing but notes, each a letter
+/// A-G, an optional accidental and an octave number, and at least one of
+/// them. "[C4 Eb4 G4]" is a chord, "[START]" and "[PART2]" are labels.
+bool bracket_holds_chord(std::string_view input, std::size_t open);
+
 } // namespace FileReading::Lexer
 
 #endif
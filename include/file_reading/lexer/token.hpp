@@ -3,6 +3,7 @@
 #define TOKEN_HPP
 
 #include <string>
+#include <string_view>
 
 namespace FileReading::Lexer {
 enum class TokenKind : unsigned int {
@@ -34,7 +35,7 @@ struct SourceLocation {
 struct Token {
   TokenKind kind;
   SourceLocation loc;
-  std::string lexeme;
+  std::string_view lexeme; // into the lexed text
 
   std::string to_string() const;
 };
@@ -0,0 +1,23 @@
+#pragma once
+#ifndef DIAGNOSTIC_PRINTER_HPP
+#define DIAGNOSTIC_PRINTER_HPP
+
+#include <ostream>
+#include <string>
+
+namespace FileReading {
+struct Diagnostic;
+class Diagnostics;
+
+namespace Logging {
+/// One JSON object per line: code, line, col, offset, the expected and
+/// actual character or token kind where the code has them, and the message.
+/// Dropped diagnostics show up as a last {"code":"more_errors","count":N}.
+std::string diagnostic_to_json(const Diagnostic &diagnostic);
+
+void log_diagnostics(const Diagnostics &diagnostics, bool json,
+                     std::ostream &out);
+} // namespace Logging
+} // namespace FileReading
+
+#endif
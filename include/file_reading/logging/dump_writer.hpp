@@ -0,0 +1,88 @@
+#pragma once
+#ifndef DUMP_WRITER_HPP
+#define DUMP_WRITER_HPP
+
+#include <charconv>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+
+#include "io/fd_writer.hpp"
+
+namespace FileReading::Logging {
+
+/// How -l and -p print what they found.
+enum class DumpFormat {
+  Text,   // the human readable listing
+  Jsonl,  // one JSON object per token or top level node
+  Binary, // compact records, see [dump_tokens] and [dump_nodes]
+};
+
+std::optional<DumpFormat> parse_dump_format(std::string_view name);
+
+/// Formats a dump straight into big output blocks and hands each one to the
+/// descriptor once it's full, so printing a large score costs a write(2) per
+/// [kBlockBytes] rather than one per line. Numbers go through to_chars.
+///
+/// Nothing is sent until the block fills up or [flush] is called, and
+/// destroying the writer doesn't flush, since writing can fail.
+class DumpWriter {
+public:
+  static constexpr std::size_t kBlockBytes = 1 << 20;
+
+private:
+  Io::FdWriter _out;
+  std::span<std::uint8_t> _block;
+  std::size_t _used = 0;
+
+  void send();
+
+  /// Room for [bytes] more, which must be no more than a block.
+  void reserve(std::size_t bytes) {
+    if (_block.size() - _used < bytes)
+      send();
+  }
+
+public:
+  explicit DumpWriter(int fd);
+  DumpWriter(const DumpWriter &) = delete;
+  DumpWriter &operator=(const DumpWriter &) = delete;
+
+  void put(char c) {
+    reserve(1);
+    _block[_used++] = static_cast<std::uint8_t>(c);
+  }
+
+  void put(std::string_view s);
+
+  /// [count] spaces.
+  void pad(std::size_t count);
+
+  template <std::integral T> void put_number(T value) {
+    // Enough for any 64 bit value with its sign
+    reserve(24);
+    auto *at = reinterpret_cast<char *>(_block.data() + _used);
+    _used += static_cast<std::size_t>(std::to_chars(at, at + 24, value).ptr -
+                                      at);
+  }
+
+  /// [s] as a quoted JSON string.
+  void put_json(std::string_view s);
+
+  /// [value] as sizeof(T) little endian bytes.
+  template <std::unsigned_integral T> void put_le(T value) {
+    reserve(sizeof(T));
+    for (std::size_t b = 0; b < sizeof(T); ++b)
+      _block[_used++] = static_cast<std::uint8_t>(value >> (8 * b));
+  }
+
+  /// Sends whatever hasn't been yet.
+  void flush();
+};
+
+} // namespace FileReading::Logging
+
+#endif
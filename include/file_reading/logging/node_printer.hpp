@@ -2,28 +2,35 @@
 #ifndef NODE_PRINTER_HPP
 #define NODE_PRINTER_HPP
 
-#include <string>
-#include <vector>
+#include <span>
+
+#include "file_reading/logging/dump_writer.hpp"
 
 namespace FileReading {
 namespace Parser {
 class Node;
-class BpmNode;
-class LabelNode;
-class DurationNode;
-class NoteNode;
-class NoteInfoNode;
 } // namespace Parser
 
 namespace Logging {
-void log_node(Parser::Node *node, std::string pad = "");
-void log_nodes(std::vector<Parser::Node *> nodes);
-void log_label(Parser::LabelNode *node, std::string pad = "");
-void log_duration(Parser::DurationNode *node, std::string pad = "");
-void log_note(Parser::NoteNode *node, std::string pad = "");
-void log_note_info(Parser::NoteInfoNode *node, std::string pad = "");
-void log_bpm(Parser::BpmNode *node, std::string pad = "");
-void log_error(std::string pad = "");
+/// Writes the top level [nodes] of a parse to [out] and flushes it.
+///
+/// Text is the node count, then each node as an indented tree. JSON lines
+/// have one object per top level node, with its children nested under
+/// "notes" and "duration". Binary is "MGN1", u32 node count, then each node
+/// as (integers little endian):
+///   u8  kind     Parser::NodeKind
+///   u32 line     of its token, 0 if it has none
+///   u32 col
+/// followed by, for
+///   Bpm_Decl   u32 bpm, then its Duration node
+///   Note_Info  u8 flags (1 chord, 2 rest), u32 note count, the Note nodes,
+///              then its Duration node
+///   Note       u8 letter ('A' to 'G'), u8 Parser::Accidental, u32 octave
+///   Duration   u8 Parser::DurationKind, u8 dotted
+///   Label      u32 length, then the label's bytes
+/// and nothing for the other kinds.
+void dump_nodes(std::span<Parser::Node *const> nodes, DumpFormat format,
+                DumpWriter &out);
 } // namespace Logging
 } // namespace FileReading
 
@@ -2,7 +2,10 @@
 #ifndef TOKEN_PRINTER_HPP
 #define TOKEN_PRINTER_HPP
 
-#include <vector>
+#include <span>
+#include <string_view>
+
+#include "file_reading/logging/dump_writer.hpp"
 
 namespace FileReading {
 namespace Lexer {
@@ -10,8 +13,20 @@ struct Token;
 }
 
 namespace Logging {
-void log_tokens(std::vector<Lexer::Token *> tokens);
-}
+/// Writes [tokens], lexed from [source], to [out] and flushes it.
+///
+/// Text is a line per token, "[KIND] 'lexeme' (line, col)". JSON lines have
+/// kind, lexeme, line, col and byte offset. Binary is "MGT1", then per token
+/// (integers little endian):
+///   u8  kind     Lexer::TokenKind
+///   u32 line
+///   u32 col
+///   u64 offset   of the lexeme in [source]
+///   u32 length
+///   ... the lexeme's bytes
+void dump_tokens(std::span<Lexer::Token *const> tokens,
+                 std::string_view source, DumpFormat format, DumpWriter &out);
+} // namespace Logging
 } // namespace FileReading
 
 #endif
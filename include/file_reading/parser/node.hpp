@@ -2,6 +2,8 @@
 #ifndef NODE_HPP
 #define NODE_HPP
 
+#include <cstddef>
+#include <span>
 #include <string>
 #include <vector>
 
@@ -27,6 +29,7 @@ protected:
 
 public:
   Node(Lexer::Token *token);
+  virtual ~Node() = default;
 
   virtual NodeKind kind() const = 0;
 
@@ -86,19 +89,29 @@ public:
   unsigned int octave() const;
 };
 
+/// A note, a rest or a chord, together with how long it lasts.
 class NoteInfoNode : public Node {
 private:
-  NoteNode *_note;
+  std::vector<NoteNode *> _notes;
   DurationNode *_duration;
   bool _is_rest;
+  bool _is_chord = false;
 
 public:
   NoteInfoNode(Lexer::Token *token, NoteNode *note, DurationNode *duration);
+  NoteInfoNode(Lexer::Token *token, std::vector<NoteNode *> chord,
+               DurationNode *duration);
 
   NodeKind kind() const override;
 
+  /// The note for a single note, the lowest written one for a chord.
   NoteNode *note() const;
 
+  /// Every note sounding at once: one for a single note, none for a rest.
+  std::span<NoteNode *const> notes() const;
+
+  bool is_chord() const;
+
   DurationNode *duration() const;
 
   bool is_rest() const;
@@ -123,12 +136,12 @@ class SongNode : public Node {
 private:
   BpmNode *_bpm;
   LabelNode *_start;
-  std::vector<NoteInfoNode *> _notes;
+  std::vector<std::vector<NoteInfoNode *>> _voices;
   LabelNode *_end;
 
 public:
   SongNode(Lexer::Token *token, BpmNode *bpm, LabelNode *start,
-           std::vector<NoteInfoNode *> notes, LabelNode *end);
+           std::vector<std::vector<NoteInfoNode *>> voices, LabelNode *end);
 
   NodeKind kind() const override;
 
@@ -136,7 +149,15 @@ public:
 
   LabelNode *start() const;
 
-  std::vector<NoteInfoNode *> notes() const;
+  /// Notes of the first voice.
+  std::span<NoteInfoNode *const> notes() const;
+
+  /// Every [START] block is a voice of its own; they all play at once.
+  std::span<const std::vector<NoteInfoNode *>> voices() const;
+
+  /// Replaces [count] notes of [voice], from the [first], with [notes].
+  void splice_notes(std::size_t voice, std::size_t first, std::size_t count,
+                    const std::vector<NoteInfoNode *> &notes);
 
   LabelNode *end() const;
 };
@@ -2,15 +2,17 @@
 #ifndef PARSER_HPP
 #define PARSER_HPP
 
+#include <cstddef>
+#include <memory_resource>
+#include <optional>
+#include <span>
 #include <string_view>
 #include <vector>
 
+#include "file_reading/diagnostic.hpp"
+#include "file_reading/lexer/lexer.hpp"
+
 namespace FileReading {
-namespace Lexer {
-struct Token;
-struct SourceLocation;
-enum class TokenKind : unsigned int;
-} // namespace Lexer
 namespace Parser {
 class Node;
 class SongNode;
@@ -21,36 +23,81 @@ class DurationNode;
 class NoteNode;
 class NoteInfoNode;
 
+/// Nodes (and the tokens they point at) referenced by a [ParseResult] are
+/// owned by the [Parser] that produced it, so the parser has to outlive the
+/// result, and [nodes] is only good for as long as the result is.
 class ParseResult {
 private:
   SongNode *_song_node;
   std::vector<Node *> _nodes;
-  std::vector<std::string> _diagnostics;
+  Diagnostics _diagnostics;
 
 public:
-  ParseResult(SongNode *song, std::vector<Node *> nodes,
-              std::vector<std::string> diag);
+  ParseResult(SongNode *song, std::vector<Node *> nodes, Diagnostics diag);
 
   SongNode *song() const;
 
-  std::vector<Node *> nodes() const;
+  std::span<Node *const> nodes() const;
 
-  std::vector<std::string> diagnostics() const;
+  const Diagnostics &diagnostics() const;
 
   bool error() const;
 };
 
+/// A change to a text: [removed] bytes at [offset] replaced by [inserted].
+struct TextEdit {
+  std::size_t offset = 0;
+  std::size_t removed = 0;
+  std::string_view inserted;
+};
+
+/// The single edit turning [before] into [after], found from their common
+/// prefix and suffix. [inserted] points into [after].
+TextEdit diff_text(std::string_view before, std::string_view after);
+
 class Parser {
 private:
   std::string_view _contents;
-  std::vector<Lexer::Token *> _tokens;
+  Lexer::Lexer _lexer;
+  std::pmr::vector<Lexer::Token *> _tokens;
+  // Nodes are allocated from the parser's memory resource, and each is kept
+  // with the function that destroys it as what it really is
+  using NodeDeleter = void (*)(std::pmr::polymorphic_allocator<> &, Node *);
+  std::pmr::polymorphic_allocator<> _memory;
+  std::pmr::vector<std::pair<Node *, NodeDeleter>> _owned_nodes;
   std::size_t _idx = 0;
 
-  std::vector<std::string> _diagnostics;
+  Diagnostics _diagnostics;
+
+  // What [reparse] needs of the last parse: the top level nodes in order and
+  // the index of each one's first token, the song, and where lines start
+  std::vector<Node *> _top;
+  std::vector<std::size_t> _top_begin;
+  SongNode *_song = nullptr;
+  std::vector<std::size_t> _line_starts;
+  std::size_t _dead_tokens = 0; // replaced by reparses, still owned
+  bool _spliced = false;
+
+  void index_lines();
+  Node *parse_top(Node *(Parser::*parse)());
+  std::optional<ParseResult> splice(std::string_view contents,
+                                    const TextEdit &edit);
 
   FileReading::Lexer::Token *_peek() const;
   FileReading::Lexer::Token *_next();
 
+  template <typename T, typename... Args> T *make_node(Args &&...args) {
+    // The slot comes first, so a node is never left without an owner
+    auto &owned = _owned_nodes.emplace_back(
+        nullptr, [](std::pmr::polymorphic_allocator<> &memory, Node *node) {
+          memory.delete_object(static_cast<T *>(node));
+        });
+    auto *node = _memory.new_object<T>(std::forward<Args>(args)...);
+    owned.first = node;
+    return node;
+  }
+  void free_nodes();
+
   Node *parse_node();
   Node *parse_label_node();
   Node *parse_bpm_node();
@@ -58,22 +105,52 @@ private:
   Node *parse_duration_node();
   Node *parse_note_node();
   Node *parse_note_info_node();
-
-  bool match(FileReading::Lexer::Token *token,
-             FileReading::Lexer::TokenKind expected);
-  bool match_and_flag(FileReading::Lexer::Token *token,
-                      FileReading::Lexer::Token *&err_tok,
-                      FileReading::Lexer::TokenKind expected);
-  void report_error(std::string message,
-                    FileReading::Lexer::SourceLocation loc);
-  void report_unexpected_token(FileReading::Lexer::TokenKind expected,
-                               FileReading::Lexer::TokenKind actual,
-                               FileReading::Lexer::SourceLocation loc);
+  Node *parse_chord_node();
+
+  // Takes the next token if it is a [kind], otherwise reports it and leaves
+  // it for [synchronize] to deal with
+  FileReading::Lexer::Token *expect(FileReading::Lexer::TokenKind kind);
+  Node *error_node();
+  static bool starts_node(FileReading::Lexer::TokenKind kind);
+  void synchronize();
+  void report(DiagnosticCode code, const FileReading::Lexer::Token *token,
+              FileReading::Lexer::TokenKind expected = {},
+              FileReading::Lexer::TokenKind actual = {});
 
 public:
-  Parser(std::string_view contents);
-
-  ParseResult *parse();
+  /// Tokens, nodes and the lists of them are allocated from [memory], which
+  /// has to outlive the parser.
+  explicit Parser(std::string_view contents,
+                  std::pmr::memory_resource *memory =
+                      std::pmr::get_default_resource());
+  ~Parser();
+  Parser(const Parser &) = delete;
+  Parser &operator=(const Parser &) = delete;
+
+  /// Parses the whole text in one pass, errors and all. After an error the
+  /// parser skips to the next note, chord, label or line, so every mistake
+  /// is reported once without hiding the ones after it; the result then
+  /// holds the lexer's and the parser's diagnostics in source order.
+  ParseResult parse();
+
+  /// Parses [contents], the text this parser last parsed with [edit]
+  /// applied, giving the same result [parse] would on a fresh parser.
+  ///
+  /// Notes never reach across lines, so when the lines the edit touches held
+  /// nothing but notes, and still do, only those lines are lexed and parsed
+  /// again and their tokens and nodes are spliced in place of the old ones;
+  /// everything after them just has its line numbers shifted. Anything else
+  /// (a label, the BPM line, an error, a chord split over lines) parses the
+  /// whole text again, as does a parser whose replaced tokens have come to
+  /// outnumber the live ones, which bounds what a long editing session holds
+  /// on to. Results returned before are no longer valid afterwards.
+  ///
+  /// Tokens kept from the last parse are moved over to [contents], but the
+  /// text they were lexed from has to still be alive while this runs.
+  ParseResult reparse(std::string_view contents, const TextEdit &edit);
+
+  /// True if the last [reparse] got away with splicing.
+  bool spliced() const;
 };
 
 } // namespace Parser
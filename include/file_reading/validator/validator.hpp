@@ -0,0 +1,25 @@
+#pragma once
+#ifndef VALIDATOR_HPP
+#define VALIDATOR_HPP
+
+#include <cstddef>
+#include <string_view>
+
+#include "file_reading/diagnostic.hpp"
+
+namespace FileReading::Validator {
+
+/// Checks [input] against the score grammar without lexing it into tokens or
+/// building nodes: the grammar is compiled into a table indexed by parser
+/// state and byte class, and the input is run through it two bytes at a
+/// time. Only labels, "BPM" and errors leave the table for hand-written code.
+///
+/// A score passes exactly when [Parser::parse] would parse it without
+/// errors, and the first error reported is the one [parse] reports first.
+/// After an error the check carries on from the next line, so later errors
+/// are only a guide, and it stops once [max_errors] have been found.
+Diagnostics validate(std::string_view input, std::size_t max_errors);
+
+} // namespace FileReading::Validator
+
+#endif
@@ -0,0 +1,64 @@
+#pragma once
+#ifndef FD_WRITER_HPP
+#define FD_WRITER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace Io {
+
+/// Streams blocks of bytes to a file descriptor one buffer at a time, so
+/// memory use doesn't depend on how much gets written.
+///
+/// Callers [acquire] a buffer, fill it in place and [commit] it. When the
+/// descriptor is a pipe on Linux the committed pages are vmsplice'd into the
+/// pipe instead of copied. The pipe then holds on to those very pages, and
+/// the reader sees what they contain whenever it gets to them, which may be
+/// long after if it tees or splices them on instead of reading. So a spliced
+/// buffer is never written again: it is unmapped right away, leaving its
+/// pages to the pipe alone, and the next block gets freshly mapped ones.
+/// Anything else falls back to plain write(2) from the same buffer.
+///
+/// Writes block while the reader is slow, which is how backpressure reaches
+/// the renderer.
+class FdWriter {
+private:
+  int _fd;
+  bool _splice = false;
+  std::size_t _block_bytes;
+  std::uint8_t *_buffer = nullptr;
+  std::uint64_t _written = 0;
+
+  void map_buffer();
+
+  void write_fully(const std::uint8_t *data, std::size_t n);
+  bool splice_fully(const std::uint8_t *data, std::size_t n);
+  void wait_writable();
+
+public:
+  FdWriter(int fd, std::size_t block_bytes = 1 << 16);
+  ~FdWriter();
+  FdWriter(const FdWriter &) = delete;
+  FdWriter &operator=(const FdWriter &) = delete;
+
+  /// Next free buffer, `block_bytes()` long.
+  std::span<std::uint8_t> acquire();
+
+  /// Sends the first [bytes] bytes of the buffer last returned by [acquire].
+  void commit(std::size_t bytes);
+
+  /// Copies [data] out with plain write(2), for small things like headers.
+  void write(std::span<const std::uint8_t> data);
+
+  std::size_t block_bytes() const;
+
+  /// True if committed blocks are being spliced rather than copied.
+  bool zero_copy() const;
+
+  std::uint64_t bytes_written() const;
+};
+
+} // namespace Io
+
+#endif
@@ -0,0 +1,42 @@
+#pragma once
+#ifndef FILE_WATCHER_HPP
+#define FILE_WATCHER_HPP
+
+#include <chrono>
+#include <filesystem>
+#include <string>
+
+namespace Io {
+
+/// Waits for a file to be saved.
+///
+/// On Linux this is inotify on the file's directory rather than on the file,
+/// so editors that save by renaming a fresh copy over the old one are seen
+/// too. Elsewhere the modification time is polled. Saves rarely come alone
+/// (an editor may truncate, write and rename, a formatter may run after it),
+/// so [wait] only returns once the file has been left alone for [kDebounce].
+class FileWatcher {
+public:
+  static constexpr std::chrono::milliseconds kDebounce{20};
+
+private:
+  std::filesystem::path _path;
+  std::string _name;
+  int _fd = -1; // inotify instance, -1 when polling
+  std::filesystem::file_time_type _mtime;
+
+  bool wait_for_event(int timeout_ms);
+
+public:
+  explicit FileWatcher(std::filesystem::path path);
+  ~FileWatcher();
+  FileWatcher(const FileWatcher &) = delete;
+  FileWatcher &operator=(const FileWatcher &) = delete;
+
+  /// Blocks until the file has been written, then settled.
+  void wait();
+};
+
+} // namespace Io
+
+#endif
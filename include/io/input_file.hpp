@@ -0,0 +1,45 @@
+#pragma once
+#ifndef INPUT_FILE_HPP
+#define INPUT_FILE_HPP
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace Io {
+
+/// The whole of an input file as one read-only [text], for the lexer to scan
+/// in place.
+///
+/// Regular files are mapped rather than read, so the text is never copied:
+/// pages come in as the lexer gets to them, and MADV_SEQUENTIAL lets the
+/// kernel read ahead and drop what's behind. Pipes, stdin ("-"), empty files
+/// and systems without mmap are read into a buffer instead.
+///
+/// A mapped file that gets truncated while it's being read faults, so this is
+/// for one-shot reads; anything watching a file while an editor writes to it
+/// wants [read_file].
+class InputFile {
+private:
+  std::string _buffer;
+  const char *_map = nullptr;
+  std::size_t _size = 0;
+
+public:
+  explicit InputFile(const std::string &path);
+  ~InputFile();
+  InputFile(const InputFile &) = delete;
+  InputFile &operator=(const InputFile &) = delete;
+
+  std::string_view text() const;
+
+  /// True if [text] is a mapping of the file rather than a copy.
+  bool mapped() const;
+};
+
+/// Copies all of [path] ("-" for stdin) into a string with plain reads.
+std::string read_file(const std::string &path);
+
+} // namespace Io
+
+#endif
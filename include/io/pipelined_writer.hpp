@@ -0,0 +1,94 @@
+#pragma once
+#ifndef PIPELINED_WRITER_HPP
+#define PIPELINED_WRITER_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include "io/spsc_queue.hpp"
+
+namespace Io {
+class Uring;
+
+/// Writes blocks to a file on a dedicated I/O thread, so rendering block N+1
+/// overlaps with writing block N.
+///
+/// A small pool of buffers circulates between the two threads over a pair of
+/// lock-free single-producer/single-consumer queues: the caller [acquire]s a
+/// free buffer, fills it and [commit]s it; the I/O thread writes it and hands
+/// it back. Wall time approaches max(render, write) instead of their sum.
+///
+/// Writes go through io_uring where the kernel allows it, which lets the I/O
+/// thread submit every block it has in one go; otherwise they're plain
+/// pwrite(2) calls. Descriptors that can't seek fall back to write(2).
+///
+/// Not thread-safe: all calls must come from the one producing thread.
+class PipelinedWriter {
+private:
+  static constexpr std::size_t kBuffers = 4;
+  static constexpr std::uint32_t kEnd = ~std::uint32_t{0};
+
+  struct Block {
+    std::uint32_t index = kEnd; // buffer in the pool, kEnd marks the end
+    std::uint32_t bytes = 0;
+  };
+
+  int _fd;
+  std::size_t _block_bytes;
+  std::vector<std::vector<std::uint8_t>> _pool;
+  SpscQueue<Block, kBuffers> _full;         // producer -> I/O thread
+  SpscQueue<std::uint32_t, kBuffers> _free; // I/O thread -> producer
+  std::uint32_t _current = kEnd;            // buffer handed out by acquire
+
+  std::unique_ptr<Uring> _uring;
+  bool _seekable = true;
+  std::uint64_t _offset = 0; // only touched by the I/O thread
+  std::uint64_t _written = 0;
+
+  std::thread _io;
+  std::exception_ptr _error;
+  std::atomic<bool> _failed{false};
+  bool _finished = false;
+
+  void io_loop();
+  void write_batch(const std::vector<Block> &batch);
+  void submit_batch(const std::vector<Block> &batch);
+  void write_at(const std::uint8_t *data, std::size_t n, std::uint64_t offset);
+  void rethrow_if_failed();
+
+public:
+  enum class Backend { Auto, Pwrite };
+
+  PipelinedWriter(int fd, std::size_t block_bytes = 1 << 18,
+                  Backend backend = Backend::Auto);
+  ~PipelinedWriter();
+  PipelinedWriter(const PipelinedWriter &) = delete;
+  PipelinedWriter &operator=(const PipelinedWriter &) = delete;
+
+  /// Next free buffer, waiting for the I/O thread to return one if needed.
+  std::span<std::uint8_t> acquire();
+
+  /// Queues the first [bytes] bytes of the buffer from [acquire].
+  void commit(std::size_t bytes);
+
+  /// Copies [data] in through the pool.
+  void write(std::span<const std::uint8_t> data);
+
+  /// Waits for every queued block to hit the file and stops the I/O thread.
+  /// Rethrows whatever error the I/O thread ran into.
+  void finish();
+
+  bool uses_io_uring() const;
+
+  std::uint64_t bytes_written() const;
+};
+
+} // namespace Io
+
+#endif
@@ -0,0 +1,73 @@
+#pragma once
+#ifndef SPSC_QUEUE_HPP
+#define SPSC_QUEUE_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace Io {
+
+/// Bounded lock-free queue for exactly one producer and one consumer thread.
+///
+/// [push] and [pop] never block; [wait_push] and [wait_pop] park the calling
+/// thread on the queue's indices (C++20 atomic wait) until the other side
+/// makes progress, so neither side spins while the other is busy.
+template <typename T, std::size_t Capacity> class SpscQueue {
+  static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+                "Capacity must be a power of two");
+
+private:
+  std::array<T, Capacity> _slots{};
+  // Kept on separate cache lines so producer and consumer don't false-share.
+  alignas(64) std::atomic<std::size_t> _head{0}; // next slot to pop
+  alignas(64) std::atomic<std::size_t> _tail{0}; // next slot to push
+
+public:
+  bool push(const T &value) {
+    const auto tail = _tail.load(std::memory_order_relaxed);
+    if (tail - _head.load(std::memory_order_acquire) == Capacity)
+      return false;
+    _slots[tail & (Capacity - 1)] = value;
+    _tail.store(tail + 1, std::memory_order_release);
+    _tail.notify_one();
+    return true;
+  }
+
+  bool pop(T &value) {
+    const auto head = _head.load(std::memory_order_relaxed);
+    if (head == _tail.load(std::memory_order_acquire))
+      return false;
+    value = _slots[head & (Capacity - 1)];
+    _head.store(head + 1, std::memory_order_release);
+    _head.notify_one();
+    return true;
+  }
+
+  void wait_push(const T &value) {
+    while (!push(value)) {
+      const auto head = _head.load(std::memory_order_acquire);
+      if (_tail.load(std::memory_order_relaxed) - head == Capacity)
+        _head.wait(head, std::memory_order_acquire);
+    }
+  }
+
+  T wait_pop() {
+    T value{};
+    while (!pop(value)) {
+      const auto tail = _tail.load(std::memory_order_acquire);
+      if (_head.load(std::memory_order_relaxed) == tail)
+        _tail.wait(tail, std::memory_order_acquire);
+    }
+    return value;
+  }
+
+  bool empty() const {
+    return _head.load(std::memory_order_acquire) ==
+           _tail.load(std::memory_order_acquire);
+  }
+};
+
+} // namespace Io
+
+#endif
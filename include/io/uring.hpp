@@ -0,0 +1,46 @@
+#pragma once
+#ifndef URING_HPP
+#define URING_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace Io {
+
+/// Minimal io_uring instance driven through the raw syscalls (no liburing),
+/// only able to queue writes. Linux only; [create] returns null anywhere the
+/// kernel (or a seccomp policy) doesn't let us set one up.
+class Uring {
+private:
+  struct Rings;
+  std::unique_ptr<Rings> _rings;
+  unsigned int _to_submit = 0;
+
+  Uring(std::unique_ptr<Rings> rings);
+
+public:
+  static std::unique_ptr<Uring> create(unsigned int entries);
+  ~Uring();
+  Uring(const Uring &) = delete;
+  Uring &operator=(const Uring &) = delete;
+
+  /// Number of submissions that can be queued at once.
+  unsigned int capacity() const;
+
+  /// Queues a write of [len] bytes at file offset [offset]. Returns false if
+  /// the submission queue is full.
+  bool queue_write(int fd, const void *buf, std::uint32_t len,
+                   std::uint64_t offset, std::uint64_t user_data);
+
+  /// Hands everything queued to the kernel and waits for at least [wait_nr]
+  /// completions.
+  void submit_and_wait(unsigned int wait_nr);
+
+  /// Pops one completion; [result] is the syscall-style return value.
+  bool next_completion(std::uint64_t &user_data, std::int32_t &result);
+};
+
+} // namespace Io
+
+#endif
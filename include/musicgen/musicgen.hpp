@@ -0,0 +1,122 @@
+#pragma once
+#ifndef MUSICGEN_HPP
+#define MUSICGEN_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "audio/biquad.hpp"
+#include "audio/envelope.hpp"
+#include "audio/limiter.hpp"
+#include "audio/note_info.hpp"
+#include "audio/pcm_format.hpp"
+#include "audio/quantizer.hpp"
+#include "audio/resampler.hpp"
+#include "audio/reverb.hpp"
+#include "audio/timbre.hpp"
+
+/// Embeddable entry point to the renderer.
+///
+/// Everything in here works purely in memory: nothing is read from or written
+/// to disk, nothing is printed, and every call owns all of its state, so
+/// several songs can be rendered concurrently from different threads.
+namespace Audio {
+class MixRenderer;
+}
+
+namespace MusicGen {
+
+struct RenderOptions {
+  double amplitude = 0.25;
+  Audio::Adsr envelope = Audio::fade_envelope(0.005);
+  Audio::Timbre timbre = Audio::Timbre::Sine;
+  unsigned int threads = 1; // threads rendering voices, 0 => one per core
+  std::vector<Audio::BiquadSettings> eq; // applied in order, before reverb
+  std::optional<Audio::ReverbSettings> reverb;
+  /// Target RMS level in dBFS. Replaces [amplitude] with one estimated from
+  /// the notes, see [Audio::normalized_amplitude], and turns the limiter on.
+  std::optional<double> loudness_db;
+  std::optional<Audio::LimiterSettings> limiter; // last in the effect chain
+  std::uint32_t sample_rate = Audio::kSampleRate; // of the output
+  Audio::ResampleQuality resample_quality = Audio::ResampleQuality::Standard;
+  Audio::Dither dither = Audio::Dither::None; // for the final conversion
+  std::size_t block_samples = 4096; // samples handed to the callback at once
+};
+
+enum class Status : unsigned int {
+  Ok,
+  ParseError,     // the score didn't parse, see [RenderResult::diagnostics]
+  BufferTooSmall, // the caller's buffer couldn't hold the whole song
+};
+
+struct RenderResult {
+  Status status = Status::Ok;
+  /// Samples the whole song renders to. For [Status::BufferTooSmall] this is
+  /// the buffer size that would have been needed.
+  std::uint64_t samples = 0;
+  std::vector<std::string> diagnostics;
+  std::vector<std::string> warnings;
+
+  bool ok() const { return status == Status::Ok; }
+};
+
+/// Receives the rendered song in order, one block at a time.
+using BlockCallback = std::function<void(std::span<const std::int16_t>)>;
+
+/// Receives each warning as it comes up, see [RenderContext].
+using WarningCallback = std::function<void(std::string_view)>;
+
+/// Renders score text, handing the samples to [on_block] as they're produced.
+RenderResult render(std::string_view score, const RenderOptions &options,
+                    const BlockCallback &on_block);
+
+/// Renders score text into [out]. If [out] is too small nothing past its end
+/// is touched and [Status::BufferTooSmall] is returned.
+RenderResult render(std::string_view score, const RenderOptions &options,
+                    std::span<std::int16_t> out);
+
+/// Same as the score overload, for callers that already have a note table.
+RenderResult render_notes(std::span<const Audio::NoteInfo> notes,
+                          const RenderOptions &options,
+                          const BlockCallback &on_block);
+
+RenderResult render_notes(std::span<const Audio::NoteInfo> notes,
+                          const RenderOptions &options,
+                          std::span<std::int16_t> out);
+
+/// Same as the score overload, for callers that already have the voices.
+/// Several voices get mixed and soft limited, see [Audio::MixRenderer].
+RenderResult render_voices(std::span<const Audio::Voice> voices,
+                           const RenderOptions &options,
+                           const BlockCallback &on_block);
+
+RenderResult render_voices(std::span<const Audio::Voice> voices,
+                           const RenderOptions &options,
+                           std::span<std::int16_t> out);
+
+/// Renderer for [voices] with every part of [options] that affects the
+/// sound applied, for callers driving the rendering themselves. Include
+/// audio/mix_renderer.hpp to use it.
+std::unique_ptr<Audio::MixRenderer>
+make_renderer(std::span<const Audio::Voice> voices,
+              const RenderOptions &options);
+
+/// Parses score text into the voices the render functions consume.
+RenderResult parse_voices(std::string_view score,
+                          std::vector<Audio::Voice> &voices);
+
+/// Parses score text into a single note table. Only the first voice is kept,
+/// with a warning if the score has more.
+RenderResult parse_notes(std::string_view score,
+                         std::vector<Audio::NoteInfo> &notes);
+
+} // namespace MusicGen
+
+#endif
@@ -0,0 +1,76 @@
+#pragma once
+#ifndef RENDER_CONTEXT_HPP
+#define RENDER_CONTEXT_HPP
+
+#include <cstdint>
+#include <memory_resource>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "audio/note_info.hpp"
+#include "file_reading/diagnostic.hpp"
+#include "file_reading/parser/parser.hpp"
+#include "musicgen/musicgen.hpp"
+
+namespace MusicGen {
+
+/// One song on its way from text to samples, holding everything that takes:
+/// its own copy of the text, the tokens and nodes parsed from it (allocated
+/// from an arena that goes away with the context), and the voices they turn
+/// into. Contexts share nothing, so any number of them can run at once, one
+/// thread each; a single context isn't meant for two threads at a time.
+///
+/// Nothing is printed. Warnings go to the callback given to the constructor
+/// as well as into the [RenderResult].
+class RenderContext {
+private:
+  std::pmr::monotonic_buffer_resource _arena;
+  std::pmr::string _score;
+  WarningCallback _on_warning;
+  std::optional<FileReading::Parser::Parser> _parser;
+  std::optional<FileReading::Parser::ParseResult> _parsed;
+  std::vector<Audio::Voice> _voices;
+  std::vector<std::string> _warnings; // from parsing
+
+  void warn(std::string_view warning) const;
+  template <typename Sink>
+  RenderResult render_to(const RenderOptions &options, Sink &&sink);
+
+public:
+  explicit RenderContext(std::string_view score,
+                         WarningCallback on_warning = {});
+  RenderContext(const RenderContext &) = delete;
+  RenderContext &operator=(const RenderContext &) = delete;
+
+  /// Parses the score and works out its voices, the first time it's called.
+  /// False if the score has errors, see [diagnostics].
+  bool parse();
+
+  /// Empty until [parse] has run.
+  const FileReading::Diagnostics &diagnostics() const;
+
+  /// The top level nodes of the parse, empty until [parse] has run.
+  std::span<FileReading::Parser::Node *const> nodes() const;
+
+  /// Empty until [parse] has run, and if the score had errors.
+  std::span<const Audio::Voice> voices() const;
+
+  /// What [parse] warned about. Each render's own warnings only go to the
+  /// callback and its result.
+  std::span<const std::string> warnings() const;
+
+  /// Parses the score if that hasn't happened yet and renders it, like
+  /// [MusicGen::render].
+  RenderResult render(const RenderOptions &options,
+                      const BlockCallback &on_block);
+
+  RenderResult render(const RenderOptions &options,
+                      std::span<std::int16_t> out);
+};
+
+} // namespace MusicGen
+
+#endif
@@ -0,0 +1,64 @@
+#pragma once
+#ifndef PROTOCOL_HPP
+#define PROTOCOL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <sys/un.h>
+
+/// Wire format spoken over the render socket. All integers are little-endian.
+///
+/// Request:
+///   u8  format   [OutputFormat]
+///   u32 length   number of score bytes that follow
+///   ... score text
+///
+/// Response:
+///   u8  status   [ResponseStatus]
+///   u64 length   number of payload bytes that follow
+///   ... payload  audio for [ResponseStatus::Ok], diagnostics text otherwise
+///
+/// A connection can carry any number of requests back to back; the client
+/// closes it when it's done.
+namespace Server {
+
+enum class OutputFormat : std::uint8_t { RawPcm16 = 0, Wav = 1 };
+
+enum class ResponseStatus : std::uint8_t {
+  Ok = 0,
+  ParseError = 1,
+  BadRequest = 2,
+};
+
+inline constexpr std::size_t kRequestHeaderBytes = 5;
+inline constexpr std::size_t kResponseHeaderBytes = 9;
+
+/// Scores bigger than this are rejected instead of being read into memory.
+inline constexpr std::uint32_t kMaxScoreBytes = 64u << 20;
+
+sockaddr_un make_address(const std::string &path);
+
+/// Reads exactly `buf.size()` bytes. Returns false if the peer closed the
+/// connection before sending anything, throws if it closed halfway through.
+bool read_exact(int fd, std::span<std::uint8_t> buf);
+
+/// Writes all of [buf], throws if the peer went away.
+void write_all(int fd, std::span<const std::uint8_t> buf);
+
+void write_request(int fd, OutputFormat format, std::string_view score);
+
+void write_response_header(int fd, ResponseStatus status,
+                           std::uint64_t length);
+
+/// Writes PCM16 samples as little-endian bytes.
+void write_pcm16(int fd, std::span<const std::int16_t> samples);
+
+std::uint32_t load_u32_le(const std::uint8_t *p);
+std::uint64_t load_u64_le(const std::uint8_t *p);
+
+} // namespace Server
+
+#endif
@@ -0,0 +1,28 @@
+#pragma once
+#ifndef RENDER_CLIENT_HPP
+#define RENDER_CLIENT_HPP
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+
+#include "server/protocol.hpp"
+
+namespace Server {
+
+struct ClientResult {
+  ResponseStatus status = ResponseStatus::Ok;
+  std::uint64_t bytes = 0;  // payload bytes written to the output stream
+  std::string diagnostics; // set when the server rejected the score
+};
+
+/// Sends [score] to the render server at [socket_path] and streams the
+/// rendered audio into [out].
+ClientResult request_render(const std::string &socket_path,
+                            OutputFormat format, std::string_view score,
+                            std::ostream &out);
+
+} // namespace Server
+
+#endif
@@ -0,0 +1,66 @@
+#pragma once
+#ifndef RENDER_SERVER_HPP
+#define RENDER_SERVER_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "musicgen/musicgen.hpp"
+
+namespace Server {
+
+struct ServerOptions {
+  std::string socket_path;
+  unsigned int threads = 0; // 0 => one worker per core
+  MusicGen::RenderOptions render{};
+};
+
+/// Long running render daemon listening on a Unix domain socket.
+///
+/// Accepted connections are queued up for a fixed pool of worker threads.
+/// Each worker keeps its request/note/sample buffers around between requests,
+/// so a warm server only pays for lexing, parsing and synthesis.
+class RenderServer {
+private:
+  struct Worker;
+
+  ServerOptions _options;
+  int _listen_fd = -1;
+  int _wake_fds[2] = {-1, -1}; // [stop] writes, [run] polls the other end
+  std::vector<std::thread> _workers;
+
+  std::mutex _mutex;
+  std::condition_variable _cv;
+  std::deque<int> _pending;
+  std::vector<int> _clients; // being served by a worker right now
+  bool _stopping = false;
+
+  /// Drops the queued clients and cuts off the ones being served, so every
+  /// worker comes back to [worker_loop] and sees [_stopping].
+  void shut_down();
+  void worker_loop();
+  void serve_client(int fd, Worker &worker);
+  bool serve_request(int fd, Worker &worker);
+
+public:
+  RenderServer(ServerOptions options);
+  ~RenderServer();
+  RenderServer(const RenderServer &) = delete;
+  RenderServer &operator=(const RenderServer &) = delete;
+
+  /// Binds the socket and serves clients until [stop] is called, then
+  /// disconnects every client and waits for the workers to finish.
+  void run();
+
+  /// Makes [run] return. It only writes a byte to a pipe, so it can be
+  /// called from another thread or from a signal handler.
+  void stop();
+};
+
+} // namespace Server
+
+#endif
@@ -1,4 +1,4 @@
-#include <iostream>
+#include <algorithm>
 
 #include "adapter/note_info_adapter.hpp"
 #include "adapter/pitch_adapter.hpp"
@@ -25,23 +25,42 @@ double calculate_duration(FileReading::Parser::DurationKind base,
 NoteInfoAdapter::NoteInfoAdapter(FileReading::Parser::SongNode *song)
     : _song(song) {}
 
-std::vector<Audio::NoteInfo *> NoteInfoAdapter::convert() {
+std::vector<Audio::Voice> NoteInfoAdapter::convert() {
+  _warnings.clear();
   auto bpm_node = _song->bpm();
   auto bpm = bpm_node->bpm();
   auto duration = _song->bpm()->duration();
   if (duration->dotted()) {
     // will figure out conversion later
-    std::cout << "Warning: dotted bpms not yet supported" << std::endl;
+    _warnings.push_back("Warning: dotted bpms not yet supported");
   }
-  std::vector<Audio::NoteInfo *> notes{};
-  for (auto note : _song->notes()) {
-    auto hertz = note->is_rest() ? 0 : note_to_hertz(note->note());
-    auto durr = calculate_duration(duration->duration(),
-                                   note->duration()->duration(), bpm);
-    notes.push_back(new Audio::NoteInfo(hertz, durr));
+  std::vector<Audio::Voice> voices{};
+  for (const auto &song_voice : _song->voices()) {
+    std::size_t lines = 1;
+    for (auto note : song_voice)
+      lines = std::max(lines, note->notes().size());
+
+    const auto first = voices.size();
+    voices.resize(first + lines);
+    for (std::size_t line = first; line < voices.size(); ++line)
+      voices[line].reserve(song_voice.size());
+
+    for (auto note : song_voice) {
+      auto durr = calculate_duration(duration->duration(),
+                                     note->duration()->duration(), bpm);
+      const auto chord = note->notes();
+      for (std::size_t line = 0; line < lines; ++line) {
+        auto hertz = line < chord.size() ? note_to_hertz(chord[line]) : 0;
+        voices[first + line].emplace_back(hertz, durr);
+      }
+    }
   }
 
-  return notes;
+  return voices;
+}
+
+std::span<const std::string> NoteInfoAdapter::warnings() const {
+  return _warnings;
 }
 
 } // namespace Adapter
@@ -29,6 +29,20 @@ Args parse_args(int argc, char *argv[]) {
       args.lex_only = true;
     } else if (arg == "-p" || arg == "--parse-only") {
       args.parse_only = true;
+    } else if (arg == "-f" || arg == "--format") {
+      if (i == argc - 1) {
+        throw std::runtime_error("Output format not provided");
+      }
+      std::string_view format{argv[++i]};
+      if (format != "wav" && format != "flac") {
+        throw std::runtime_error("Unknown output format: " +
+                                 std::string(format));
+      }
+      args.format = format;
+    } else if (arg == "--no-pipeline") {
+      args.no_pipeline = true;
+    } else if (arg == "--raw") {
+      args.raw = true;
     } else if (arg == "-a" || arg == "--amplitude") {
       if (i == argc - 1) {
         throw std::runtime_error("amplitude specified but not provided");
@@ -41,6 +55,183 @@ Args parse_args(int argc, char *argv[]) {
         std::cerr << "Couldn't parse amplitude. Defaulting to 0.25"
                   << std::endl;
       }
+    } else if (arg == "--limit") {
+      args.limit = true;
+    } else if (arg == "--normalize") {
+      if (i == argc - 1) {
+        throw std::runtime_error("Loudness not provided");
+      }
+      std::string loudness{argv[++i]};
+      try {
+        args.loudness_db = std::stod(loudness);
+        args.normalize = true;
+      } catch (const std::exception &e) {
+        throw std::runtime_error("Invalid loudness: " + loudness);
+      }
+    } else if (arg == "-t" || arg == "--timbre") {
+      if (i == argc - 1) {
+        throw std::runtime_error("Timbre not provided");
+      }
+      std::string_view name{argv[++i]};
+      const auto timbre = Audio::parse_timbre(name);
+      if (!timbre) {
+        throw std::runtime_error("Unknown timbre: " + std::string(name));
+      }
+      args.timbre = *timbre;
+    } else if (arg == "-e" || arg == "--envelope") {
+      if (i == argc - 1) {
+        throw std::runtime_error("Envelope not provided");
+      }
+      std::string_view spec{argv[++i]};
+      const auto envelope = Audio::parse_envelope(spec);
+      if (!envelope) {
+        throw std::runtime_error("Invalid envelope: " + std::string(spec));
+      }
+      args.envelope = *envelope;
+    } else if (arg == "--eq") {
+      if (i == argc - 1) {
+        throw std::runtime_error("EQ section not provided");
+      }
+      std::string_view spec{argv[++i]};
+      const auto section = Audio::parse_biquad(spec);
+      if (!section) {
+        throw std::runtime_error("Invalid EQ section: " + std::string(spec));
+      }
+      args.eq.push_back(*section);
+    } else if (arg == "--reverb") {
+      if (i == argc - 1) {
+        throw std::runtime_error("Reverb not provided");
+      }
+      args.reverb = std::string_view{argv[++i]};
+    } else if (arg == "--reverb-mix") {
+      if (i == argc - 1) {
+        throw std::runtime_error("reverb mix specified but not provided");
+      }
+      std::string mix{argv[++i]};
+      try {
+        args.reverb_mix = std::stod(mix);
+      } catch (const std::exception &e) {
+        std::cerr << "Couldn't parse reverb mix. Defaulting to 0.3"
+                  << std::endl;
+      }
+    } else if (arg == "-r" || arg == "--rate") {
+      if (i == argc - 1) {
+        throw std::runtime_error("Sample rate not provided");
+      }
+      std::string rate{argv[++i]};
+      try {
+        const auto hz = std::stoul(rate);
+        if (hz < 1'000 || hz > 384'000) {
+          throw std::runtime_error("Sample rate must be 1000-384000Hz");
+        }
+        args.sample_rate = static_cast<std::uint32_t>(hz);
+      } catch (const std::logic_error &e) {
+        throw std::runtime_error("Invalid sample rate: " + rate);
+      }
+    } else if (arg == "--resample-quality") {
+      if (i == argc - 1) {
+        throw std::runtime_error("Resample quality not provided");
+      }
+      std::string_view name{argv[++i]};
+      const auto quality = Audio::parse_resample_quality(name);
+      if (!quality) {
+        throw std::runtime_error("Unknown resample quality: " +
+                                 std::string(name));
+      }
+      args.resample_quality = *quality;
+    } else if (arg == "--bits") {
+      if (i == argc - 1) {
+        throw std::runtime_error("Bit depth not provided");
+      }
+      std::string_view bits{argv[++i]};
+      if (bits != "16" && bits != "24") {
+        throw std::runtime_error("Bit depth must be 16 or 24");
+      }
+      args.bits = bits == "24" ? 24 : 16;
+    } else if (arg == "--dither") {
+      if (i == argc - 1) {
+        throw std::runtime_error("Dither not provided");
+      }
+      std::string_view name{argv[++i]};
+      const auto dither = Audio::parse_dither(name);
+      if (!dither) {
+        throw std::runtime_error("Unknown dither: " + std::string(name));
+      }
+      args.dither = *dither;
+    } else if (arg == "--no-cache") {
+      args.no_cache = true;
+    } else if (arg == "--cache-dir") {
+      if (i == argc - 1) {
+        throw std::runtime_error("Cache directory not provided");
+      }
+      args.cache_dir = std::string_view{argv[++i]};
+    } else if (arg == "--incremental") {
+      args.incremental = true;
+    } else if (arg == "--watch") {
+      args.watch = true;
+    } else if (arg == "--diagnostics") {
+      if (i == argc - 1) {
+        throw std::runtime_error("Diagnostics format not provided");
+      }
+      std::string_view diagnostics{argv[++i]};
+      if (diagnostics != "text" && diagnostics != "jsonl") {
+        throw std::runtime_error("Diagnostics format must be text or jsonl");
+      }
+      args.json_diagnostics = diagnostics == "jsonl";
+    } else if (arg == "--dump-format") {
+      if (i == argc - 1) {
+        throw std::runtime_error("Dump format not provided");
+      }
+      std::string_view name{argv[++i]};
+      const auto format = FileReading::Logging::parse_dump_format(name);
+      if (!format) {
+        throw std::runtime_error("Unknown dump format: " + std::string(name));
+      }
+      args.dump_format = *format;
+    } else if (arg == "--check") {
+      args.check = true;
+    } else if (arg == "--max-errors") {
+      if (i == argc - 1) {
+        throw std::runtime_error("Error limit not provided");
+      }
+      std::string limit{argv[++i]};
+      try {
+        const auto n = std::stoul(limit);
+        if (n == 0) {
+          throw std::runtime_error("Error limit must be at least 1");
+        }
+        args.max_errors = n;
+      } catch (const std::logic_error &e) {
+        throw std::runtime_error("Invalid error limit: " + limit);
+      }
+    } else if (arg == "--wavetable-cache") {
+      if (i == argc - 1) {
+        throw std::runtime_error("Wavetable cache path not provided");
+      }
+      args.wavetable_cache = std::string_view{argv[++i]};
+    } else if (arg == "--serve") {
+      if (i == argc - 1) {
+        throw std::runtime_error("Socket path not provided");
+      }
+      args.serve_socket = std::string_view{argv[++i]};
+      args.serve = true;
+    } else if (arg == "--connect") {
+      if (i == argc - 1) {
+        throw std::runtime_error("Socket path not provided");
+      }
+      args.connect_socket = std::string_view{argv[++i]};
+      args.connect = true;
+    } else if (arg == "-j" || arg == "--threads") {
+      if (i == argc - 1) {
+        throw std::runtime_error("thread count specified but not provided");
+      }
+      std::string threads{argv[++i]};
+      try {
+        args.threads = static_cast<unsigned int>(std::stoul(threads));
+      } catch (const std::exception &e) {
+        std::cerr << "Couldn't parse thread count. Using one per core"
+                  << std::endl;
+      }
     } else {
       throw std::runtime_error("Unknown argument: " + std::string(arg));
     }
@@ -51,9 +242,53 @@ Args parse_args(int argc, char *argv[]) {
 std::string get_help() {
   std::stringstream ss;
   ss << "Usage: music-gen -i <input> [-o <output>]\n"
-     << "\t-i, --input\tInput file\n"
-     << "\t-o, --output\tOutput file\n"
+     << "\t-i, --input\tInput file, '-' reads stdin\n"
+     << "\t-o, --output\tOutput file, '-' streams to stdout\n"
      << "\t-l, --lex-only\tOnly run lexer\n"
-     << "\t-p, --parse-only\tOnly run parser\n";
+     << "\t-p, --parse-only\tOnly run parser\n"
+     << "\t--dump-format\ttext, jsonl or binary, what -l and -p print "
+        "(default text)\n"
+     << "\t-f, --format\twav or flac (default: from the output name)\n"
+     << "\t--raw\t\tWrite header-less PCM16 (stdout unless -o is given)\n"
+     << "\t--no-pipeline\tDon't write files from a separate I/O thread\n"
+     << "\t-a, --amplitude\tPeak amplitude in [0,1] (default 0.25)\n"
+     << "\t--limit\t\tRun the mix through a look-ahead limiter at -1dBFS\n"
+     << "\t--normalize\tTarget RMS loudness in dBFS, e.g. -16 (implies "
+        "--limit, overrides -a)\n"
+     << "\t-t, --timbre\tsine, organ, soft-square, bell, saw, square or "
+        "triangle (default sine)\n"
+     << "\t-e, --envelope\tfade, pluck, pad or attack,decay,sustain,release"
+        "[,lin|exp] in seconds (default fade)\n"
+     << "\t--eq\t\tlp:HZ[:Q], hp:HZ[:Q] or peak:HZ:DB[:Q], repeat to "
+        "chain sections\n"
+     << "\t--reverb\troom, hall, a reverb time in seconds or an impulse "
+        "response .wav\n"
+     << "\t--reverb-mix\tLevel of the reverb against the dry signal "
+        "(default 0.3)\n"
+     << "\t-r, --rate\tOutput sample rate in Hz (default 44100)\n"
+     << "\t--resample-quality\tfast, standard or best (default standard)\n"
+     << "\t--bits\t\t16 or 24 bit samples for WAV and raw output "
+        "(default 16)\n"
+     << "\t--dither\tnone, tpdf or shaped (TPDF with noise shaping) "
+        "(default none)\n"
+     << "\t--no-cache\tAlways render, don't look in or add to the render "
+        "cache\n"
+     << "\t--cache-dir\tWhere finished renders are kept (default "
+        "~/.cache/music-gen)\n"
+     << "\t--incremental\tOnly re-render the notes that changed since the "
+        "last incremental render to the same file\n"
+     << "\t--watch\tRender again every time the input file is saved, "
+        "incrementally where possible\n"
+     << "\t--diagnostics\ttext or jsonl, how score errors are reported "
+        "(default text)\n"
+     << "\t--check\tOnly check the score for errors, without building "
+        "anything from it\n"
+     << "\t--max-errors\tStop --check after this many errors (default 10)\n"
+     << "\t--wavetable-cache\tFile to keep the saw/square/triangle tables "
+        "in between runs\n"
+     << "\t--serve <socket>\tRun as a render daemon on a Unix socket\n"
+     << "\t--connect <socket>\tRender through a running daemon\n"
+     << "\t-j, --threads\tThreads for voices, FLAC frames or daemon workers "
+        "(default: one per core)\n";
   return ss.str();
 }
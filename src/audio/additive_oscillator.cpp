@@ -0,0 +1,141 @@
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "audio/additive_oscillator.hpp"
+#include "audio/pcm_format.hpp"
+
+namespace Audio {
+
+void AdditiveOscillator::start(std::span<const Partial> partials,
+                               double freq_hz) {
+  const auto sr = static_cast<double>(kSampleRate);
+  constexpr double tau = 2.0 * std::numbers::pi;
+
+  _re.fill(0.0f);
+  _im.fill(0.0f);
+  _step_re.fill(0.0f);
+  _step_im.fill(0.0f);
+  _magnitude.fill(0.0);
+  _decay.fill(1.0);
+
+  std::size_t used = 0;
+  double total_gain = 0.0;
+  for (const auto &p : partials) {
+    const double freq = p.ratio * freq_hz;
+    if (used == kMaxPartials || freq <= 0.0 || freq >= sr / 2.0)
+      continue;
+
+    const double decay =
+        p.decay_s > 0.0 ? std::exp(-1.0 / (p.decay_s * sr)) : 1.0;
+    const double w = tau * freq / sr;
+    _step_re[used] = static_cast<float>(decay * std::cos(w));
+    _step_im[used] = static_cast<float>(decay * std::sin(w));
+    _decay[used] = decay;
+    _magnitude[used] = p.gain;
+    total_gain += p.gain;
+    ++used;
+  }
+
+  if (total_gain > 0.0) {
+    for (std::size_t k = 0; k < used; ++k) {
+      _magnitude[k] /= total_gain;
+      _re[k] = static_cast<float>(_magnitude[k]);
+    }
+  }
+  _groups = (used + kLanes - 1) / kLanes;
+  _since_renormalize = 0;
+}
+
+void AdditiveOscillator::render(std::span<float> out) {
+  for (std::size_t done = 0; done < out.size();) {
+    const std::size_t len =
+        std::min(kChunk - _since_renormalize, out.size() - done);
+    auto *dst = out.data() + done;
+
+    if (_groups == 0) {
+      std::fill_n(dst, len, 0.0f);
+      done += len;
+      continue;
+    }
+
+    // One lane group at a time so its phasors stay in registers for the
+    // whole chunk, leaving 4 wide partial sums per sample in [_sums]
+#if defined(__SSE2__)
+    for (std::size_t g = 0; g < _groups; ++g) {
+      const auto off = g * kLanes;
+      __m128 re = _mm_load_ps(_re.data() + off);
+      __m128 im = _mm_load_ps(_im.data() + off);
+      const __m128 sr = _mm_load_ps(_step_re.data() + off);
+      const __m128 si = _mm_load_ps(_step_im.data() + off);
+      float *sums = _sums.data();
+      for (std::size_t i = 0; i < len; ++i, sums += kLanes) {
+        const __m128 acc = g == 0 ? im : _mm_add_ps(_mm_load_ps(sums), im);
+        _mm_store_ps(sums, acc);
+        const __m128 next_re =
+            _mm_sub_ps(_mm_mul_ps(re, sr), _mm_mul_ps(im, si));
+        im = _mm_add_ps(_mm_mul_ps(re, si), _mm_mul_ps(im, sr));
+        re = next_re;
+      }
+      _mm_store_ps(_re.data() + off, re);
+      _mm_store_ps(_im.data() + off, im);
+    }
+
+    const float *sums = _sums.data();
+    for (std::size_t i = 0; i < len; ++i, sums += kLanes) {
+      const __m128 v = _mm_load_ps(sums);
+      const __m128 pair = _mm_add_ps(v, _mm_movehl_ps(v, v));
+      const __m128 total =
+          _mm_add_ss(pair, _mm_shuffle_ps(pair, pair, _MM_SHUFFLE(1, 1, 1, 1)));
+      dst[i] = _mm_cvtss_f32(total);
+    }
+#else
+    for (std::size_t g = 0; g < _groups; ++g) {
+      const auto off = g * kLanes;
+      float *sums = _sums.data();
+      for (std::size_t i = 0; i < len; ++i, sums += kLanes) {
+        for (std::size_t l = 0; l < kLanes; ++l) {
+          const auto k = off + l;
+          sums[l] = g == 0 ? _im[k] : sums[l] + _im[k];
+          const float next_re = _re[k] * _step_re[k] - _im[k] * _step_im[k];
+          _im[k] = _re[k] * _step_im[k] + _im[k] * _step_re[k];
+          _re[k] = next_re;
+        }
+      }
+    }
+
+    const float *sums = _sums.data();
+    for (std::size_t i = 0; i < len; ++i, sums += kLanes)
+      dst[i] = (sums[0] + sums[2]) + (sums[1] + sums[3]);
+#endif
+
+    _since_renormalize += len;
+    if (_since_renormalize == kChunk) {
+      renormalize(kChunk);
+      _since_renormalize = 0;
+    }
+    done += len;
+  }
+}
+
+void AdditiveOscillator::renormalize(std::size_t samples) {
+  // Rounding makes float phasors spiral in or out over a long note
+  for (std::size_t k = 0; k < _groups * kLanes; ++k) {
+    if (_magnitude[k] == 0.0)
+      continue;
+    _magnitude[k] *= std::pow(_decay[k], static_cast<double>(samples));
+    const double actual = std::hypot(static_cast<double>(_re[k]),
+                                     static_cast<double>(_im[k]));
+    if (actual > 0.0) {
+      const double scale = _magnitude[k] / actual;
+      _re[k] = static_cast<float>(_re[k] * scale);
+      _im[k] = static_cast<float>(_im[k] * scale);
+    }
+  }
+}
+
+} // namespace Audio
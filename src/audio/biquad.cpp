@@ -0,0 +1,195 @@
+#include <cmath>
+#include <numbers>
+#include <string>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "audio/biquad.hpp"
+#include "audio/pcm_format.hpp"
+
+namespace Audio {
+
+namespace {
+
+bool parse_double(std::string_view text, double &out) {
+  try {
+    std::size_t used = 0;
+    out = std::stod(std::string(text), &used);
+    return used == text.size();
+  } catch (const std::exception &) {
+    return false;
+  }
+}
+
+} // namespace
+
+std::optional<BiquadSettings> parse_biquad(std::string_view spec) {
+  std::vector<std::string_view> fields;
+  while (true) {
+    const auto colon = spec.find(':');
+    fields.push_back(spec.substr(0, colon));
+    if (colon == std::string_view::npos)
+      break;
+    spec.remove_prefix(colon + 1);
+  }
+
+  BiquadSettings settings;
+  std::size_t q_field = 2;
+  if (fields[0] == "lp") {
+    settings.kind = BiquadKind::LowPass;
+  } else if (fields[0] == "hp") {
+    settings.kind = BiquadKind::HighPass;
+  } else if (fields[0] == "peak") {
+    settings.kind = BiquadKind::Peaking;
+    settings.q = 1.0;
+    q_field = 3;
+    if (fields.size() < 3 || !parse_double(fields[2], settings.gain_db))
+      return std::nullopt;
+  } else {
+    return std::nullopt;
+  }
+
+  if (fields.size() < 2 || fields.size() > q_field + 1 ||
+      !parse_double(fields[1], settings.freq_hz))
+    return std::nullopt;
+  if (fields.size() == q_field + 1 &&
+      !parse_double(fields[q_field], settings.q))
+    return std::nullopt;
+
+  const double nyquist = static_cast<double>(kSampleRate) / 2.0;
+  if (settings.freq_hz <= 0.0 || settings.freq_hz >= nyquist ||
+      settings.q <= 0.0)
+    return std::nullopt;
+  return settings;
+}
+
+BiquadCoefficients biquad_coefficients(const BiquadSettings &settings) {
+  const double w0 = 2.0 * std::numbers::pi * settings.freq_hz /
+                    static_cast<double>(kSampleRate);
+  const double cos_w0 = std::cos(w0);
+  const double alpha = std::sin(w0) / (2.0 * settings.q);
+
+  double b0 = 1.0, b1 = 0.0, b2 = 0.0, a0 = 1.0, a1 = 0.0, a2 = 0.0;
+  switch (settings.kind) {
+  case BiquadKind::LowPass:
+    b0 = (1.0 - cos_w0) / 2.0;
+    b1 = 1.0 - cos_w0;
+    b2 = b0;
+    a0 = 1.0 + alpha;
+    a1 = -2.0 * cos_w0;
+    a2 = 1.0 - alpha;
+    break;
+  case BiquadKind::HighPass:
+    b0 = (1.0 + cos_w0) / 2.0;
+    b1 = -(1.0 + cos_w0);
+    b2 = b0;
+    a0 = 1.0 + alpha;
+    a1 = -2.0 * cos_w0;
+    a2 = 1.0 - alpha;
+    break;
+  case BiquadKind::Peaking: {
+    const double a = std::pow(10.0, settings.gain_db / 40.0);
+    b0 = 1.0 + alpha * a;
+    b1 = -2.0 * cos_w0;
+    b2 = 1.0 - alpha * a;
+    a0 = 1.0 + alpha / a;
+    a1 = -2.0 * cos_w0;
+    a2 = 1.0 - alpha / a;
+    break;
+  }
+  }
+
+  return {static_cast<float>(b0 / a0), static_cast<float>(b1 / a0),
+          static_cast<float>(b2 / a0), static_cast<float>(a1 / a0),
+          static_cast<float>(a2 / a0)};
+}
+
+BiquadChain::BiquadChain(std::span<const BiquadSettings> sections) {
+  for (std::size_t i = 0; i < sections.size(); ++i) {
+    if (i % kLanes == 0)
+      _groups.emplace_back();
+    auto &group = _groups.back();
+    const auto lane = group.sections++;
+    const auto c = biquad_coefficients(sections[i]);
+    group.b0[lane] = c.b0;
+    group.b1[lane] = c.b1;
+    group.b2[lane] = c.b2;
+    group.a1[lane] = c.a1;
+    group.a2[lane] = c.a2;
+  }
+}
+
+std::size_t BiquadChain::tail_samples() const {
+  std::size_t delay = 0;
+  for (const auto &group : _groups)
+    delay += group.sections - 1;
+  return delay;
+}
+
+void BiquadChain::process(std::span<float> block) {
+  for (auto &group : _groups)
+    process_group(group, block);
+}
+
+void BiquadChain::process_group(Group &group, std::span<float> block) {
+  // The result leaves from the lane holding the group's last section
+  const auto last = group.sections - 1;
+
+#if defined(__SSE2__)
+  const __m128 b0 = _mm_load_ps(group.b0.data());
+  const __m128 b1 = _mm_load_ps(group.b1.data());
+  const __m128 b2 = _mm_load_ps(group.b2.data());
+  const __m128 a1 = _mm_load_ps(group.a1.data());
+  const __m128 a2 = _mm_load_ps(group.a2.data());
+  __m128 z1 = _mm_load_ps(group.z1.data());
+  __m128 z2 = _mm_load_ps(group.z2.data());
+  __m128 y = _mm_load_ps(group.y.data());
+  alignas(16) float out[kLanes];
+
+  for (auto &sample : block) {
+    // Every section takes what the one before it produced last step
+    __m128 x = _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(y), 4));
+    x = _mm_move_ss(x, _mm_set_ss(sample));
+
+    y = _mm_add_ps(_mm_mul_ps(b0, x), z1);
+    z1 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(b1, x), _mm_mul_ps(a1, y)), z2);
+    z2 = _mm_sub_ps(_mm_mul_ps(b2, x), _mm_mul_ps(a2, y));
+
+    _mm_store_ps(out, y);
+    sample = out[last];
+  }
+
+  _mm_store_ps(group.z1.data(), z1);
+  _mm_store_ps(group.z2.data(), z2);
+  _mm_store_ps(group.y.data(), y);
+#else
+  auto &z1 = group.z1;
+  auto &z2 = group.z2;
+  auto &y = group.y;
+  for (auto &sample : block) {
+    std::array<float, kLanes> x;
+    x[0] = sample;
+    for (std::size_t l = 1; l < kLanes; ++l)
+      x[l] = y[l - 1];
+
+    for (std::size_t l = 0; l < kLanes; ++l) {
+      y[l] = group.b0[l] * x[l] + z1[l];
+      z1[l] = group.b1[l] * x[l] - group.a1[l] * y[l] + z2[l];
+      z2[l] = group.b2[l] * x[l] - group.a2[l] * y[l];
+    }
+    sample = y[last];
+  }
+#endif
+
+  // Silence decays into denormals, which are slow to compute with
+  for (std::size_t l = 0; l < kLanes; ++l) {
+    if (std::abs(group.z1[l]) < 1e-20f)
+      group.z1[l] = 0.0f;
+    if (std::abs(group.z2[l]) < 1e-20f)
+      group.z2[l] = 0.0f;
+  }
+}
+
+} // namespace Audio
@@ -0,0 +1,137 @@
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+#include "audio/envelope.hpp"
+#include "audio/pcm_format.hpp"
+
+namespace Audio {
+
+namespace {
+
+// How far an exponential segment gets towards its target, as e^-k
+constexpr double kCurveSteepness = 5.0;
+
+int to_samples(double seconds) {
+  return std::max(0, static_cast<int>(seconds *
+                                      static_cast<double>(kSampleRate)));
+}
+
+/// Exponential fall from 1 at [x] = 0 to exactly 0 at [x] = 1.
+double exp_fall(double x) {
+  const double floor = std::exp(-kCurveSteepness);
+  return (std::exp(-kCurveSteepness * x) - floor) / (1.0 - floor);
+}
+
+bool parse_double(std::string_view text, double &out) {
+  try {
+    std::size_t used = 0;
+    out = std::stod(std::string(text), &used);
+    return used == text.size();
+  } catch (const std::exception &) {
+    return false;
+  }
+}
+
+} // namespace
+
+Adsr fade_envelope(double fade_s) {
+  return Adsr{.attack_s = fade_s,
+              .decay_s = 0.0,
+              .sustain = 1.0,
+              .release_s = fade_s,
+              .curve = EnvelopeCurve::Linear};
+}
+
+std::optional<Adsr> parse_envelope(std::string_view spec) {
+  if (spec == "fade")
+    return fade_envelope(0.005);
+  if (spec == "pluck")
+    return Adsr{0.002, 0.4, 0.0, 0.02, EnvelopeCurve::Exponential};
+  if (spec == "pad")
+    return Adsr{0.15, 0.2, 0.7, 0.25, EnvelopeCurve::Exponential};
+
+  std::vector<std::string_view> fields;
+  while (true) {
+    const auto comma = spec.find(',');
+    fields.push_back(spec.substr(0, comma));
+    if (comma == std::string_view::npos)
+      break;
+    spec.remove_prefix(comma + 1);
+  }
+  if (fields.size() != 4 && fields.size() != 5)
+    return std::nullopt;
+
+  Adsr adsr;
+  if (!parse_double(fields[0], adsr.attack_s) ||
+      !parse_double(fields[1], adsr.decay_s) ||
+      !parse_double(fields[2], adsr.sustain) ||
+      !parse_double(fields[3], adsr.release_s))
+    return std::nullopt;
+  if (adsr.attack_s < 0.0 || adsr.decay_s < 0.0 || adsr.release_s < 0.0 ||
+      adsr.sustain < 0.0 || adsr.sustain > 1.0)
+    return std::nullopt;
+
+  if (fields.size() == 5) {
+    if (fields[4] == "lin")
+      adsr.curve = EnvelopeCurve::Linear;
+    else if (fields[4] == "exp")
+      adsr.curve = EnvelopeCurve::Exponential;
+    else
+      return std::nullopt;
+  }
+  return adsr;
+}
+
+Envelope::Envelope(const Adsr &adsr)
+    : _attack(to_samples(adsr.attack_s)), _decay(to_samples(adsr.decay_s)),
+      _release(to_samples(adsr.release_s)), _sustain(adsr.sustain),
+      _attack_ramp(static_cast<std::size_t>(_attack)),
+      _decay_ramp(static_cast<std::size_t>(_decay)),
+      _release_ramp(static_cast<std::size_t>(_release)) {
+  const bool linear = adsr.curve == EnvelopeCurve::Linear;
+
+  // The linear ramps are i / n exactly, which keeps the "fade" preset
+  // sample-for-sample identical to the original envelope
+  for (int i = 0; i < _attack; ++i) {
+    const double x = static_cast<double>(i) / _attack;
+    _attack_ramp[i] = linear ? x : 1.0 - exp_fall(x);
+  }
+  for (int i = 0; i < _decay; ++i) {
+    const double x = static_cast<double>(i) / _decay;
+    _decay_ramp[i] = _sustain + (1.0 - _sustain) * (linear ? 1.0 - x
+                                                           : exp_fall(x));
+  }
+  for (int left = 0; left < _release; ++left) {
+    const double x = static_cast<double>(left) / _release;
+    _release_ramp[left] = linear ? x : exp_fall(1.0 - x);
+  }
+}
+
+void Envelope::start(int note_samples) {
+  _note_samples = note_samples;
+  // Releasing out of the sustain starts at the sustain level. Any earlier
+  // and the release is capped against the attack/decay curve instead, which
+  // is still continuous and is what the original fades did.
+  _release_level = note_samples - _release >= _attack + _decay ? _sustain : 1.0;
+}
+
+void Envelope::render(std::span<double> out, int offset) const {
+  const int end = offset + static_cast<int>(out.size());
+
+  int i = offset;
+  for (const int stop = std::min(end, _attack); i < stop; ++i)
+    out[i - offset] = _attack_ramp[i];
+  for (const int stop = std::min(end, _attack + _decay); i < stop; ++i)
+    out[i - offset] = _decay_ramp[i - _attack];
+  for (; i < end; ++i)
+    out[i - offset] = _sustain;
+
+  const int last = _note_samples - 1;
+  for (i = std::max(offset, _note_samples - _release); i < end; ++i) {
+    out[i - offset] =
+        std::min(out[i - offset], _release_level * _release_ramp[last - i]);
+  }
+}
+
+} // namespace Audio
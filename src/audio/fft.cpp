@@ -0,0 +1,124 @@
+#include <cmath>
+#include <numbers>
+#include <stdexcept>
+
+#include "audio/fft.hpp"
+
+namespace Audio {
+
+RealFft::RealFft(std::size_t size)
+    : _size(size), _half(size / 2), _cos(_half / 2), _sin(_half / 2),
+      _split_cos(_half), _split_sin(_half), _bit_reverse(_half),
+      _work_re(_half), _work_im(_half) {
+  if (size < 4 || (size & (size - 1)) != 0)
+    throw std::invalid_argument("FFT size must be a power of two >= 4");
+
+  constexpr double tau = 2.0 * std::numbers::pi;
+  for (std::size_t k = 0; k < _half / 2; ++k) {
+    const double angle = tau * static_cast<double>(k) / _half;
+    _cos[k] = static_cast<float>(std::cos(angle));
+    _sin[k] = static_cast<float>(-std::sin(angle));
+  }
+  for (std::size_t k = 0; k < _half; ++k) {
+    const double angle = tau * static_cast<double>(k) / _size;
+    _split_cos[k] = static_cast<float>(std::cos(angle));
+    _split_sin[k] = static_cast<float>(-std::sin(angle));
+  }
+
+  unsigned int bits = 0;
+  while ((std::size_t{1} << bits) < _half)
+    ++bits;
+  for (std::size_t i = 0; i < _half; ++i) {
+    std::uint32_t reversed = 0;
+    for (unsigned int b = 0; b < bits; ++b)
+      reversed |= ((i >> b) & 1u) << (bits - 1 - b);
+    _bit_reverse[i] = reversed;
+  }
+}
+
+std::size_t RealFft::size() const { return _size; }
+
+std::size_t RealFft::bins() const { return _half + 1; }
+
+void RealFft::transform(bool inverse) {
+  auto *re = _work_re.data();
+  auto *im = _work_im.data();
+  for (std::size_t i = 0; i < _half; ++i) {
+    const auto j = _bit_reverse[i];
+    if (j > i) {
+      std::swap(re[i], re[j]);
+      std::swap(im[i], im[j]);
+    }
+  }
+
+  // The inverse is the forward transform with conjugated twiddles
+  const float sign = inverse ? -1.0f : 1.0f;
+  for (std::size_t len = 2; len <= _half; len <<= 1) {
+    const std::size_t half = len / 2;
+    const std::size_t step = _half / len;
+    for (std::size_t i = 0; i < _half; i += len) {
+      for (std::size_t j = 0; j < half; ++j) {
+        const float wr = _cos[j * step];
+        const float wi = sign * _sin[j * step];
+        const auto a = i + j;
+        const auto b = a + half;
+        const float vr = re[b] * wr - im[b] * wi;
+        const float vi = re[b] * wi + im[b] * wr;
+        re[b] = re[a] - vr;
+        im[b] = im[a] - vi;
+        re[a] += vr;
+        im[a] += vi;
+      }
+    }
+  }
+}
+
+void RealFft::forward(std::span<const float> in, std::span<float> re,
+                      std::span<float> im) {
+  for (std::size_t n = 0; n < _half; ++n) {
+    _work_re[n] = in[2 * n];
+    _work_im[n] = in[2 * n + 1];
+  }
+  transform(false);
+
+  // Z = E + iO, where E and O are the spectra of the even and odd samples;
+  // X[k] = E[k] + W^k O[k] with E/O recovered from Z[k] and conj(Z[half-k])
+  for (std::size_t k = 0; k <= _half; ++k) {
+    const auto a = k % _half;
+    const auto b = (_half - k) % _half;
+    const float zr = _work_re[a], zi = _work_im[a];
+    const float cr = _work_re[b], ci = -_work_im[b];
+    const float er = 0.5f * (zr + cr), ei = 0.5f * (zi + ci);
+    // O = (Z - conj(Z')) / 2i
+    const float or_ = 0.5f * (zi - ci), oi = -0.5f * (zr - cr);
+    const float wr = k < _half ? _split_cos[k] : -1.0f;
+    const float wi = k < _half ? _split_sin[k] : 0.0f;
+    re[k] = er + (or_ * wr - oi * wi);
+    im[k] = ei + (or_ * wi + oi * wr);
+  }
+}
+
+void RealFft::inverse(std::span<const float> re, std::span<const float> im,
+                      std::span<float> out) {
+  for (std::size_t k = 0; k < _half; ++k) {
+    const float xr = re[k], xi = im[k];
+    const float cr = re[_half - k], ci = -im[_half - k];
+    const float er = 0.5f * (xr + cr), ei = 0.5f * (xi + ci);
+    // O = (X - conj(X')) / 2 * conj(W^k)
+    const float dr = 0.5f * (xr - cr), di = 0.5f * (xi - ci);
+    const float wr = _split_cos[k], wi = -_split_sin[k];
+    const float or_ = dr * wr - di * wi, oi = dr * wi + di * wr;
+    // Z = E + iO
+    _work_re[k] = er - oi;
+    _work_im[k] = ei + or_;
+  }
+  transform(true);
+
+  const float scale = 1.0f / static_cast<float>(_half);
+  for (std::size_t n = 0; n < _half; ++n) {
+    out[2 * n] = _work_re[n] * scale;
+    out[2 * n + 1] = _work_im[n] * scale;
+  }
+}
+
+} // namespace Audio
@@ -0,0 +1,386 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <fstream>
+#include <stdexcept>
+#include <thread>
+
+#include "audio/flac_writer.hpp"
+#include "audio/pcm_format.hpp"
+
+namespace Audio {
+
+constexpr std::size_t kFlacBlockSize = 4096;
+constexpr std::size_t kFramesPerThread = 8; // frames per thread per batch
+constexpr unsigned int kMaxFixedOrder = 4;
+constexpr unsigned int kMaxPartitionOrder = 8;
+
+/// MSB-first bit packer, which is the bit order FLAC uses throughout.
+class BitWriter {
+private:
+  std::vector<std::uint8_t> _bytes;
+  std::uint64_t _acc = 0;
+  unsigned int _bits = 0; // bits waiting in [_acc], always < 8 between calls
+
+public:
+  void put(std::uint32_t value, unsigned int n) {
+    if (n == 0)
+      return;
+    const std::uint64_t mask = (std::uint64_t{1} << n) - 1;
+    _acc = (_acc << n) | (value & mask);
+    _bits += n;
+    while (_bits >= 8) {
+      _bits -= 8;
+      _bytes.push_back(static_cast<std::uint8_t>(_acc >> _bits));
+    }
+  }
+
+  void put_signed(std::int32_t value, unsigned int n) {
+    put(static_cast<std::uint32_t>(value), n);
+  }
+
+  void put_unary(std::uint32_t zeros) {
+    while (zeros >= 32) {
+      put(0, 32);
+      zeros -= 32;
+    }
+    put(1, zeros + 1);
+  }
+
+  void put_rice(std::uint32_t folded, unsigned int k) {
+    put_unary(folded >> k);
+    put(folded, k);
+  }
+
+  void align() {
+    if (_bits > 0)
+      put(0, 8 - _bits);
+  }
+
+  std::vector<std::uint8_t> &bytes() { return _bytes; }
+};
+
+std::uint8_t crc8(std::span<const std::uint8_t> data) {
+  std::uint8_t crc = 0;
+  for (auto byte : data) {
+    crc ^= byte;
+    for (int i = 0; i < 8; ++i)
+      crc = static_cast<std::uint8_t>((crc & 0x80u) ? (crc << 1) ^ 0x07u
+                                                     : crc << 1);
+  }
+  return crc;
+}
+
+std::uint16_t crc16(std::span<const std::uint8_t> data) {
+  std::uint16_t crc = 0;
+  for (auto byte : data) {
+    crc ^= static_cast<std::uint16_t>(byte << 8);
+    for (int i = 0; i < 8; ++i)
+      crc = static_cast<std::uint16_t>((crc & 0x8000u) ? (crc << 1) ^ 0x8005u
+                                                       : crc << 1);
+  }
+  return crc;
+}
+
+/// Frame numbers are stored with the same variable length scheme as UTF-8.
+void put_utf8(BitWriter &bw, std::uint64_t value) {
+  if (value < 0x80) {
+    bw.put(static_cast<std::uint32_t>(value), 8);
+    return;
+  }
+  unsigned int continuation = 1;
+  while (continuation < 6 &&
+         value >= (std::uint64_t{1} << (6 + 5 * continuation)))
+    ++continuation;
+
+  const auto lead =
+      static_cast<std::uint32_t>((0xFF00u >> (continuation + 1)) & 0xFFu);
+  bw.put(lead | static_cast<std::uint32_t>(value >> (6 * continuation)), 8);
+  for (unsigned int i = continuation; i-- > 0;)
+    bw.put(0x80u | static_cast<std::uint32_t>((value >> (6 * i)) & 0x3Fu), 8);
+}
+
+std::uint32_t sample_rate_code(std::uint32_t rate) {
+  switch (rate) {
+  case 44'100:
+    return 0b1001;
+  case 48'000:
+    return 0b1010;
+  case 96'000:
+    return 0b1011;
+  default:
+    return 0b0000; // take it from STREAMINFO
+  }
+}
+
+std::int32_t fixed_residual(std::span<const std::int16_t> s, std::size_t i,
+                            unsigned int order) {
+  const std::int32_t x0 = s[i];
+  switch (order) {
+  case 0:
+    return x0;
+  case 1:
+    return x0 - s[i - 1];
+  case 2:
+    return x0 - 2 * s[i - 1] + s[i - 2];
+  case 3:
+    return x0 - 3 * s[i - 1] + 3 * s[i - 2] - s[i - 3];
+  default:
+    return x0 - 4 * s[i - 1] + 6 * s[i - 2] - 4 * s[i - 3] + s[i - 4];
+  }
+}
+
+std::uint32_t fold(std::int32_t r) {
+  return (static_cast<std::uint32_t>(r) << 1) ^
+         static_cast<std::uint32_t>(r >> 31);
+}
+
+struct RiceChoice {
+  unsigned int partition_order = 0;
+  std::vector<unsigned int> params;
+  std::uint64_t bits = 0; // estimated size of the residual section
+};
+
+/// Picks the partition order and per-partition Rice parameters, estimating
+/// each partition's cost from the sum of its folded residuals.
+RiceChoice choose_rice(const std::vector<std::uint32_t> &folded,
+                       std::size_t block, unsigned int order) {
+  unsigned int max_order = 0;
+  while (max_order < kMaxPartitionOrder &&
+         block % (std::size_t{1} << (max_order + 1)) == 0 &&
+         (block >> (max_order + 1)) > order)
+    ++max_order;
+
+  // Sums for the finest partitioning, merged pairwise for coarser ones.
+  std::vector<std::uint64_t> sums(std::size_t{1} << max_order, 0);
+  const std::size_t finest = block >> max_order;
+  for (std::size_t i = 0; i < folded.size(); ++i)
+    sums[(i + order) / finest] += folded[i];
+
+  RiceChoice best{};
+  best.bits = ~std::uint64_t{0};
+  for (unsigned int p = max_order + 1; p-- > 0;) {
+    const std::size_t parts = std::size_t{1} << p;
+    const std::size_t len = block >> p;
+    RiceChoice choice{.partition_order = p, .params = {}, .bits = 0};
+    bool wide = false;
+    for (std::size_t j = 0; j < parts; ++j) {
+      const std::uint64_t count = j == 0 ? len - order : len;
+      unsigned int best_k = 0;
+      std::uint64_t best_cost = ~std::uint64_t{0};
+      for (unsigned int k = 0; k <= 30; ++k) {
+        const auto cost = count * (k + 1) + (sums[j] >> k);
+        if (cost < best_cost) {
+          best_cost = cost;
+          best_k = k;
+        }
+      }
+      wide = wide || best_k > 14;
+      choice.params.push_back(best_k);
+      choice.bits += best_cost;
+    }
+    choice.bits += parts * (wide ? 5 : 4) + 6;
+    if (choice.bits < best.bits)
+      best = std::move(choice);
+
+    if (p > 0) {
+      for (std::size_t j = 0; j < parts / 2; ++j)
+        sums[j] = sums[2 * j] + sums[2 * j + 1];
+    }
+  }
+  return best;
+}
+
+void encode_subframe(BitWriter &bw, std::span<const std::int16_t> s) {
+  const std::size_t n = s.size();
+
+  if (std::all_of(s.begin(), s.end(),
+                  [&](std::int16_t v) { return v == s[0]; })) {
+    bw.put(0b00000000, 8); // pad, CONSTANT, no wasted bits
+    bw.put_signed(s[0], kBitsPerSample);
+    return;
+  }
+
+  // Order with the smallest total absolute residual wins.
+  unsigned int order = 0;
+  std::uint64_t best_abs = ~std::uint64_t{0};
+  for (unsigned int o = 0; o <= kMaxFixedOrder && o < n; ++o) {
+    std::uint64_t total = 0;
+    for (std::size_t i = o; i < n; ++i) {
+      const auto r = fixed_residual(s, i, o);
+      total += static_cast<std::uint64_t>(
+          r < 0 ? -static_cast<std::int64_t>(r) : r);
+    }
+    if (total < best_abs) {
+      best_abs = total;
+      order = o;
+    }
+  }
+
+  std::vector<std::uint32_t> folded(n - order);
+  for (std::size_t i = order; i < n; ++i)
+    folded[i - order] = fold(fixed_residual(s, i, order));
+
+  const auto rice = choose_rice(folded, n, order);
+  const std::uint64_t fixed_bits = rice.bits + order * kBitsPerSample;
+  if (fixed_bits >= n * kBitsPerSample) {
+    bw.put(0b00000010, 8); // pad, VERBATIM, no wasted bits
+    for (auto v : s)
+      bw.put_signed(v, kBitsPerSample);
+    return;
+  }
+
+  bw.put(0, 1);
+  bw.put(0b001000 | order, 6); // FIXED
+  bw.put(0, 1);
+  for (unsigned int i = 0; i < order; ++i)
+    bw.put_signed(s[i], kBitsPerSample);
+
+  const bool wide = std::any_of(rice.params.begin(), rice.params.end(),
+                                [](unsigned int k) { return k > 14; });
+  const unsigned int param_bits = wide ? 5 : 4;
+  bw.put(wide ? 0b01 : 0b00, 2);
+  bw.put(rice.partition_order, 4);
+
+  const std::size_t len = n >> rice.partition_order;
+  std::size_t idx = 0;
+  for (std::size_t j = 0; j < rice.params.size(); ++j) {
+    const auto k = rice.params[j];
+    bw.put(k, param_bits);
+    const std::size_t count = j == 0 ? len - order : len;
+    for (std::size_t i = 0; i < count; ++i)
+      bw.put_rice(folded[idx++], k);
+  }
+}
+
+std::vector<std::uint8_t> encode_frame(std::span<const std::int16_t> s,
+                                       std::uint64_t frame_number,
+                                       std::uint32_t sample_rate) {
+  BitWriter bw;
+  const bool full = s.size() == kFlacBlockSize;
+
+  bw.put(0b11111111111110, 14); // sync code
+  bw.put(0, 1);                 // reserved
+  bw.put(0, 1);                 // fixed block size stream
+  bw.put(full ? 0b1100 : 0b0111, 4); // 4096, or a 16 bit size at the end
+  bw.put(sample_rate_code(sample_rate), 4);
+  bw.put(0b0000, 4); // mono
+  bw.put(0b100, 3);  // 16 bits per sample
+  bw.put(0, 1);      // reserved
+  put_utf8(bw, frame_number);
+  if (!full)
+    bw.put(static_cast<std::uint32_t>(s.size() - 1), 16);
+  bw.put(crc8(bw.bytes()), 8);
+
+  encode_subframe(bw, s);
+
+  bw.align();
+  bw.put(crc16(bw.bytes()), 16);
+  return std::move(bw.bytes());
+}
+
+FlacWriter::FlacWriter(std::ostream &out, std::uint64_t total_samples,
+                       unsigned int threads, std::uint32_t sample_rate)
+    : _out(out), _total_samples(total_samples),
+      _threads(threads == 0 ? std::max(1u, std::thread::hardware_concurrency())
+                            : threads),
+      _sample_rate(sample_rate) {
+  write_stream_header();
+}
+
+void FlacWriter::write_stream_header() {
+  BitWriter bw;
+  bw.put('f', 8);
+  bw.put('L', 8);
+  bw.put('a', 8);
+  bw.put('C', 8);
+
+  bw.put(1, 1);  // last metadata block
+  bw.put(0, 7);  // STREAMINFO
+  bw.put(34, 24); // block length
+
+  bw.put(kFlacBlockSize, 16); // min block size
+  bw.put(kFlacBlockSize, 16); // max block size
+  bw.put(0, 24);              // min frame size, unknown
+  bw.put(0, 24);              // max frame size, unknown
+  bw.put(_sample_rate, 20);
+  bw.put(kChannels - 1, 3);
+  bw.put(kBitsPerSample - 1, 5);
+  bw.put(static_cast<std::uint32_t>(_total_samples >> 32), 4);
+  bw.put(static_cast<std::uint32_t>(_total_samples), 32);
+  for (int i = 0; i < 4; ++i)
+    bw.put(0, 32); // MD5 of the audio, left unset
+
+  const auto &bytes = bw.bytes();
+  _out.write(reinterpret_cast<const char *>(bytes.data()),
+             static_cast<std::streamsize>(bytes.size()));
+  if (!_out)
+    throw std::runtime_error("I/O error while writing FLAC");
+}
+
+void FlacWriter::encode_batch(std::size_t samples) {
+  const std::size_t frames = (samples + kFlacBlockSize - 1) / kFlacBlockSize;
+  std::vector<std::vector<std::uint8_t>> encoded(frames);
+
+  std::atomic<std::size_t> next{0};
+  auto work = [&] {
+    for (auto f = next++; f < frames; f = next++) {
+      const std::size_t begin = f * kFlacBlockSize;
+      const std::size_t len = std::min(kFlacBlockSize, samples - begin);
+      encoded[f] = encode_frame(
+          std::span<const std::int16_t>(_pending.data() + begin, len),
+          _frames_written + f, _sample_rate);
+    }
+  };
+
+  const auto helpers = std::min<std::size_t>(_threads, frames) - 1;
+  std::vector<std::thread> pool;
+  for (std::size_t i = 0; i < helpers; ++i)
+    pool.emplace_back(work);
+  work();
+  for (auto &t : pool)
+    t.join();
+
+  for (const auto &frame : encoded) {
+    _out.write(reinterpret_cast<const char *>(frame.data()),
+               static_cast<std::streamsize>(frame.size()));
+  }
+  if (!_out)
+    throw std::runtime_error("I/O error while writing FLAC");
+
+  _frames_written += frames;
+  _samples_written += samples;
+  _pending.erase(_pending.begin(),
+                 _pending.begin() + static_cast<std::ptrdiff_t>(samples));
+}
+
+void FlacWriter::write(std::span<const std::int16_t> samples) {
+  const std::size_t batch = kFlacBlockSize * kFramesPerThread * _threads;
+  _pending.insert(_pending.end(), samples.begin(), samples.end());
+  while (_pending.size() >= batch)
+    encode_batch(batch);
+}
+
+void FlacWriter::finish() {
+  if (_finished)
+    return;
+  _finished = true;
+  if (!_pending.empty())
+    encode_batch(_pending.size());
+  if (_samples_written != _total_samples)
+    throw std::runtime_error("FLAC stream length doesn't match its header");
+}
+
+void write_pcm16_mono_flac(const std::string &path,
+                           const std::vector<std::int16_t> &samples,
+                           unsigned int threads) {
+  std::ofstream out(path, std::ios::binary);
+  if (!out)
+    throw std::runtime_error("Failed to open output file: " + path);
+
+  FlacWriter writer(out, samples.size(), threads);
+  writer.write(samples);
+  writer.finish();
+}
+
+} // namespace Audio
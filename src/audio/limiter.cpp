@@ -0,0 +1,68 @@
+#include <algorithm>
+#include <cmath>
+
+#include "audio/limiter.hpp"
+#include "audio/pcm_format.hpp"
+
+namespace Audio {
+
+LookaheadLimiter::LookaheadLimiter(const LimiterSettings &settings)
+    : _ceiling(settings.ceiling) {
+  const auto sr = static_cast<double>(kSampleRate);
+  _window = std::max<std::size_t>(
+      2, static_cast<std::size_t>(std::lround(settings.lookahead_s * sr)));
+  _release = static_cast<float>(
+      1.0 - std::exp(-1.0 / (std::max(settings.release_s, 1e-4) * sr)));
+  _delay.assign(_window - 1, 0.0f);
+  _minimum.resize(_window);
+  _averaged.assign(_window, 1.0f);
+  _sum = static_cast<double>(_window);
+}
+
+std::size_t LookaheadLimiter::tail_samples() const { return _window - 1; }
+
+void LookaheadLimiter::process(std::span<float> block) {
+  const auto window = _window;
+  for (auto &sample : block) {
+    const float magnitude = std::abs(sample);
+    const float needed = magnitude > _ceiling ? _ceiling / magnitude : 1.0f;
+
+    // Sliding minimum of the needed gain over the last [window] samples. The
+    // sample falling out of the window goes first: with the needed gain
+    // rising all along nothing else leaves, and the ring holds only [window]
+    if (_min_size > 0 && _minimum[_min_head].index + window <= _index) {
+      _min_head = (_min_head + 1) % window;
+      --_min_size;
+    }
+    while (_min_size > 0 &&
+           _minimum[(_min_head + _min_size - 1) % window].gain >= needed)
+      --_min_size;
+    _minimum[(_min_head + _min_size) % window] = {_index, needed};
+    ++_min_size;
+    const float held = _minimum[_min_head].gain;
+
+    // ...averaged over the same window, so it ramps down ahead of the peak
+    const auto slot = _index % window;
+    _sum += static_cast<double>(held) - static_cast<double>(_averaged[slot]);
+    _averaged[slot] = held;
+    const auto target = static_cast<float>(_sum / static_cast<double>(window));
+
+    if (target < _gain) {
+      _gain = target;
+    } else {
+      _gain += (target - _gain) * _release;
+      // The release would only creep up on the target forever otherwise
+      if (target - _gain < 1e-5f)
+        _gain = target;
+    }
+
+    const auto delay_slot = _index % _delay.size();
+    const float delayed = _delay[delay_slot];
+    _delay[delay_slot] = sample;
+    // The clamp only catches rounding in the running sum
+    sample = std::clamp(delayed * _gain, -_ceiling, _ceiling);
+    ++_index;
+  }
+}
+
+} // namespace Audio
@@ -0,0 +1,74 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include "audio/loudness.hpp"
+#include "audio/melody_renderer.hpp"
+
+namespace Audio {
+
+NoteLoudnessCache::NoteLoudnessCache(const Adsr &envelope, Timbre timbre)
+    : _envelope(envelope), _timbre(timbre) {}
+
+double NoteLoudnessCache::mean_square(const NoteInfo &note) {
+  const int samples = note_samples(note);
+  if (note.freq_hz <= 0.0 || samples == 0)
+    return 0.0;
+
+  const auto key = std::make_pair(note.freq_hz, samples);
+  if (const auto it = _mean_squares.find(key); it != _mean_squares.end())
+    return it->second;
+
+  const NoteInfo single[] = {note};
+  MelodyRenderer renderer(single, 1.0, _envelope, _timbre);
+  _scratch.resize(static_cast<std::size_t>(samples));
+  renderer.render(std::span<float>(_scratch));
+
+  double sum = 0.0;
+  for (const float x : _scratch)
+    sum += static_cast<double>(x) * static_cast<double>(x);
+  const double mean_square = sum / static_cast<double>(samples);
+  _mean_squares.emplace(key, mean_square);
+  return mean_square;
+}
+
+double estimate_rms(std::span<const Voice> voices, NoteLoudnessCache &cache) {
+  double energy = 0.0;
+  std::vector<std::pair<std::uint64_t, std::uint64_t>> sounding;
+  for (const auto &voice : voices) {
+    std::uint64_t position = 0;
+    for (const auto &note : voice) {
+      const auto samples = static_cast<std::uint64_t>(note_samples(note));
+      const double mean_square = cache.mean_square(note);
+      if (mean_square > 0.0) {
+        energy += mean_square * static_cast<double>(samples);
+        sounding.emplace_back(position, position + samples);
+      }
+      position += samples;
+    }
+  }
+
+  // Length of the union of every voice's notes
+  std::sort(sounding.begin(), sounding.end());
+  std::uint64_t active = 0;
+  std::uint64_t covered = 0;
+  for (const auto &[begin, end] : sounding) {
+    const auto from = std::max(begin, covered);
+    if (end > from)
+      active += end - from;
+    covered = std::max(covered, end);
+  }
+
+  return active == 0 ? 0.0 : std::sqrt(energy / static_cast<double>(active));
+}
+
+double normalized_amplitude(std::span<const Voice> voices, const Adsr &envelope,
+                            Timbre timbre, double target_db) {
+  NoteLoudnessCache cache(envelope, timbre);
+  const double rms = estimate_rms(voices, cache);
+  if (rms <= 0.0)
+    return 1.0;
+  return std::pow(10.0, target_db / 20.0) / rms;
+}
+
+} // namespace Audio
@@ -0,0 +1,132 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <numbers>
+#include <type_traits>
+
+#include "audio/melody_renderer.hpp"
+#include "audio/note_info.hpp"
+#include "audio/pcm_format.hpp"
+
+namespace Audio {
+
+int note_samples(const NoteInfo &note) {
+  const auto sr = static_cast<double>(kSampleRate);
+  return std::max(0, static_cast<int>(note.dur_s * sr));
+}
+
+MelodyRenderer::MelodyRenderer(std::span<const NoteInfo> notes,
+                               double amplitude, const Adsr &envelope,
+                               Timbre timbre)
+    : _notes(notes), _amplitude(amplitude), _envelope(envelope),
+      _timbre(timbre), _waveform(timbre_waveform(timbre)) {
+  if (_waveform)
+    WavetableBank::shared();
+  for (const auto &n : _notes)
+    _total_samples += static_cast<std::uint64_t>(note_samples(n));
+}
+
+bool MelodyRenderer::done() const { return _note >= _notes.size(); }
+
+std::uint64_t MelodyRenderer::total_samples() const { return _total_samples; }
+
+void MelodyRenderer::start_note(double freq_hz) {
+  if (_waveform)
+    _wavetable.start(WavetableBank::shared(), *_waveform, freq_hz);
+  else
+    _additive.start(timbre_partials(_timbre), freq_hz);
+}
+
+void MelodyRenderer::render_note(std::span<float> out) {
+  if (_waveform)
+    _wavetable.render(out);
+  else
+    _additive.render(out);
+}
+
+namespace {
+
+/// Final sample [x] in [-1, 1] as the renderer's output type. Floats are kept
+/// as is for mixing, PCM16 rounds and saturates like [Quantizer].
+template <typename Sample> Sample store(double x) {
+  if constexpr (std::is_same_v<Sample, float>) {
+    return static_cast<float>(x);
+  } else {
+    constexpr auto full_scale =
+        static_cast<double>(std::numeric_limits<std::int16_t>::max());
+    return static_cast<std::int16_t>(
+        std::clamp(std::nearbyint(x * full_scale), -32768.0, 32767.0));
+  }
+}
+
+} // namespace
+
+std::size_t MelodyRenderer::render(std::span<std::int16_t> out) {
+  return render_into(out);
+}
+
+std::size_t MelodyRenderer::render(std::span<float> out) {
+  return render_into(out);
+}
+
+template <typename Sample>
+std::size_t MelodyRenderer::render_into(std::span<Sample> out) {
+  const auto sr = static_cast<double>(kSampleRate);
+  constexpr double tau = 2.0 * std::numbers::pi;
+
+  std::size_t written = 0;
+  while (written < out.size() && !done()) {
+    const auto &n = _notes[_note];
+    const int n_samples = note_samples(n);
+    const int end = static_cast<int>(std::min<std::size_t>(
+        static_cast<std::size_t>(n_samples),
+        static_cast<std::size_t>(_pos) + (out.size() - written)));
+
+    if (_pos == 0) {
+      _envelope.start(n_samples);
+      if (_timbre != Timbre::Sine)
+        start_note(n.freq_hz);
+    }
+
+    std::array<double, 256> env;
+    std::array<float, 256> partials;
+    for (int chunk = _pos; chunk < end;) {
+      const int chunk_end = std::min(end, chunk + static_cast<int>(env.size()));
+      const auto len = static_cast<std::size_t>(chunk_end - chunk);
+      _envelope.render(std::span(env.data(), len), chunk);
+
+      auto *dst = out.data() + written;
+      if (n.freq_hz <= 0.0) {
+        std::fill_n(dst, len, Sample{0});
+      } else if (_timbre == Timbre::Sine) {
+        for (int i = chunk; i < chunk_end; ++i) {
+          const double t = static_cast<double>(i) / sr;
+          const double x = _amplitude * env[i - chunk] *
+                           std::sin(tau * n.freq_hz * t);
+          dst[i - chunk] = store<Sample>(x);
+        }
+      } else {
+        // Anything but a pure sine comes out of an oscillator
+        render_note(std::span(partials.data(), len));
+        for (std::size_t i = 0; i < len; ++i) {
+          const double x =
+              _amplitude * env[i] * static_cast<double>(partials[i]);
+          dst[i] = store<Sample>(x);
+        }
+      }
+      written += len;
+      chunk = chunk_end;
+    }
+
+    _pos = end;
+    if (_pos >= n_samples) {
+      ++_note;
+      _pos = 0;
+    }
+  }
+
+  return written;
+}
+
+} // namespace Audio
@@ -0,0 +1,243 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "audio/mix_renderer.hpp"
+
+namespace Audio {
+
+namespace {
+
+std::size_t thread_count(unsigned int requested, std::size_t voices) {
+  const std::size_t threads =
+      requested == 0 ? std::max(1u, std::thread::hardware_concurrency())
+                     : requested;
+  return std::max<std::size_t>(1, std::min(threads, voices));
+}
+
+/// Identity up to the threshold, then a tanh knee that approaches full scale
+/// but never reaches it.
+float soft_limit(float x) {
+  constexpr float t = MixRenderer::kLimiterThreshold;
+  const float magnitude = std::abs(x);
+  if (magnitude <= t)
+    return x;
+  const float bent = t + (1.0f - t) * std::tanh((magnitude - t) / (1.0f - t));
+  return std::copysign(bent, x);
+}
+
+} // namespace
+
+std::uint64_t song_samples(std::span<const Voice> voices) {
+  std::uint64_t longest = 0;
+  for (const auto &voice : voices) {
+    std::uint64_t samples = 0;
+    for (const auto &note : voice)
+      samples += static_cast<std::uint64_t>(note_samples(note));
+    longest = std::max(longest, samples);
+  }
+  return longest;
+}
+
+MixRenderer::MixRenderer(std::span<const Voice> voices, double amplitude,
+                         const Adsr &envelope, Timbre timbre,
+                         unsigned int threads)
+    : _threads(thread_count(threads, voices.size())),
+      _start(static_cast<std::ptrdiff_t>(_threads)),
+      _finish(static_cast<std::ptrdiff_t>(_threads)) {
+  _voices.reserve(voices.size());
+  for (const auto &voice : voices)
+    _voices.emplace_back(voice, amplitude, envelope, timbre);
+  _song_samples = song_samples(voices);
+  _total_samples = _song_samples;
+  _mix.resize(kScratchSamples);
+  _scratch.assign(_voices.size(), std::vector<float>(kScratchSamples));
+
+  for (std::size_t t = 1; t < _threads; ++t) {
+    _workers.emplace_back([this, t] {
+      while (true) {
+        _start.arrive_and_wait();
+        if (_stopping)
+          return;
+        render_share(t);
+        _finish.arrive_and_wait();
+      }
+    });
+  }
+}
+
+MixRenderer::~MixRenderer() {
+  if (_workers.empty())
+    return;
+  _stopping = true;
+  _start.arrive_and_wait();
+  for (auto &worker : _workers)
+    worker.join();
+}
+
+bool MixRenderer::done() const {
+  if (_resampler)
+    return _output_position >= total_samples();
+  return _position >= _total_samples;
+}
+
+std::uint64_t MixRenderer::total_samples() const {
+  if (_resampler)
+    return Resampler::output_samples(_total_samples, kSampleRate, _output_rate);
+  return _total_samples;
+}
+
+std::uint32_t MixRenderer::output_rate() const { return _output_rate; }
+
+void MixRenderer::render_share(std::size_t thread) {
+  for (std::size_t v = thread; v < _voices.size(); v += _threads) {
+    auto block = std::span(_scratch[v].data(), _job_samples);
+    const auto n = _voices[v].render(block);
+    // Voices that ended early are silent for the rest of the song
+    std::fill(block.begin() + static_cast<std::ptrdiff_t>(n), block.end(),
+              0.0f);
+  }
+}
+
+void MixRenderer::add_effect(std::unique_ptr<Effect> effect) {
+  if (_song_samples > 0) {
+    _total_samples = std::max(_total_samples,
+                              _song_samples + effect->tail_samples());
+  }
+  _effects.push_back(std::move(effect));
+}
+
+void MixRenderer::set_output_rate(std::uint32_t rate,
+                                  ResampleQuality quality) {
+  _output_rate = rate;
+  if (rate == kSampleRate) {
+    _resampler.reset();
+    return;
+  }
+  _resampler = std::make_unique<Resampler>(kSampleRate, rate, quality);
+}
+
+void MixRenderer::set_dither(Dither dither) { _quantizer = Quantizer(dither); }
+
+std::size_t MixRenderer::render(std::span<std::int16_t> out) {
+  return render_blocks(out.size(), [&](std::span<const float> block,
+                                       std::size_t at) {
+    _quantizer.to_pcm16(block, out.subspan(at, block.size()));
+  });
+}
+
+std::size_t MixRenderer::render_pcm24(std::span<std::uint8_t> out) {
+  return render_blocks(out.size() / kPcm24Bytes,
+                       [&](std::span<const float> block, std::size_t at) {
+                         _quantizer.to_pcm24(
+                             block, out.subspan(at * kPcm24Bytes,
+                                                block.size() * kPcm24Bytes));
+                       });
+}
+
+template <typename Sink>
+std::size_t MixRenderer::render_blocks(std::size_t samples, Sink &&sink) {
+  std::size_t written = 0;
+  while (written < samples && !done()) {
+    const auto block = next_block(samples - written);
+    if (block.empty())
+      break;
+    // A single voice on its own can't go past full scale, and is left for
+    // the quantizer to round exactly like [MelodyRenderer] would
+    if (_voices.size() > 1 || !_effects.empty())
+      limit(block);
+    sink(block, written);
+    written += block.size();
+  }
+  return written;
+}
+
+std::span<float> MixRenderer::next_block(std::size_t samples) {
+  if (!_resampler) {
+    return mix_block(static_cast<std::size_t>(
+        std::min<std::uint64_t>(samples, _total_samples - _position)));
+  }
+
+  while (_resampled_read == _resampled.size()) {
+    // The first block or so only fills the filter's history
+    _resampled.clear();
+    _resampled_read = 0;
+    if (_position < _total_samples) {
+      _resampler->process(
+          mix_block(static_cast<std::size_t>(_total_samples - _position)),
+          _resampled);
+    }
+    if (_position >= _total_samples) {
+      _resampler->finish(_resampled);
+      if (_resampled.empty())
+        return {};
+    }
+  }
+
+  const auto n = std::min(_resampled.size() - _resampled_read, samples);
+  const auto block = std::span(_resampled.data() + _resampled_read, n);
+  _resampled_read += n;
+  _output_position += n;
+  return block;
+}
+
+std::span<float> MixRenderer::mix_block(std::size_t samples) {
+  _job_samples = std::min(samples, kBlockSamples);
+
+  if (!_workers.empty())
+    _start.arrive_and_wait();
+  render_share(0);
+  if (!_workers.empty())
+    _finish.arrive_and_wait();
+
+  const auto mix = std::span(_mix.data(), _job_samples);
+  sum_voices(mix);
+  for (auto &effect : _effects)
+    effect->process(mix);
+
+  _position += _job_samples;
+  return mix;
+}
+
+void MixRenderer::sum_voices(std::span<float> mix) {
+  std::size_t i = 0;
+#if defined(__SSE2__)
+  for (; i + 4 <= mix.size(); i += 4) {
+    __m128 sum = _mm_loadu_ps(_scratch[0].data() + i);
+    for (std::size_t v = 1; v < _scratch.size(); ++v)
+      sum = _mm_add_ps(sum, _mm_loadu_ps(_scratch[v].data() + i));
+    _mm_storeu_ps(mix.data() + i, sum);
+  }
+#endif
+  for (; i < mix.size(); ++i) {
+    float sum = _scratch[0][i];
+    for (std::size_t v = 1; v < _scratch.size(); ++v)
+      sum += _scratch[v][i];
+    mix[i] = sum;
+  }
+}
+
+void MixRenderer::limit(std::span<float> mix) {
+  std::size_t i = 0;
+#if defined(__SSE2__)
+  const __m128 threshold = _mm_set1_ps(kLimiterThreshold);
+  const __m128 sign_mask = _mm_set1_ps(-0.0f);
+  for (; i + 4 <= mix.size(); i += 4) {
+    const __m128 magnitude =
+        _mm_andnot_ps(sign_mask, _mm_loadu_ps(mix.data() + i));
+    // Rare enough that the limiter itself can stay scalar
+    if (_mm_movemask_ps(_mm_cmpgt_ps(magnitude, threshold)) != 0) {
+      for (std::size_t l = 0; l < 4; ++l)
+        mix[i + l] = soft_limit(mix[i + l]);
+    }
+  }
+#endif
+  for (; i < mix.size(); ++i)
+    mix[i] = soft_limit(mix[i]);
+}
+
+} // namespace Audio
@@ -0,0 +1,185 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "audio/quantizer.hpp"
+
+namespace Audio {
+
+namespace {
+
+constexpr float kPcm16Scale = 32767.0f;
+constexpr float kPcm24Scale = 8388607.0f;
+
+std::uint32_t xorshift(std::uint32_t &x) {
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  return x;
+}
+
+#if !defined(__SSE2__)
+/// Top 23 bits of [bits] as a float in [0, 1).
+float unit(std::uint32_t bits) {
+  const std::uint32_t mantissa = (bits >> 9) | 0x3F800000u;
+  float f;
+  static_assert(sizeof(f) == sizeof(mantissa));
+  std::memcpy(&f, &mantissa, sizeof(f));
+  return f - 1.0f;
+}
+#endif
+
+void store_pcm24(std::uint8_t *out, std::int32_t v) {
+  const auto u = static_cast<std::uint32_t>(v);
+  out[0] = static_cast<std::uint8_t>(u & 0xFFu);
+  out[1] = static_cast<std::uint8_t>((u >> 8) & 0xFFu);
+  out[2] = static_cast<std::uint8_t>((u >> 16) & 0xFFu);
+}
+
+} // namespace
+
+std::optional<Dither> parse_dither(std::string_view name) {
+  if (name == "none")
+    return Dither::None;
+  if (name == "tpdf")
+    return Dither::Tpdf;
+  if (name == "shaped")
+    return Dither::Shaped;
+  return std::nullopt;
+}
+
+Quantizer::Quantizer(Dither dither, std::uint32_t seed) : _dither(dither) {
+  // Distinct nonzero seeds per lane, spread by a round of the generator
+  for (std::size_t l = 0; l < _state.size(); ++l) {
+    _state[l] = seed * 2654435761u + static_cast<std::uint32_t>(l) + 1;
+    if (_state[l] == 0)
+      _state[l] = 0x9E3779B9u;
+    xorshift(_state[l]);
+  }
+}
+
+void Quantizer::fill_noise(std::size_t samples) {
+  _noise.resize((samples + 3) / 4 * 4);
+  std::size_t i = 0;
+#if defined(__SSE2__)
+  __m128i x = _mm_load_si128(reinterpret_cast<const __m128i *>(_state.data()));
+  const __m128i exponent = _mm_set1_epi32(0x3F800000);
+  auto next = [&] {
+    x = _mm_xor_si128(x, _mm_slli_epi32(x, 13));
+    x = _mm_xor_si128(x, _mm_srli_epi32(x, 17));
+    x = _mm_xor_si128(x, _mm_slli_epi32(x, 5));
+    // Uniform in [1, 2): the difference of two is triangular in (-1, 1)
+    return _mm_castsi128_ps(_mm_or_si128(_mm_srli_epi32(x, 9), exponent));
+  };
+  for (; i < _noise.size(); i += 4) {
+    const __m128 a = next();
+    const __m128 b = next();
+    _mm_storeu_ps(_noise.data() + i, _mm_sub_ps(a, b));
+  }
+  _mm_store_si128(reinterpret_cast<__m128i *>(_state.data()), x);
+#else
+  for (; i < _noise.size(); i += 4) {
+    for (std::size_t l = 0; l < 4; ++l) {
+      const float a = unit(xorshift(_state[l]));
+      _noise[i + l] = a - unit(xorshift(_state[l]));
+    }
+  }
+#endif
+}
+
+template <typename Store>
+void Quantizer::shape(std::span<const float> in, float full_scale, float low,
+                      float high, Store &&store) {
+  fill_noise(in.size());
+  for (std::size_t i = 0; i < in.size(); ++i) {
+    const float wanted = in[i] * full_scale - _error;
+    const float q = std::clamp(std::nearbyint(wanted + _noise[i]), low, high);
+    // A clipped sample would feed back a huge error, so cap what carries over
+    _error = std::clamp(q - wanted, -1.0f, 1.0f);
+    store(i, static_cast<std::int32_t>(q));
+  }
+}
+
+void Quantizer::to_pcm16(std::span<const float> in,
+                         std::span<std::int16_t> out) {
+  if (_dither == Dither::Shaped) {
+    shape(in, kPcm16Scale, -32768.0f, 32767.0f,
+          [&](std::size_t i, std::int32_t v) {
+            out[i] = static_cast<std::int16_t>(v);
+          });
+    return;
+  }
+  const bool dithered = _dither == Dither::Tpdf;
+  if (dithered)
+    fill_noise(in.size());
+
+  std::size_t i = 0;
+#if defined(__SSE2__)
+  const __m128 scale = _mm_set1_ps(kPcm16Scale);
+  // Only keeps the conversion to int32 in range, the pack saturates
+  const __m128 low = _mm_set1_ps(-65536.0f);
+  const __m128 high = _mm_set1_ps(65536.0f);
+  for (; i + 8 <= in.size(); i += 8) {
+    __m128 a = _mm_mul_ps(_mm_loadu_ps(in.data() + i), scale);
+    __m128 b = _mm_mul_ps(_mm_loadu_ps(in.data() + i + 4), scale);
+    if (dithered) {
+      a = _mm_add_ps(a, _mm_loadu_ps(_noise.data() + i));
+      b = _mm_add_ps(b, _mm_loadu_ps(_noise.data() + i + 4));
+    }
+    a = _mm_min_ps(_mm_max_ps(a, low), high);
+    b = _mm_min_ps(_mm_max_ps(b, low), high);
+    // Rounds to nearest under the default MXCSR
+    const __m128i packed =
+        _mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out.data() + i), packed);
+  }
+#endif
+  for (; i < in.size(); ++i) {
+    const float x = in[i] * kPcm16Scale + (dithered ? _noise[i] : 0.0f);
+    out[i] = static_cast<std::int16_t>(
+        std::clamp(std::nearbyint(x), -32768.0f, 32767.0f));
+  }
+}
+
+void Quantizer::to_pcm24(std::span<const float> in,
+                         std::span<std::uint8_t> out) {
+  if (_dither == Dither::Shaped) {
+    shape(in, kPcm24Scale, -8388608.0f, 8388607.0f,
+          [&](std::size_t i, std::int32_t v) {
+            store_pcm24(out.data() + i * kPcm24Bytes, v);
+          });
+    return;
+  }
+  const bool dithered = _dither == Dither::Tpdf;
+  if (dithered)
+    fill_noise(in.size());
+
+  std::size_t i = 0;
+#if defined(__SSE2__)
+  const __m128 scale = _mm_set1_ps(kPcm24Scale);
+  const __m128 low = _mm_set1_ps(-8388608.0f);
+  const __m128 high = _mm_set1_ps(8388607.0f);
+  alignas(16) std::int32_t v[4];
+  for (; i + 4 <= in.size(); i += 4) {
+    __m128 x = _mm_mul_ps(_mm_loadu_ps(in.data() + i), scale);
+    if (dithered)
+      x = _mm_add_ps(x, _mm_loadu_ps(_noise.data() + i));
+    x = _mm_min_ps(_mm_max_ps(x, low), high);
+    _mm_store_si128(reinterpret_cast<__m128i *>(v), _mm_cvtps_epi32(x));
+    for (std::size_t l = 0; l < 4; ++l)
+      store_pcm24(out.data() + (i + l) * kPcm24Bytes, v[l]);
+  }
+#endif
+  for (; i < in.size(); ++i) {
+    const float x = in[i] * kPcm24Scale + (dithered ? _noise[i] : 0.0f);
+    store_pcm24(out.data() + i * kPcm24Bytes,
+                static_cast<std::int32_t>(
+                    std::clamp(std::nearbyint(x), -8388608.0f, 8388607.0f)));
+  }
+}
+
+} // namespace Audio
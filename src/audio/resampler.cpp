@@ -0,0 +1,170 @@
+#include <cmath>
+#include <numbers>
+#include <numeric>
+#include <stdexcept>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "audio/resampler.hpp"
+
+namespace Audio {
+
+namespace {
+
+struct QualityParams {
+  std::size_t half_taps;
+  double cutoff; // of the lower Nyquist
+  double beta;   // Kaiser window shape
+};
+
+QualityParams quality_params(ResampleQuality quality) {
+  switch (quality) {
+  case ResampleQuality::Fast:
+    return {4, 0.85, 5.0};
+  case ResampleQuality::Standard:
+    return {16, 0.92, 8.0};
+  case ResampleQuality::Best:
+    return {32, 0.95, 10.0};
+  }
+  return {16, 0.92, 8.0};
+}
+
+/// Zeroth order modified Bessel function of the first kind, by its series.
+double bessel_i0(double x) {
+  double sum = 1.0;
+  double term = 1.0;
+  for (int k = 1; k < 50; ++k) {
+    term *= (x / (2.0 * k)) * (x / (2.0 * k));
+    sum += term;
+    if (term < sum * 1e-17)
+      break;
+  }
+  return sum;
+}
+
+float dot(const float *a, const float *b, std::size_t n) {
+  std::size_t i = 0;
+  float sum = 0.0f;
+#if defined(__SSE2__)
+  __m128 acc = _mm_setzero_ps();
+  for (; i + 4 <= n; i += 4)
+    acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+  acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+  acc = _mm_add_ss(acc, _mm_shuffle_ps(acc, acc, 1));
+  sum = _mm_cvtss_f32(acc);
+#endif
+  for (; i < n; ++i)
+    sum += a[i] * b[i];
+  return sum;
+}
+
+} // namespace
+
+std::optional<ResampleQuality> parse_resample_quality(std::string_view name) {
+  if (name == "fast")
+    return ResampleQuality::Fast;
+  if (name == "standard")
+    return ResampleQuality::Standard;
+  if (name == "best")
+    return ResampleQuality::Best;
+  return std::nullopt;
+}
+
+Resampler::Resampler(std::uint32_t in_rate, std::uint32_t out_rate,
+                     ResampleQuality quality) {
+  if (in_rate == 0 || out_rate == 0)
+    throw std::runtime_error("Sample rates must be positive");
+  const auto common = std::gcd(in_rate, out_rate);
+  _up = out_rate / common;
+  _down = in_rate / common;
+  _phases = static_cast<std::size_t>(
+      std::min<std::uint64_t>(_up, kMaxPhases));
+
+  // Going down in rate, the cutoff drops and the sinc widens with it
+  const auto params = quality_params(quality);
+  const double ratio = std::min(1.0, static_cast<double>(out_rate) /
+                                         static_cast<double>(in_rate));
+  const double cutoff = params.cutoff * ratio;
+  std::size_t half = static_cast<std::size_t>(
+      std::ceil(static_cast<double>(params.half_taps) / ratio));
+  half = (half + 1) / 2 * 2; // whole SSE registers
+  _taps = 2 * half;
+
+  // Table p holds the taps for an output p / _phases of the way past the
+  // centre tap; the extra last one saves wrapping around when rounding up
+  const double window_norm = bessel_i0(params.beta);
+  _coefficients.resize((_phases + 1) * _taps);
+  std::vector<double> taps(_taps);
+  for (std::size_t p = 0; p <= _phases; ++p) {
+    const double frac = static_cast<double>(p) / static_cast<double>(_phases);
+    auto *table = _coefficients.data() + p * _taps;
+    double sum = 0.0;
+    for (std::size_t k = 0; k < _taps; ++k) {
+      const double d = static_cast<double>(k) -
+                       static_cast<double>(half - 1) - frac;
+      const double x = cutoff * d;
+      const double sinc =
+          x == 0.0 ? 1.0
+                   : std::sin(std::numbers::pi * x) / (std::numbers::pi * x);
+      const double w = d / static_cast<double>(half);
+      const double window =
+          std::abs(w) >= 1.0
+              ? 0.0
+              : bessel_i0(params.beta * std::sqrt(1.0 - w * w)) / window_norm;
+      taps[k] = sinc * window;
+      sum += taps[k];
+    }
+    // Unity gain at DC for every phase
+    for (std::size_t k = 0; k < _taps; ++k)
+      table[k] = static_cast<float>(taps[k] / sum);
+  }
+
+  // Output 0 is centred on input 0, so the taps before it read silence
+  _history.assign(half - 1, 0.0f);
+}
+
+std::uint64_t Resampler::output_samples(std::uint64_t input,
+                                        std::uint32_t in_rate,
+                                        std::uint32_t out_rate) {
+  const auto common = std::gcd(in_rate, out_rate);
+  const std::uint64_t up = out_rate / common;
+  const std::uint64_t down = in_rate / common;
+  return (input * up + down - 1) / down;
+}
+
+std::size_t Resampler::taps() const { return _taps; }
+
+void Resampler::drain(std::vector<float> &out, std::uint64_t limit) {
+  while (_produced < limit && _start + _taps <= _history.size()) {
+    const auto phase = static_cast<std::size_t>(
+        (_frac * _phases + _up / 2) / _up);
+    out.push_back(dot(_history.data() + _start,
+                      _coefficients.data() + phase * _taps, _taps));
+    ++_produced;
+
+    _frac += _down;
+    _start += static_cast<std::size_t>(_frac / _up);
+    _frac %= _up;
+  }
+
+  // Keep only what the next outputs will still read
+  const auto used = std::min(_start, _history.size());
+  _history.erase(_history.begin(),
+                 _history.begin() + static_cast<std::ptrdiff_t>(used));
+  _start -= used;
+}
+
+void Resampler::process(std::span<const float> in, std::vector<float> &out) {
+  _history.insert(_history.end(), in.begin(), in.end());
+  _consumed += in.size();
+  drain(out, (_consumed * _up + _down - 1) / _down);
+}
+
+void Resampler::finish(std::vector<float> &out) {
+  _history.insert(_history.end(), _taps, 0.0f);
+  drain(out, (_consumed * _up + _down - 1) / _down);
+}
+
+} // namespace Audio
@@ -0,0 +1,136 @@
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "audio/pcm_format.hpp"
+#include "audio/reverb.hpp"
+
+namespace Audio {
+
+std::vector<float> synthetic_impulse_response(double rt60_s,
+                                              std::uint32_t seed) {
+  const auto sr = static_cast<double>(kSampleRate);
+  const auto length = static_cast<std::size_t>(std::max(0.0, rt60_s) * sr);
+  std::vector<float> ir(length);
+
+  std::minstd_rand rng(seed);
+  std::uniform_real_distribution<double> noise(-1.0, 1.0);
+  // ln(1000): -60dB in amplitude
+  const double rate = 6.907755278982137 / (std::max(rt60_s, 1e-3) * sr);
+  double energy = 0.0;
+  for (std::size_t i = 0; i < length; ++i) {
+    const double v = noise(rng) * std::exp(-rate * static_cast<double>(i));
+    ir[i] = static_cast<float>(v);
+    energy += v * v;
+  }
+
+  if (energy > 0.0) {
+    const auto scale = static_cast<float>(1.0 / std::sqrt(energy));
+    for (auto &v : ir)
+      v *= scale;
+  }
+  return ir;
+}
+
+ConvolutionReverb::ConvolutionReverb(const ReverbSettings &settings,
+                                     std::size_t partition)
+    : _partition(partition), _fft(2 * partition), _bins(_fft.bins()),
+      _partitions(std::max<std::size_t>(
+          1, (settings.impulse_response.size() + partition - 1) / partition)),
+      _ir_length(settings.impulse_response.size()),
+      _wet_gain(settings.wet), _dry_gain(settings.dry),
+      _ir_re(_partitions * _bins), _ir_im(_partitions * _bins),
+      _fdl_re(_partitions * _bins), _fdl_im(_partitions * _bins),
+      _window(2 * partition), _wet(partition), _acc_re(_bins),
+      _acc_im(_bins), _time(2 * partition) {
+  // Each partition sits in the first half of an otherwise silent window, so
+  // overlap-save leaves the linear convolution in the output's second half
+  const auto &ir = settings.impulse_response;
+  for (std::size_t p = 0; p < _partitions; ++p) {
+    std::fill(_time.begin(), _time.end(), 0.0f);
+    const auto begin = std::min(ir.size(), p * partition);
+    const auto end = std::min(ir.size(), begin + partition);
+    std::copy(ir.begin() + static_cast<std::ptrdiff_t>(begin),
+              ir.begin() + static_cast<std::ptrdiff_t>(end), _time.begin());
+    _fft.forward(_time, std::span(_ir_re.data() + p * _bins, _bins),
+                 std::span(_ir_im.data() + p * _bins, _bins));
+  }
+}
+
+std::size_t ConvolutionReverb::tail_samples() const {
+  return _ir_length + _partition;
+}
+
+void ConvolutionReverb::process(std::span<float> block) {
+  std::size_t i = 0;
+  while (i < block.size()) {
+    const auto n = std::min(block.size() - i, _partition - _fill);
+    float *dry = _window.data() + _partition + _fill;
+    const float *wet = _wet.data() + _fill;
+    for (std::size_t j = 0; j < n; ++j) {
+      const float x = block[i + j];
+      dry[j] = x;
+      block[i + j] = _dry_gain * x + _wet_gain * wet[j];
+    }
+    i += n;
+    _fill += n;
+
+    if (_fill == _partition) {
+      run_partition();
+      _fill = 0;
+    }
+  }
+}
+
+void ConvolutionReverb::run_partition() {
+  // Newest input spectrum goes in front of the delay line
+  _head = (_head + _partitions - 1) % _partitions;
+  _fft.forward(_window, std::span(_fdl_re.data() + _head * _bins, _bins),
+               std::span(_fdl_im.data() + _head * _bins, _bins));
+
+  std::fill(_acc_re.begin(), _acc_re.end(), 0.0f);
+  std::fill(_acc_im.begin(), _acc_im.end(), 0.0f);
+  for (std::size_t p = 0; p < _partitions; ++p) {
+    const auto slot = (_head + p) % _partitions;
+    const float *xr = _fdl_re.data() + slot * _bins;
+    const float *xi = _fdl_im.data() + slot * _bins;
+    const float *hr = _ir_re.data() + p * _bins;
+    const float *hi = _ir_im.data() + p * _bins;
+    float *yr = _acc_re.data();
+    float *yi = _acc_im.data();
+
+    std::size_t k = 0;
+#if defined(__SSE2__)
+    for (; k + 4 <= _bins; k += 4) {
+      const __m128 ar = _mm_loadu_ps(xr + k), ai = _mm_loadu_ps(xi + k);
+      const __m128 br = _mm_loadu_ps(hr + k), bi = _mm_loadu_ps(hi + k);
+      _mm_storeu_ps(yr + k,
+                    _mm_add_ps(_mm_loadu_ps(yr + k),
+                               _mm_sub_ps(_mm_mul_ps(ar, br),
+                                          _mm_mul_ps(ai, bi))));
+      _mm_storeu_ps(yi + k,
+                    _mm_add_ps(_mm_loadu_ps(yi + k),
+                               _mm_add_ps(_mm_mul_ps(ar, bi),
+                                          _mm_mul_ps(ai, br))));
+    }
+#endif
+    for (; k < _bins; ++k) {
+      yr[k] += xr[k] * hr[k] - xi[k] * hi[k];
+      yi[k] += xr[k] * hi[k] + xi[k] * hr[k];
+    }
+  }
+
+  _fft.inverse(_acc_re, _acc_im, _time);
+  std::copy(_time.begin() + static_cast<std::ptrdiff_t>(_partition),
+            _time.end(), _wet.begin());
+
+  // This partition becomes the first half of the next window
+  std::copy(_window.begin() + static_cast<std::ptrdiff_t>(_partition),
+            _window.end(), _window.begin());
+}
+
+} // namespace Audio
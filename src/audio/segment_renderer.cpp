@@ -0,0 +1,98 @@
+#include <algorithm>
+
+#include "audio/mix_renderer.hpp"
+#include "audio/segment_renderer.hpp"
+
+namespace Audio {
+
+SegmentRenderer::SegmentRenderer(std::span<const Voice> voices,
+                                 double amplitude, const Adsr &envelope,
+                                 Timbre timbre)
+    : _voices(voices), _amplitude(amplitude), _envelope(envelope),
+      _timbre(timbre) {
+  _starts.reserve(voices.size());
+  for (const auto &voice : voices) {
+    auto &starts = _starts.emplace_back();
+    starts.reserve(voice.size());
+    std::uint64_t at = 0;
+    for (const auto &note : voice) {
+      starts.push_back(at);
+      at += static_cast<std::uint64_t>(note_samples(note));
+    }
+  }
+  _scratch.assign(voices.size(),
+                  std::vector<float>(MixRenderer::kBlockSamples));
+  _mix.resize(MixRenderer::kBlockSamples);
+  seek(0);
+}
+
+void SegmentRenderer::render(std::uint64_t start,
+                             std::span<std::int16_t> out) {
+  render_range(start, out.size(),
+               [&](std::span<const float> block, std::size_t at) {
+                 _quantizer.to_pcm16(block, out.subspan(at, block.size()));
+               });
+}
+
+void SegmentRenderer::render_pcm24(std::uint64_t start,
+                                   std::span<std::uint8_t> out) {
+  render_range(start, out.size() / kPcm24Bytes,
+               [&](std::span<const float> block, std::size_t at) {
+                 _quantizer.to_pcm24(
+                     block, out.subspan(at * kPcm24Bytes,
+                                        block.size() * kPcm24Bytes));
+               });
+}
+
+void SegmentRenderer::seek(std::uint64_t start) {
+  // Every voice picks up at the note playing at [start]; voices that are
+  // over by then stay empty and contribute silence
+  _renderers.clear();
+  _renderers.resize(_voices.size());
+  for (std::size_t v = 0; v < _voices.size(); ++v) {
+    const auto &starts = _starts[v];
+    const auto next = std::upper_bound(starts.begin(), starts.end(), start);
+    if (next == starts.begin())
+      continue;
+    const auto note = static_cast<std::size_t>(next - starts.begin() - 1);
+    auto &renderer = _renderers[v].emplace(
+        std::span(_voices[v]).subspan(note), _amplitude, _envelope, _timbre);
+    for (auto skip = start - starts[note]; skip > 0 && !renderer.done();) {
+      const auto n = static_cast<std::size_t>(
+          std::min<std::uint64_t>(skip, _scratch[v].size()));
+      renderer.render(std::span(_scratch[v].data(), n));
+      skip -= n;
+    }
+  }
+  _position = start;
+}
+
+template <typename Sink>
+void SegmentRenderer::render_range(std::uint64_t start, std::size_t samples,
+                                   Sink &&sink) {
+  if (start != _position)
+    seek(start);
+
+  for (std::size_t done = 0; done < samples;) {
+    const auto n = std::min(samples - done, MixRenderer::kBlockSamples);
+    const auto mix = std::span(_mix.data(), n);
+    std::fill(mix.begin(), mix.end(), 0.0f);
+
+    // Summed in voice order, like [MixRenderer], so the floats match exactly
+    for (std::size_t v = 0; v < _renderers.size(); ++v) {
+      const auto block = std::span(_scratch[v].data(), n);
+      const auto written = _renderers[v] ? _renderers[v]->render(block) : 0;
+      std::fill(block.begin() + static_cast<std::ptrdiff_t>(written),
+                block.end(), 0.0f);
+      for (std::size_t i = 0; i < n; ++i)
+        mix[i] = v == 0 ? block[i] : mix[i] + block[i];
+    }
+
+    MixRenderer::limit(mix);
+    sink(std::span<const float>(mix), done);
+    done += n;
+  }
+  _position = start + samples;
+}
+
+} // namespace Audio
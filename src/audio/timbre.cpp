@@ -0,0 +1,89 @@
+#include <array>
+
+#include "audio/timbre.hpp"
+
+namespace Audio {
+
+namespace {
+
+// Drawbar style: the fundamental plus a handful of octaves and fifths above it
+constexpr std::array kOrgan{
+    Partial{1.0, 1.0, 0.0},   Partial{2.0, 0.5, 0.0},
+    Partial{3.0, 0.35, 0.0},  Partial{4.0, 0.25, 0.0},
+    Partial{6.0, 0.15, 0.0},  Partial{8.0, 0.12, 0.0},
+    Partial{10.0, 0.06, 0.0}, Partial{12.0, 0.05, 0.0},
+    Partial{16.0, 0.04, 0.0},
+};
+
+// The first 16 odd harmonics at 1/k, i.e. a square wave cut off early
+constexpr std::array kSoftSquare{
+    Partial{1.0, 1.0, 0.0},         Partial{3.0, 1.0 / 3.0, 0.0},
+    Partial{5.0, 1.0 / 5.0, 0.0},   Partial{7.0, 1.0 / 7.0, 0.0},
+    Partial{9.0, 1.0 / 9.0, 0.0},   Partial{11.0, 1.0 / 11.0, 0.0},
+    Partial{13.0, 1.0 / 13.0, 0.0}, Partial{15.0, 1.0 / 15.0, 0.0},
+    Partial{17.0, 1.0 / 17.0, 0.0}, Partial{19.0, 1.0 / 19.0, 0.0},
+    Partial{21.0, 1.0 / 21.0, 0.0}, Partial{23.0, 1.0 / 23.0, 0.0},
+    Partial{25.0, 1.0 / 25.0, 0.0}, Partial{27.0, 1.0 / 27.0, 0.0},
+    Partial{29.0, 1.0 / 29.0, 0.0}, Partial{31.0, 1.0 / 31.0, 0.0},
+};
+
+// Risset's bell: the higher partials ring for a shorter time
+constexpr std::array kBell{
+    Partial{0.56, 1.0, 1.2},   Partial{0.92, 0.67, 0.9},
+    Partial{1.19, 1.0, 0.65},  Partial{1.71, 1.8, 0.55},
+    Partial{2.0, 2.67, 0.33},  Partial{2.74, 1.67, 0.3},
+    Partial{3.0, 1.46, 0.25},  Partial{3.76, 1.33, 0.2},
+    Partial{4.07, 1.33, 0.15},
+};
+
+} // namespace
+
+std::span<const Partial> timbre_partials(Timbre timbre) {
+  switch (timbre) {
+  case Timbre::Sine:
+    return {};
+  case Timbre::Organ:
+    return kOrgan;
+  case Timbre::SoftSquare:
+    return kSoftSquare;
+  case Timbre::Bell:
+    return kBell;
+  case Timbre::Saw:
+  case Timbre::Square:
+  case Timbre::Triangle:
+    return {};
+  }
+  return {};
+}
+
+std::optional<Timbre> parse_timbre(std::string_view name) {
+  for (const auto timbre :
+       {Timbre::Sine, Timbre::Organ, Timbre::SoftSquare, Timbre::Bell,
+        Timbre::Saw, Timbre::Square, Timbre::Triangle}) {
+    if (name == timbre_name(timbre))
+      return timbre;
+  }
+  return std::nullopt;
+}
+
+std::string_view timbre_name(Timbre timbre) {
+  switch (timbre) {
+  case Timbre::Sine:
+    return "sine";
+  case Timbre::Organ:
+    return "organ";
+  case Timbre::SoftSquare:
+    return "soft-square";
+  case Timbre::Bell:
+    return "bell";
+  case Timbre::Saw:
+    return "saw";
+  case Timbre::Square:
+    return "square";
+  case Timbre::Triangle:
+    return "triangle";
+  }
+  return "unknown";
+}
+
+} // namespace Audio
@@ -0,0 +1,110 @@
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+#include "audio/wav_reader.hpp"
+
+namespace Audio {
+
+namespace {
+
+constexpr std::uint16_t kFormatPcm = 1;
+constexpr std::uint16_t kFormatFloat = 3;
+constexpr std::uint16_t kFormatExtensible = 0xfffe;
+
+std::uint32_t load_le(const unsigned char *p, std::size_t bytes) {
+  std::uint32_t v = 0;
+  for (std::size_t i = 0; i < bytes; ++i)
+    v |= static_cast<std::uint32_t>(p[i]) << (8 * i);
+  return v;
+}
+
+/// One sample of [bits] bits at [p] as a float in [-1, 1].
+float decode(const unsigned char *p, std::uint16_t format,
+             std::uint16_t bits) {
+  if (format == kFormatFloat) {
+    const auto raw = load_le(p, 4);
+    float v;
+    std::memcpy(&v, &raw, sizeof(v));
+    return v;
+  }
+  const auto bytes = bits / 8u;
+  const auto raw = load_le(p, bytes);
+  // Sign extend from the sample's top bit
+  const auto shift = 32u - bits;
+  const auto value = static_cast<std::int32_t>(raw << shift) >> shift;
+  return static_cast<float>(value) /
+         static_cast<float>(std::uint32_t{1} << (bits - 1));
+}
+
+} // namespace
+
+WavData read_wav_mono(const std::filesystem::path &path) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in)
+    throw std::runtime_error("Failed to open file: " + path.string());
+
+  const auto fail = [&path](const std::string &why) {
+    return std::runtime_error("Unsupported WAV file " + path.string() + ": " +
+                              why);
+  };
+
+  unsigned char riff[12];
+  if (!in.read(reinterpret_cast<char *>(riff), sizeof(riff)) ||
+      std::memcmp(riff, "RIFF", 4) != 0 ||
+      std::memcmp(riff + 8, "WAVE", 4) != 0)
+    throw fail("not a RIFF/WAVE file");
+
+  std::uint16_t format = 0, channels = 0, bits = 0;
+  WavData wav;
+  bool have_format = false;
+  while (true) {
+    unsigned char header[8];
+    if (!in.read(reinterpret_cast<char *>(header), sizeof(header)))
+      throw fail("no data chunk");
+    const auto size = load_le(header + 4, 4);
+
+    if (std::memcmp(header, "fmt ", 4) == 0) {
+      std::vector<unsigned char> fmt(size);
+      if (size < 16 ||
+          !in.read(reinterpret_cast<char *>(fmt.data()), size))
+        throw fail("truncated fmt chunk");
+      format = static_cast<std::uint16_t>(load_le(fmt.data(), 2));
+      channels = static_cast<std::uint16_t>(load_le(fmt.data() + 2, 2));
+      wav.sample_rate = load_le(fmt.data() + 4, 4);
+      bits = static_cast<std::uint16_t>(load_le(fmt.data() + 14, 2));
+      if (format == kFormatExtensible && size >= 26)
+        format = static_cast<std::uint16_t>(load_le(fmt.data() + 24, 2));
+      have_format = true;
+    } else if (std::memcmp(header, "data", 4) == 0) {
+      if (!have_format)
+        throw fail("data before fmt");
+      const bool pcm = format == kFormatPcm && (bits == 16 || bits == 24);
+      const bool flt = format == kFormatFloat && bits == 32;
+      if ((!pcm && !flt) || channels == 0)
+        throw fail("only PCM16, PCM24 and float32 are supported");
+
+      const std::size_t frame = channels * (bits / 8u);
+      std::vector<unsigned char> data(size - size % frame);
+      in.read(reinterpret_cast<char *>(data.data()),
+              static_cast<std::streamsize>(data.size()));
+      data.resize(static_cast<std::size_t>(in.gcount()) / frame * frame);
+
+      wav.samples.resize(data.size() / frame);
+      for (std::size_t i = 0; i < wav.samples.size(); ++i) {
+        float sum = 0.0f;
+        for (std::size_t c = 0; c < channels; ++c)
+          sum += decode(data.data() + i * frame + c * (bits / 8u), format,
+                        bits);
+        wav.samples[i] = sum / static_cast<float>(channels);
+      }
+      return wav;
+    } else {
+      // Chunks are padded to an even size
+      in.seekg(size + (size & 1u), std::ios::cur);
+    }
+  }
+}
+
+} // namespace Audio
@@ -1,22 +1,16 @@
-#include <algorithm>
 #include <array>
-#include <cmath>
 #include <fstream>
-#include <iostream>
+#include <limits>
+#include <span>
+#include <stdexcept>
 
+#include "audio/melody_renderer.hpp"
 #include "audio/note_info.hpp"
+#include "audio/pcm_format.hpp"
 #include "audio/wav_writer.hpp"
 
 namespace Audio {
 
-constexpr std::uint32_t kSampleRate = 44'100;
-constexpr std::uint16_t kChannels = 1;
-constexpr std::uint16_t kBitsPerSample = 16;
-constexpr std::uint16_t kBytesPerSample = kBitsPerSample / 8;
-constexpr std::uint16_t kBlockAlign = static_cast<std::uint16_t>(
-    kChannels * kBytesPerSample); // bytes per audio frame
-constexpr std::uint32_t kByteRate = kSampleRate * kBlockAlign;
-
 inline void write_bytes(std::ostream &os, const void *data, std::size_t n) {
   os.write(static_cast<const char *>(data), static_cast<std::streamsize>(n));
   if (!os)
@@ -48,11 +42,55 @@ inline void write_tag(std::ostream &os, const char (&tag)[5]) {
   write_bytes(os, tag, 4);
 }
 
-inline void write_pcm16_mono_header(std::ostream &os,
-                                    std::uint32_t num_samples) {
+inline void write_u64_le(std::ostream &os, std::uint64_t v) {
+  write_u32_le(os, static_cast<std::uint32_t>(v & 0xFFFFFFFFu));
+  write_u32_le(os, static_cast<std::uint32_t>(v >> 32));
+}
+
+namespace {
+
+// Size of the ds64 chunk payload: RIFF size, data size, sample count and an
+// empty chunk size table.
+constexpr std::uint32_t kDs64Bytes = 28;
+constexpr std::size_t kRf64HeaderBytes = kWavHeaderBytes + 8 + kDs64Bytes;
+
+bool needs_rf64(std::uint64_t num_samples,
+                std::uint16_t bits_per_sample = kBitsPerSample) {
+  const std::uint64_t data_bytes = num_samples * (bits_per_sample / 8u);
+  return 36u + data_bytes > std::numeric_limits<std::uint32_t>::max();
+}
+
+} // namespace
+
+std::size_t wav_header_bytes(std::uint64_t num_samples,
+                             std::uint16_t bits_per_sample) {
+  return needs_rf64(num_samples, bits_per_sample) ? kRf64HeaderBytes
+                                                  : kWavHeaderBytes;
+}
+
+std::uint64_t wav_samples_in_file(std::uint64_t file_bytes) {
+  if (file_bytes < kWavHeaderBytes)
+    return 0;
+  const auto riff = (file_bytes - kWavHeaderBytes) / kBlockAlign;
+  if (!needs_rf64(riff))
+    return riff;
+  return (file_bytes - kRf64HeaderBytes) / kBlockAlign;
+}
+
+namespace {
+
+/// Writes the header for [num_samples] samples. Files that don't fit the
+/// 32 bit RIFF size fields become RF64 (EBU Tech 3306): the sizes move into a
+/// "ds64" chunk and the 32 bit fields are set to 0xFFFFFFFF.
+void write_header(std::ostream &os, std::uint64_t num_samples,
+                  std::uint32_t sample_rate, std::uint16_t bits_per_sample) {
+  const bool rf64 = needs_rf64(num_samples, bits_per_sample);
+
   // "data" chunk size is the number of bytes of sample payload.
-  // mono PCM16 => 2 bytes per sample.
-  const std::uint32_t data_bytes = num_samples * kBlockAlign;
+  // mono PCM16 => 2 bytes per sample, PCM24 => 3.
+  const auto block_align =
+      static_cast<std::uint16_t>(kChannels * (bits_per_sample / 8u));
+  const std::uint64_t data_bytes = num_samples * block_align;
 
   // RIFF chunk size is file size minus 8 bytes (the "RIFF" tag + this size
   // field). A PCM WAV header before the data payload is 44 bytes total, i.e.:
@@ -60,92 +98,97 @@ inline void write_pcm16_mono_header(std::ostream &os,
   // + 24 bytes fmt chunk ("fmt "+size+fmtdata)
   // + 8 bytes data header ("data"+datasize)
   // => 44 bytes
-  const std::uint32_t riff_chunk_size = 36u + data_bytes;
+  // plus another 36 bytes for the ds64 chunk.
+  const std::uint64_t riff_chunk_size =
+      (rf64 ? 36u + 8u + kDs64Bytes : 36u) + data_bytes;
+  constexpr std::uint32_t kSizeInDs64 = 0xFFFFFFFFu;
 
   // --- RIFF container header ---
-  write_tag(os, "RIFF");
-  write_u32_le(os, riff_chunk_size);
+  if (rf64) {
+    write_tag(os, "RF64");
+    write_u32_le(os, kSizeInDs64);
+  } else {
+    write_tag(os, "RIFF");
+    write_u32_le(os, static_cast<std::uint32_t>(riff_chunk_size));
+  }
   write_tag(os, "WAVE");
 
+  // --- ds64 chunk (64 bit sizes) ---
+  if (rf64) {
+    write_tag(os, "ds64");
+    write_u32_le(os, kDs64Bytes);
+    write_u64_le(os, riff_chunk_size);
+    write_u64_le(os, data_bytes);
+    write_u64_le(os, num_samples); // sample frames, mono => samples
+    write_u32_le(os, 0);           // no table entries
+  }
+
   // --- fmt chunk (describes how to interpret the sample bytes) ---
+  const std::uint32_t byte_rate = sample_rate * block_align;
   write_tag(os, "fmt ");
   write_u32_le(os, 16);             // PCM fmt chunk payload size (always 16)
   write_u16_le(os, 1);              // AudioFormat = 1 (PCM Integer)
   write_u16_le(os, kChannels);      // NumChannels
-  write_u32_le(os, kSampleRate);    // SampleRate
-  write_u32_le(os, kByteRate);      // ByteRate = SampleRate * BlockAlign
-  write_u16_le(os, kBlockAlign);    // BlockAlign = NumChannels * BytesPerSample
-  write_u16_le(os, kBitsPerSample); // BitsPerSample
+  write_u32_le(os, sample_rate);    // SampleRate
+  write_u32_le(os, byte_rate);      // ByteRate = SampleRate * BlockAlign
+  write_u16_le(os, block_align);    // BlockAlign = NumChannels * BytesPerSample
+  write_u16_le(os, bits_per_sample); // BitsPerSample
 
   // --- data chunk header ---
   write_tag(os, "data");
-  write_u32_le(os, data_bytes);
+  write_u32_le(os, rf64 ? kSizeInDs64 : static_cast<std::uint32_t>(data_bytes));
 }
 
-void write_pcm16_mono_wav(const std::string &path,
-                          const std::vector<std::int16_t> &samples) {
-
-  std::ofstream out(path, std::ios::binary);
-  if (!out)
-    throw std::runtime_error("Failed to open output file: " + path);
-
-  write_pcm16_mono_header(out, static_cast<std::uint32_t>(samples.size()));
-
+void write_pcm16_samples(std::ostream &os,
+                         std::span<const std::int16_t> samples) {
   // We can write sample bytes directly because PCM16 payload is just
   // little-endian i16. However, host endianness might be big-endian on some
   // (probably exotic) systems. If we want total portability, we should probably
   // write each sample via write_u16_le instead.
 #if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
   for (std::int16_t s : samples)
-    write_u16_le(out, static_cast<std::uint16_t>(s));
+    write_u16_le(os, static_cast<std::uint16_t>(s));
 #else
-  write_bytes(out, samples.data(), samples.size() * sizeof(std::int16_t));
+  write_bytes(os, samples.data(), samples.size() * sizeof(std::int16_t));
 #endif
 }
 
-std::vector<std::int16_t> encode_melody(const std::vector<NoteInfo *> &notes,
-                                        double amplitude, double fade_s) {
+} // namespace
 
-  if (amplitude < 0.0 || amplitude > 1.0) {
-    std::cerr << "Amplitude must be in [0,1] range." << std::endl;
-  }
+void write_pcm16_mono_header(std::ostream &os, std::uint64_t num_samples,
+                             std::uint32_t sample_rate) {
+  write_header(os, num_samples, sample_rate, kBitsPerSample);
+}
 
-  const auto sr = static_cast<double>(kSampleRate);
-  const int fade_samples = std::max(0, static_cast<int>(fade_s * sr));
-
-  std::vector<std::int16_t> out;
-  out.reserve(1'000'000); // cheap guess; not required
-
-  constexpr double tau = 2.0 * std::numbers::pi;
-
-  for (const auto &n : notes) {
-    const int n_samples = std::max(0, static_cast<int>(n->dur_s * sr));
-    for (int i = 0; i < n_samples; ++i) {
-      // Envelope to avoiod hard incontinuities (clicks)
-      double env = 1.0;
-      if (fade_samples > 0) {
-        if (i < fade_samples)
-          env = static_cast<double>(i) / fade_samples;
-        if (n_samples - i - 1 < fade_samples) {
-          env = std::min(env,
-                         static_cast<double>(n_samples - i - 1) / fade_samples);
-        }
-        env = std::clamp(env, 0.0, 1.0);
-      }
-
-      double sample = 0.0;
-      if (n->freq_hz > 0.0) {
-        const double t = static_cast<double>(i) / sr;
-        sample = std::sin(tau * n->freq_hz * t);
-      }
-
-      const double x = amplitude * env * sample;
-      const double scaled =
-          x * static_cast<double>(std::numeric_limits<std::int16_t>::max());
-      out.push_back(static_cast<std::int16_t>(scaled));
-    }
+void write_pcm_mono_header(std::ostream &os, std::uint64_t num_samples,
+                           std::uint32_t sample_rate,
+                           std::uint16_t bits_per_sample) {
+  write_header(os, num_samples, sample_rate, bits_per_sample);
+}
+
+void write_pcm16_mono_wav(const std::string &path,
+                          const std::vector<std::int16_t> &samples) {
+
+  std::ofstream out(path, std::ios::binary);
+  if (!out)
+    throw std::runtime_error("Failed to open output file: " + path);
+
+  write_pcm16_mono_header(out, samples.size());
+  write_pcm16_samples(out, samples);
+}
+
+std::vector<std::int16_t>
+encode_melody(const std::vector<NoteInfo> &notes, double amplitude,
+              double fade_s,
+              const std::function<void(std::string_view)> &on_warning) {
+  if ((amplitude < 0.0 || amplitude > 1.0) && on_warning) {
+    on_warning("Amplitude must be in [0,1] range.");
   }
 
+  MelodyRenderer renderer(notes, amplitude, fade_envelope(fade_s));
+  std::vector<std::int16_t> out(renderer.total_samples());
+  renderer.render(out);
+
   return out;
 }
 
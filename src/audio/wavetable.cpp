@@ -0,0 +1,226 @@
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <numbers>
+#include <string>
+
+#include <unistd.h>
+
+#include "audio/pcm_format.hpp"
+#include "audio/wavetable.hpp"
+
+namespace Audio {
+
+namespace {
+
+constexpr std::uint32_t kBlobMagic = 0x5457474d; // "MGWT" little endian
+constexpr std::uint32_t kBlobVersion = 1;
+
+struct BlobHeader {
+  std::uint32_t magic;
+  std::uint32_t version;
+  std::uint32_t table_size;
+  std::uint32_t octaves;
+  std::uint32_t waveforms;
+  std::uint32_t sample_rate;
+};
+
+/// Fourier coefficient of harmonic [h] (of the sine series) for [waveform].
+double harmonic_gain(Waveform waveform, std::size_t h) {
+  const auto k = static_cast<double>(h);
+  switch (waveform) {
+  case Waveform::Saw:
+    return 1.0 / k;
+  case Waveform::Square:
+    return h % 2 == 1 ? 1.0 / k : 0.0;
+  case Waveform::Triangle:
+    if (h % 2 == 0)
+      return 0.0;
+    return (h % 4 == 1 ? 1.0 : -1.0) / (k * k);
+  }
+  return 0.0;
+}
+
+std::once_flag g_shared_once;
+std::unique_ptr<const WavetableBank> g_shared;
+
+} // namespace
+
+std::optional<Waveform> timbre_waveform(Timbre timbre) {
+  switch (timbre) {
+  case Timbre::Saw:
+    return Waveform::Saw;
+  case Timbre::Square:
+    return Waveform::Square;
+  case Timbre::Triangle:
+    return Waveform::Triangle;
+  default:
+    return std::nullopt;
+  }
+}
+
+WavetableBank::WavetableBank() : _samples(kWaveforms * kOctaves * kStride) {}
+
+WavetableBank WavetableBank::build() {
+  constexpr double tau = 2.0 * std::numbers::pi;
+  const double nyquist = static_cast<double>(kSampleRate) / 2.0;
+
+  // sin(tau * h * i / N) is just entry (h * i) mod N of a single cycle, so the
+  // series needs no trig calls past this one table
+  std::vector<double> sine(kTableSize);
+  for (std::size_t i = 0; i < kTableSize; ++i)
+    sine[i] = std::sin(tau * static_cast<double>(i) / kTableSize);
+
+  WavetableBank bank;
+  std::vector<double> cycle(kTableSize);
+  for (std::size_t w = 0; w < kWaveforms; ++w) {
+    const auto waveform = static_cast<Waveform>(w);
+    for (std::size_t octave = 0; octave < kOctaves; ++octave) {
+      const double top_hz =
+          kLowestHz * std::exp2(static_cast<double>(octave + 1));
+      const auto harmonics = std::clamp<std::size_t>(
+          static_cast<std::size_t>(nyquist / top_hz), 1, kTableSize / 2 - 1);
+
+      std::fill(cycle.begin(), cycle.end(), 0.0);
+      for (std::size_t h = 1; h <= harmonics; ++h) {
+        const double gain = harmonic_gain(waveform, h);
+        if (gain == 0.0)
+          continue;
+        for (std::size_t i = 0; i < kTableSize; ++i)
+          cycle[i] += gain * sine[(h * i) & (kTableSize - 1)];
+      }
+
+      // Gibbs ringing overshoots, so normalize on the actual peak
+      double peak = 0.0;
+      for (const auto v : cycle)
+        peak = std::max(peak, std::abs(v));
+      if (peak == 0.0)
+        peak = 1.0;
+
+      auto *table = bank._samples.data() + (w * kOctaves + octave) * kStride;
+      for (std::size_t i = 0; i < kTableSize; ++i)
+        table[i] = static_cast<float>(cycle[i] / peak);
+      table[kTableSize] = table[0];
+    }
+  }
+  return bank;
+}
+
+std::optional<WavetableBank>
+WavetableBank::load(const std::filesystem::path &path) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in)
+    return std::nullopt;
+
+  BlobHeader header{};
+  in.read(reinterpret_cast<char *>(&header), sizeof(header));
+  if (!in || header.magic != kBlobMagic || header.version != kBlobVersion ||
+      header.table_size != kTableSize || header.octaves != kOctaves ||
+      header.waveforms != kWaveforms || header.sample_rate != kSampleRate)
+    return std::nullopt;
+
+  WavetableBank bank;
+  const auto bytes = bank._samples.size() * sizeof(float);
+  in.read(reinterpret_cast<char *>(bank._samples.data()),
+          static_cast<std::streamsize>(bytes));
+  if (!in || in.peek() != std::ifstream::traits_type::eof())
+    return std::nullopt;
+  return bank;
+}
+
+bool WavetableBank::save(const std::filesystem::path &path) const {
+  auto tmp = path;
+  tmp += ".tmp." + std::to_string(::getpid());
+
+  {
+    std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+    if (!out)
+      return false;
+    const BlobHeader header{kBlobMagic,          kBlobVersion,
+                            kTableSize,          kOctaves,
+                            kWaveforms,          kSampleRate};
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char *>(_samples.data()),
+              static_cast<std::streamsize>(_samples.size() * sizeof(float)));
+    if (!out.flush()) {
+      std::error_code ec;
+      std::filesystem::remove(tmp, ec);
+      return false;
+    }
+  }
+
+  std::error_code ec;
+  std::filesystem::rename(tmp, path, ec);
+  if (ec) {
+    std::filesystem::remove(tmp, ec);
+    return false;
+  }
+  return true;
+}
+
+const WavetableBank &WavetableBank::shared() {
+  std::call_once(g_shared_once, [] {
+    g_shared.reset(new WavetableBank(build()));
+  });
+  return *g_shared;
+}
+
+const WavetableBank &
+WavetableBank::shared(const std::filesystem::path &cache) {
+  std::call_once(g_shared_once, [&cache] {
+    if (auto cached = load(cache)) {
+      g_shared.reset(new WavetableBank(std::move(*cached)));
+      return;
+    }
+    auto bank = build();
+    bank.save(cache); // a cache we can't write just means a slower next start
+    g_shared.reset(new WavetableBank(std::move(bank)));
+  });
+  return *g_shared;
+}
+
+std::span<const float> WavetableBank::table(Waveform waveform,
+                                            double freq_hz) const {
+  const auto octave = static_cast<std::size_t>(std::clamp(
+      std::floor(std::log2(std::max(freq_hz, kLowestHz) / kLowestHz)), 0.0,
+      static_cast<double>(kOctaves - 1)));
+  const auto w = static_cast<std::size_t>(waveform);
+  return {_samples.data() + (w * kOctaves + octave) * kStride, kStride};
+}
+
+void WavetableOscillator::start(const WavetableBank &bank, Waveform waveform,
+                                double freq_hz) {
+  const auto sr = static_cast<double>(kSampleRate);
+  _phase = 0;
+  if (freq_hz <= 0.0 || freq_hz >= sr / 2.0) {
+    _table = nullptr;
+    _step = 0;
+    return;
+  }
+  _table = bank.table(waveform, freq_hz).data();
+  _step = static_cast<std::uint32_t>(std::llround(freq_hz / sr * 4294967296.0));
+}
+
+void WavetableOscillator::render(std::span<float> out) {
+  if (_table == nullptr) {
+    std::fill(out.begin(), out.end(), 0.0f);
+    return;
+  }
+
+  constexpr unsigned int frac_bits = 32 - WavetableBank::kTableBits;
+  constexpr std::uint32_t frac_mask = (std::uint32_t{1} << frac_bits) - 1;
+  constexpr float frac_scale = 1.0f / static_cast<float>(1u << frac_bits);
+
+  for (auto &sample : out) {
+    const auto index = _phase >> frac_bits;
+    const auto frac = static_cast<float>(_phase & frac_mask) * frac_scale;
+    const float a = _table[index];
+    const float b = _table[index + 1];
+    sample = a + (b - a) * frac;
+    _phase += _step;
+  }
+}
+
+} // namespace Audio
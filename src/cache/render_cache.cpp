@@ -0,0 +1,232 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+#include <vector>
+
+#include "cache/render_cache.hpp"
+#include "cache/xxhash.hpp"
+
+namespace Cache {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Bumped whenever what gets stored for a key changes
+constexpr std::string_view kCacheVersion = "music-gen render cache 2";
+
+/// Links [from] to [to], copying when they're on different file systems.
+bool link_or_copy(const fs::path &from, const fs::path &to) {
+  std::error_code ec;
+  fs::create_hard_link(from, to, ec);
+  if (!ec)
+    return true;
+  return fs::copy_file(from, to, fs::copy_options::overwrite_existing, ec);
+}
+
+/// Writes [path] under a temporary name and renames it into place.
+bool write_atomically(const fs::path &path, std::string_view contents) {
+  auto tmp = path;
+  tmp += ".tmp." + std::to_string(::getpid());
+  {
+    std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+    if (!out.write(contents.data(),
+                   static_cast<std::streamsize>(contents.size())))
+      return false;
+  }
+  std::error_code ec;
+  fs::rename(tmp, path, ec);
+  if (ec)
+    fs::remove(tmp, ec);
+  return !ec;
+}
+
+} // namespace
+
+std::string normalize_score(std::string_view text) {
+  std::string out;
+  out.reserve(text.size());
+  while (!text.empty()) {
+    auto line = text.substr(0, text.find('\n'));
+    text.remove_prefix(std::min(text.size(), line.size() + 1));
+
+    line = line.substr(0, line.find(';'));
+    bool blank = false;
+    const auto start = out.size();
+    for (const char c : line) {
+      if (c == ' ' || c == '\t' || c == '\r') {
+        blank = out.size() > start;
+        continue;
+      }
+      if (blank)
+        out += ' ';
+      blank = false;
+      out += c;
+    }
+    if (out.size() > start)
+      out += '\n';
+  }
+  return out;
+}
+
+std::uint64_t binary_fingerprint() {
+  static const std::uint64_t fingerprint = [] {
+    std::error_code ec;
+    const auto exe = fs::read_symlink("/proc/self/exe", ec);
+    if (ec)
+      return xxh64(kCacheVersion);
+    // Like ccache's compiler check: reading the whole binary would cost more
+    // than a cache hit is allowed to, and any rebuild changes these
+    std::ostringstream id;
+    id << exe.string() << '\0' << fs::file_size(exe, ec) << '\0'
+       << fs::last_write_time(exe, ec).time_since_epoch().count();
+    return xxh64(id.str(), xxh64(kCacheVersion));
+  }();
+  return fingerprint;
+}
+
+RenderCache::RenderCache(fs::path dir, std::uint64_t max_bytes)
+    : _dir(std::move(dir)), _max_bytes(max_bytes) {}
+
+fs::path RenderCache::default_dir() {
+  if (const char *xdg = std::getenv("XDG_CACHE_HOME"); xdg && *xdg)
+    return fs::path(xdg) / "music-gen";
+  if (const char *home = std::getenv("HOME"); home && *home)
+    return fs::path(home) / ".cache" / "music-gen";
+  return fs::temp_directory_path() / "music-gen-cache";
+}
+
+fs::path RenderCache::entry(std::uint64_t key) const {
+  char name[32];
+  std::snprintf(name, sizeof(name), "%016llx.out",
+                static_cast<unsigned long long>(key));
+  return _dir / name;
+}
+
+fs::path RenderCache::warnings_entry(std::uint64_t key) const {
+  return fs::path(entry(key)).replace_extension(".warn");
+}
+
+std::optional<std::vector<std::string>>
+RenderCache::fetch(std::uint64_t key, const fs::path &output) {
+  const auto path = entry(key);
+  std::error_code ec;
+  if (!fs::is_regular_file(path, ec))
+    return std::nullopt;
+
+  // Replace whatever is at the output, the same as rendering would
+  fs::remove(output, ec);
+  if (!link_or_copy(path, output))
+    return std::nullopt;
+  fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+
+  std::vector<std::string> warnings;
+  std::ifstream in(warnings_entry(key));
+  for (std::string line; std::getline(in, line);)
+    warnings.push_back(std::move(line));
+  return warnings;
+}
+
+void RenderCache::detach(const fs::path &output) {
+  std::error_code ec;
+  if (fs::is_regular_file(output, ec) && fs::hard_link_count(output, ec) > 1)
+    fs::remove(output, ec);
+}
+
+bool RenderCache::unshare(const fs::path &output) {
+  std::error_code ec;
+  if (!fs::is_regular_file(output, ec) || fs::hard_link_count(output, ec) < 2)
+    return true;
+
+  auto tmp = output;
+  tmp += ".tmp." + std::to_string(::getpid());
+  if (!fs::copy_file(output, tmp, fs::copy_options::overwrite_existing, ec))
+    return false;
+  fs::rename(tmp, output, ec);
+  if (ec) {
+    fs::remove(tmp, ec);
+    return false;
+  }
+  return true;
+}
+
+void RenderCache::store(std::uint64_t key, const fs::path &output,
+                        std::span<const std::string> warnings) {
+  std::error_code ec;
+  fs::create_directories(_dir, ec);
+  if (ec)
+    return;
+
+  // In place before the entry, so no hit can miss them
+  if (warnings.empty()) {
+    fs::remove(warnings_entry(key), ec);
+  } else {
+    std::string text;
+    for (const auto &warning : warnings)
+      text += warning + '\n';
+    if (!write_atomically(warnings_entry(key), text))
+      return;
+  }
+
+  std::ostringstream tmp_name;
+  tmp_name << entry(key).filename().string() << ".tmp." << ::getpid();
+  const auto tmp = _dir / tmp_name.str();
+  fs::remove(tmp, ec);
+  if (!link_or_copy(output, tmp))
+    return;
+  fs::rename(tmp, entry(key), ec);
+  if (ec) {
+    fs::remove(tmp, ec);
+    return;
+  }
+  evict();
+}
+
+void RenderCache::evict() {
+  struct Entry {
+    fs::path path;
+    fs::file_time_type used;
+    std::uint64_t bytes;
+  };
+  std::vector<Entry> entries;
+  std::uint64_t total = 0;
+
+  std::error_code ec;
+  const auto now = fs::file_time_type::clock::now();
+  for (const auto &file : fs::directory_iterator(_dir, ec)) {
+    if (!file.is_regular_file(ec))
+      continue;
+    // Left behind by a render that died between writing and renaming.
+    // Warnings are dropped along with their entry below
+    if (file.path().extension() != ".out") {
+      if (file.path().filename().string().find(".tmp.") != std::string::npos &&
+          now - file.last_write_time(ec) > std::chrono::hours(1))
+        fs::remove(file.path(), ec);
+      continue;
+    }
+    Entry e{file.path(), file.last_write_time(ec), file.file_size(ec)};
+    if (ec)
+      continue;
+    total += e.bytes;
+    entries.push_back(std::move(e));
+  }
+  if (total <= _max_bytes)
+    return;
+
+  std::sort(entries.begin(), entries.end(),
+            [](const Entry &a, const Entry &b) { return a.used < b.used; });
+  for (const auto &e : entries) {
+    if (total <= _max_bytes)
+      break;
+    if (fs::remove(e.path, ec)) {
+      total -= e.bytes;
+      fs::remove(fs::path(e.path).replace_extension(".warn"), ec);
+    }
+  }
+}
+
+} // namespace Cache
@@ -0,0 +1,260 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+
+#include "audio/melody_renderer.hpp"
+#include "cache/render_index.hpp"
+#include "cache/xxhash.hpp"
+
+namespace Cache {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr std::uint32_t kIndexMagic = 0x5844494d; // "MIDX"
+constexpr std::uint32_t kIndexVersion = 1;
+
+struct IndexHeader {
+  std::uint32_t magic;
+  std::uint32_t version;
+  std::uint64_t options;
+  std::uint64_t file_bytes;
+  std::int64_t mtime_ns;
+  std::uint64_t voices;
+};
+
+IndexedNote index_note(const Audio::NoteInfo &note) {
+  char bytes[2 * sizeof(double)];
+  std::memcpy(bytes, &note.freq_hz, sizeof(double));
+  std::memcpy(bytes + sizeof(double), &note.dur_s, sizeof(double));
+  return {xxh64(std::string_view(bytes, sizeof(bytes))),
+          static_cast<std::uint64_t>(Audio::note_samples(note))};
+}
+
+std::uint64_t voice_samples(const std::vector<IndexedNote> &voice) {
+  std::uint64_t samples = 0;
+  for (const auto &note : voice)
+    samples += note.samples;
+  return samples;
+}
+
+/// Adds the notes of [old_voice] and [new_voice] that didn't stay put, clipped
+/// to [end], to [dirty].
+void diff_voice(const std::vector<IndexedNote> &old_voice,
+                const std::vector<IndexedNote> &new_voice, std::uint64_t end,
+                std::vector<std::pair<std::uint64_t, std::uint64_t>> &dirty) {
+  auto mark = [&](std::uint64_t start, const IndexedNote &note) {
+    const auto stop = std::min(end, start + note.samples);
+    if (start < stop)
+      dirty.emplace_back(start, stop);
+  };
+
+  std::size_t i = 0, j = 0;
+  std::uint64_t old_at = 0, new_at = 0;
+  while (i < old_voice.size() && j < new_voice.size()) {
+    if (old_at == new_at && old_voice[i] == new_voice[j]) {
+      // Kept; the one case that costs nothing
+    } else if (old_at <= new_at) {
+      mark(old_at, old_voice[i]);
+      if (old_at == new_at)
+        mark(new_at, new_voice[j]);
+    } else {
+      mark(new_at, new_voice[j]);
+    }
+    const bool step_old = old_at <= new_at;
+    const bool step_new = new_at <= old_at;
+    if (step_old)
+      old_at += old_voice[i++].samples;
+    if (step_new)
+      new_at += new_voice[j++].samples;
+  }
+  for (; i < old_voice.size(); old_at += old_voice[i++].samples)
+    mark(old_at, old_voice[i]);
+  for (; j < new_voice.size(); new_at += new_voice[j++].samples)
+    mark(new_at, new_voice[j]);
+}
+
+} // namespace
+
+RenderIndex RenderIndex::of(std::span<const Audio::Voice> voices,
+                            std::uint64_t options) {
+  RenderIndex index;
+  index.options = options;
+  index.voices.reserve(voices.size());
+  for (const auto &voice : voices) {
+    auto &notes = index.voices.emplace_back();
+    notes.reserve(voice.size());
+    for (const auto &note : voice)
+      notes.push_back(index_note(note));
+  }
+  return index;
+}
+
+std::optional<RenderIndex> RenderIndex::load(const fs::path &path) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in)
+    return std::nullopt;
+
+  IndexHeader header{};
+  in.read(reinterpret_cast<char *>(&header), sizeof(header));
+  if (!in || header.magic != kIndexMagic || header.version != kIndexVersion)
+    return std::nullopt;
+
+  std::error_code ec;
+  const auto bytes = fs::file_size(path, ec);
+  RenderIndex index;
+  index.options = header.options;
+  index.file_bytes = header.file_bytes;
+  index.mtime_ns = header.mtime_ns;
+  for (std::uint64_t v = 0; v < header.voices; ++v) {
+    std::uint64_t notes = 0;
+    in.read(reinterpret_cast<char *>(&notes), sizeof(notes));
+    // A truncated file can't claim more notes than it has bytes for
+    if (!in || notes > bytes / sizeof(IndexedNote))
+      return std::nullopt;
+    auto &voice = index.voices.emplace_back(notes);
+    in.read(reinterpret_cast<char *>(voice.data()),
+            static_cast<std::streamsize>(notes * sizeof(IndexedNote)));
+    if (!in)
+      return std::nullopt;
+  }
+  if (in.peek() != std::ifstream::traits_type::eof())
+    return std::nullopt;
+  return index;
+}
+
+bool RenderIndex::save(const fs::path &path) const {
+  auto tmp = path;
+  tmp += ".tmp." + std::to_string(::getpid());
+
+  {
+    std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+    if (!out)
+      return false;
+    const IndexHeader header{kIndexMagic, kIndexVersion, options,
+                             file_bytes,  mtime_ns,      voices.size()};
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    for (const auto &voice : voices) {
+      const std::uint64_t notes = voice.size();
+      out.write(reinterpret_cast<const char *>(&notes), sizeof(notes));
+      out.write(reinterpret_cast<const char *>(voice.data()),
+                static_cast<std::streamsize>(notes * sizeof(IndexedNote)));
+    }
+    if (!out.flush()) {
+      std::error_code ec;
+      fs::remove(tmp, ec);
+      return false;
+    }
+  }
+
+  std::error_code ec;
+  fs::rename(tmp, path, ec);
+  if (ec) {
+    fs::remove(tmp, ec);
+    return false;
+  }
+  return true;
+}
+
+void RenderIndex::pin(const fs::path &output) {
+  std::error_code ec;
+  file_bytes = fs::file_size(output, ec);
+  mtime_ns = fs::last_write_time(output, ec).time_since_epoch().count();
+}
+
+bool RenderIndex::describes(const fs::path &output) const {
+  RenderIndex now;
+  now.pin(output);
+  return now.file_bytes == file_bytes && now.mtime_ns == mtime_ns;
+}
+
+std::uint64_t RenderIndex::song_samples() const {
+  std::uint64_t longest = 0;
+  for (const auto &voice : voices)
+    longest = std::max(longest, voice_samples(voice));
+  return longest;
+}
+
+fs::path index_path(const fs::path &output) {
+  auto path = output;
+  path += ".idx";
+  return path;
+}
+
+std::uint64_t RenderPatch::dirty_samples() const {
+  std::uint64_t samples = 0;
+  for (const auto &[begin, end] : dirty)
+    samples += end - begin;
+  return samples;
+}
+
+std::optional<RenderPatch> plan_patch(const RenderIndex &old_index,
+                                      const RenderIndex &new_index) {
+  if (old_index.voices.size() != new_index.voices.size())
+    return std::nullopt;
+
+  const auto old_song = old_index.song_samples();
+  const auto new_song = new_index.song_samples();
+  const auto shift =
+      static_cast<std::int64_t>(new_song) - static_cast<std::int64_t>(old_song);
+
+  // The tail starts once every voice is either in a run of notes at its end
+  // that moved by [shift] as a whole, or done in both versions
+  std::uint64_t tail_from = 0;
+  for (std::size_t v = 0; v < old_index.voices.size(); ++v) {
+    const auto &old_voice = old_index.voices[v];
+    const auto &new_voice = new_index.voices[v];
+    const auto old_end = voice_samples(old_voice);
+    const auto new_end = voice_samples(new_voice);
+
+    std::uint64_t from = 0;
+    if (static_cast<std::int64_t>(new_end) -
+            static_cast<std::int64_t>(old_end) ==
+        shift) {
+      std::uint64_t same = 0;
+      auto o = old_voice.rbegin();
+      auto n = new_voice.rbegin();
+      for (; o != old_voice.rend() && n != new_voice.rend() && *o == *n;
+           ++o, ++n)
+        same += o->samples;
+      from = old_end - same;
+    } else {
+      from = std::max<std::int64_t>(static_cast<std::int64_t>(old_end),
+                                    static_cast<std::int64_t>(new_end) - shift);
+    }
+    tail_from = std::max(tail_from, from);
+  }
+
+  RenderPatch patch;
+  patch.tail_from = std::min(tail_from, old_song);
+  patch.tail_to = static_cast<std::uint64_t>(
+      static_cast<std::int64_t>(patch.tail_from) + shift);
+  patch.tail_samples = old_song - patch.tail_from;
+
+  for (std::size_t v = 0; v < old_index.voices.size(); ++v) {
+    diff_voice(old_index.voices[v], new_index.voices[v], patch.tail_to,
+               patch.dirty);
+  }
+  // Past the end of the old file there is nothing to keep (the notes there
+  // are new anyway, this is only a backstop)
+  if (patch.tail_to > old_song)
+    patch.dirty.emplace_back(old_song, patch.tail_to);
+
+  auto &dirty = patch.dirty;
+  std::sort(dirty.begin(), dirty.end());
+  std::size_t merged = 0;
+  for (const auto &range : dirty) {
+    if (merged > 0 && range.first <= dirty[merged - 1].second)
+      dirty[merged - 1].second = std::max(dirty[merged - 1].second,
+                                          range.second);
+    else
+      dirty[merged++] = range;
+  }
+  dirty.resize(merged);
+  return patch;
+}
+
+} // namespace Cache
@@ -0,0 +1,98 @@
+#include <algorithm>
+#include <iterator>
+
+#include "file_reading/diagnostic.hpp"
+
+namespace FileReading {
+
+std::string diagnostic_code_to_str(DiagnosticCode code) {
+  switch (code) {
+  case DiagnosticCode::UnexpectedCharacter:
+    return "unexpected_character";
+  case DiagnosticCode::ExpectedCharacter:
+    return "expected_character";
+  case DiagnosticCode::UnexpectedEof:
+    return "unexpected_eof";
+  case DiagnosticCode::UnexpectedToken:
+    return "unexpected_token";
+  case DiagnosticCode::EmptyChord:
+    return "empty_chord";
+  }
+  return "unknown";
+}
+
+std::string Diagnostic::message() const {
+  auto character = [](std::uint32_t c) {
+    return std::string(1, static_cast<char>(c));
+  };
+  auto kind = [](std::uint32_t k) {
+    return Lexer::token_kind_to_str(static_cast<Lexer::TokenKind>(k));
+  };
+
+  std::string error;
+  switch (code) {
+  case DiagnosticCode::UnexpectedCharacter:
+    error = "Unexpected identifier '" + character(actual) + "'";
+    break;
+  case DiagnosticCode::ExpectedCharacter:
+    error = "Expected '" + character(expected) + "' but got '" +
+            character(actual) + "'";
+    break;
+  case DiagnosticCode::UnexpectedEof:
+    error = "Expected '" + character(expected) + "' but got End of File";
+    break;
+  case DiagnosticCode::UnexpectedToken:
+    error = "Unexpected token [" + kind(actual) + "], (expected [" +
+            kind(expected) + "])";
+    break;
+  case DiagnosticCode::EmptyChord:
+    error = "Empty chord";
+    break;
+  }
+  return "Error: " + error + " at " + loc.to_string();
+}
+
+void Diagnostics::report(const Diagnostic &diagnostic) {
+  if (_kept.size() < kLimit)
+    _kept.push_back(diagnostic);
+  ++_count;
+}
+
+void Diagnostics::clear() {
+  _kept.clear();
+  _count = 0;
+}
+
+void Diagnostics::merge(const Diagnostics &other) {
+  std::vector<Diagnostic> merged;
+  merged.reserve(_kept.size() + other._kept.size());
+  std::merge(other._kept.begin(), other._kept.end(), _kept.begin(),
+             _kept.end(), std::back_inserter(merged),
+             [](const Diagnostic &a, const Diagnostic &b) {
+               return a.offset < b.offset;
+             });
+  if (merged.size() > kLimit)
+    merged.resize(kLimit);
+  _kept = std::move(merged);
+  _count += other._count;
+}
+
+bool Diagnostics::empty() const { return _count == 0; }
+
+std::size_t Diagnostics::count() const { return _count; }
+
+std::span<const Diagnostic> Diagnostics::kept() const { return _kept; }
+
+std::size_t Diagnostics::dropped() const { return _count - _kept.size(); }
+
+std::vector<std::string> Diagnostics::messages() const {
+  std::vector<std::string> messages;
+  messages.reserve(_kept.size() + 1);
+  for (const auto &diagnostic : _kept)
+    messages.push_back(diagnostic.message());
+  if (dropped() > 0)
+    messages.push_back("... " + std::to_string(dropped()) + " more errors");
+  return messages;
+}
+
+} // namespace FileReading
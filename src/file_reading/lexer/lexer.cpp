@@ -1,37 +1,31 @@
 #include "file_reading/lexer/lexer.hpp"
 #include "file_reading/lexer/token.hpp"
 #include <set>
-#include <sstream>
 
 namespace FileReading::Lexer {
-Token *make_token(TokenKind kind, SourceLocation loc, std::string lexeme);
-void trim_in_place(std::string &s);
-std::string error_unexpected_identifier(char expected, char actual,
-                                        SourceLocation loc);
+std::string_view trim(std::string_view s);
 
-std::string error_unexpected_eof(char expected, SourceLocation loc);
-std::string error_unexpected_identifier(char id, SourceLocation loc);
-std::string report_error(std::string error, SourceLocation loc);
-
-Lexer::Lexer(std::string_view input)
-    : _input(input), _loc(new SourceLocation()) {}
+Lexer::Lexer(std::string_view input, std::pmr::memory_resource *memory)
+    : _input(input), _tokens(memory) {}
 
 bool Lexer::eof() const { return _i >= _input.size(); }
 
-char Lexer::peek() const { return _input[_i]; }
+// The input needn't be NUL terminated (it may be a mapped file), so reading
+// past its end gives '\0' rather than whatever follows it in memory
+char Lexer::peek() const { return eof() ? '\0' : _input[_i]; }
 
 char Lexer::peek_next() const {
   if (_i + 1 >= _input.size())
-    return _input[_i];
+    return peek();
   return _input[_i + 1];
 }
 
 bool Lexer::error() const { return !_diagnostics.empty(); }
 
-std::vector<std::string> Lexer::diagnostics() const { return _diagnostics; }
+const Diagnostics &Lexer::diagnostics() const { return _diagnostics; }
 
-std::vector<Token *> Lexer::lex() {
-  std::vector<Token *> lexemes;
+std::pmr::vector<Token *> Lexer::lex() {
+  std::pmr::vector<Token *> lexemes(_tokens.get_allocator());
 
   while (true) {
     Token *t = next_token();
@@ -43,12 +37,30 @@ std::vector<Token *> Lexer::lex() {
   return lexemes;
 }
 
+std::pmr::vector<Token *> Lexer::lex_fragment(std::string_view fragment,
+                                              SourceLocation from) {
+  _input = fragment;
+  _i = 0;
+  _loc = from;
+  _lexing_identifier = false;
+  return lex();
+}
+
+void Lexer::reset(std::string_view input) {
+  _input = input;
+  _i = 0;
+  _loc = SourceLocation{};
+  _lexing_identifier = false;
+  _tokens.clear();
+  _diagnostics.clear();
+}
+
 Token *Lexer::next_token() {
   eat_whitespace();
-  const auto start = _loc;
+  const auto *start = &_loc;
 
   if (eof())
-    return make_token(TokenKind::Eof, *start, "");
+    return make_token(TokenKind::Eof, *start, _input.substr(_i, 0));
 
   if (_lexing_identifier) {
     _lexing_identifier = false;
@@ -58,20 +70,21 @@ Token *Lexer::next_token() {
   switch (c) {
   case ':':
     advance();
-    return make_token(TokenKind::Colon, *start, ":");
+    return make_token(TokenKind::Colon, *start, _input.substr(_i - 1, 1));
   case '=':
     advance();
-    return make_token(TokenKind::Equal, *start, "=");
+    return make_token(TokenKind::Equal, *start, _input.substr(_i - 1, 1));
   case '.':
     advance();
-    return make_token(TokenKind::Dot, *start, ".");
+    return make_token(TokenKind::Dot, *start, _input.substr(_i - 1, 1));
   case '[':
-    _lexing_identifier = true;
+    // "[START]" is a label, "[C4 E4 G4]" opens a chord
+    _lexing_identifier = !bracket_holds_chord(_input, _i);
     advance();
-    return make_token(TokenKind::LBracket, *start, "[");
+    return make_token(TokenKind::LBracket, *start, _input.substr(_i - 1, 1));
   case ']':
     advance();
-    return make_token(TokenKind::RBracket, *start, "]");
+    return make_token(TokenKind::RBracket, *start, _input.substr(_i - 1, 1));
   case 'B':
     if (peek_next() == 'P') {
       return lex_bpm();
@@ -79,7 +92,7 @@ Token *Lexer::next_token() {
     return lex_note_id();
   case 'R':
     advance();
-    return make_token(TokenKind::Rest, *start, "R");
+    return make_token(TokenKind::Rest, *start, _input.substr(_i - 1, 1));
   case '#':
   case 'b':
     return lex_accidental();
@@ -91,57 +104,76 @@ Token *Lexer::next_token() {
       return lex_note_id_or_duration();
     }
 
-    _diagnostics.push_back(error_unexpected_identifier(c, *start));
+    report(DiagnosticCode::UnexpectedCharacter, *start, 0, c);
     advance();
-    return make_token(TokenKind::Error, *start, std::string{c});
+    return make_token(TokenKind::Error, *start, _input.substr(_i - 1, 1));
   }
 
   return nullptr;
 }
 
+bool bracket_holds_chord(std::string_view input, std::size_t open) {
+  auto at = [&](std::size_t j) { return j < input.size() ? input[j] : '\0'; };
+  auto is_digit = [](char c) { return c >= '0' && c <= '9'; };
+
+  bool notes = false;
+  for (auto j = open + 1;;) {
+    const char c = at(j);
+    if (c == ' ' || c == '\t' || c == '\r') {
+      ++j;
+      continue;
+    }
+    if (c == ']' || c == '\n' || c == '\0')
+      return notes;
+    if (c < 'A' || c > 'G')
+      return false;
+    if (at(++j) == '#' || at(j) == 'b')
+      ++j;
+    if (!is_digit(at(j)))
+      return false;
+    while (is_digit(at(j)))
+      ++j;
+    notes = true;
+  }
+}
+
 Token *Lexer::lex_bpm() {
-  const auto start = _loc;
-  std::string lexeme;
-  lexeme.push_back(peek());
+  const auto *start = &_loc;
+  const std::size_t begin = _i;
   advance(); // B
-  lexeme.push_back(peek());
   advance(); // P
   char M = peek();
   if (M != 'M') {
-    _diagnostics.push_back(error_unexpected_identifier('M', M, *start));
+    report(DiagnosticCode::ExpectedCharacter, *start, 'M', M);
     advance();
-    return make_token(TokenKind::Error, *start, lexeme);
+    return make_token(TokenKind::Error, *start, _input.substr(begin, 2));
   }
-  lexeme.push_back(M);
   advance(); // M
-  return make_token(TokenKind::Bpm, *start, lexeme);
+  return make_token(TokenKind::Bpm, *start, _input.substr(begin, 3));
 }
 
 Token *Lexer::lex_identifier() {
-  const auto start = _loc;
+  const auto *start = &_loc;
   const std::size_t begin = _i;
 
   advance(); // '['
-  std::string name;
-  while (!eof() && peek() != ']' && peek() != '\n') {
-    name.push_back(peek());
+  const std::size_t name_begin = _i;
+  while (!eof() && peek() != ']' && peek() != '\n')
     advance();
-  }
-
-  trim_in_place(name);
+  const auto name = trim(_input.substr(name_begin, _i - name_begin));
 
   if (eof() || peek() != ']') {
     if (eof()) {
-      _diagnostics.push_back(error_unexpected_eof(']', *start));
+      report(DiagnosticCode::UnexpectedEof, *start, ']', 0);
     } else {
-      _diagnostics.push_back(error_unexpected_identifier(']', peek(), *start));
+      report(DiagnosticCode::ExpectedCharacter, *start, ']', peek());
     }
 
     return make_token(TokenKind::Error, *start, name);
   }
 
   return make_token(TokenKind::Identifier, *start,
-                    std::string(_input.substr(begin, _i - begin)));
+                    _input.substr(begin, _i - begin));
 }
 
 Token *Lexer::lex_note_id_or_duration() {
@@ -157,11 +189,11 @@ Token *Lexer::lex_note_id_or_duration() {
 const std::set<char> durations = {'w', 'h', 'q', 'e', 's', 't'};
 
 Token *Lexer::lex_duration() {
-  const auto start = _loc;
+  const auto *start = &_loc;
   char dur = peek();
-  std::string lexeme = std::string{peek()};
+  const auto lexeme = _input.substr(_i, 1);
   if (!durations.contains(dur)) {
-    _diagnostics.push_back(error_unexpected_identifier(dur, *start));
+    report(DiagnosticCode::UnexpectedCharacter, *start, 0, dur);
     advance();
     return make_token(TokenKind::Error, *start, lexeme);
   }
@@ -172,12 +204,12 @@ Token *Lexer::lex_duration() {
 }
 
 Token *Lexer::lex_note_id() {
-  const auto start = _loc;
+  const auto *start = &_loc;
   char note = peek();
-  std::string lexeme = std::string{peek()};
+  const auto lexeme = _input.substr(_i, 1);
   if (note < 'A' || note > 'G') {
+    report(DiagnosticCode::UnexpectedCharacter, *start, 0, note);
     advance();
-    _diagnostics.push_back(error_unexpected_identifier(note, *start));
     return make_token(TokenKind::Error, *start, lexeme);
   }
   advance();
@@ -185,22 +217,20 @@ Token *Lexer::lex_note_id() {
 }
 
 Token *Lexer::lex_accidental() {
-  const auto start = _loc;
-  std::string lexeme = std::string{peek()};
+  const auto *start = &_loc;
+  const auto lexeme = _input.substr(_i, 1);
   advance();
   return make_token(TokenKind::Accidental, *start, lexeme);
 }
 
 Token *Lexer::lex_number() {
-  const auto start = _loc;
-
-  std::stringstream ss;
-  while (!eof() && std::isdigit(static_cast<unsigned char>(peek()))) {
-    ss << peek();
+  const auto *start = &_loc;
+  const std::size_t begin = _i;
+  while (!eof() && std::isdigit(static_cast<unsigned char>(peek())))
     advance();
-  }
 
-  return make_token(TokenKind::Number, *start, ss.str());
+  return make_token(TokenKind::Number, *start,
+                    _input.substr(begin, _i - begin));
 }
 
 void Lexer::eat_whitespace() {
@@ -224,46 +254,40 @@ void Lexer::eat_whitespace() {
 }
 
 void Lexer::advance() {
+  if (eof())
+    return;
   const char c = _input[_i++];
   if (c == '\n') {
-    ++_loc->line;
-    _loc->col = 1;
+    ++_loc.line;
+    _loc.col = 1;
   } else {
-    ++_loc->col;
+    ++_loc.col;
   }
 }
 
-Token *make_token(TokenKind kind, SourceLocation loc, std::string lexeme) {
-  return new Token{.kind = kind, .loc = loc, .lexeme = std::move(lexeme)};
+Token *Lexer::make_token(TokenKind kind, SourceLocation loc,
+                         std::string_view lexeme) {
+  return &_tokens.emplace_back(
+      Token{.kind = kind, .loc = loc, .lexeme = lexeme});
+}
+
+void Lexer::report(DiagnosticCode code, SourceLocation loc, char expected,
+                   char actual) {
+  _diagnostics.report(
+      Diagnostic{.code = code,
+                 .loc = loc,
+                 .offset = _i,
+                 .expected = static_cast<unsigned char>(expected),
+                 .actual = static_cast<unsigned char>(actual)});
 }
 
-void trim_in_place(std::string &s) {
+std::string_view trim(std::string_view s) {
   auto is_ws = [](unsigned char ch) { return std::isspace(ch) != 0; };
   while (!s.empty() && is_ws(static_cast<unsigned char>(s.front())))
-    s.erase(s.begin());
+    s.remove_prefix(1);
   while (!s.empty() && is_ws(static_cast<unsigned char>(s.back())))
-    s.pop_back();
+    s.remove_suffix(1);
+  return s;
 }
 
-std::string error_unexpected_identifier(char id, SourceLocation loc) {
-  auto message = "Unexpected identifier '" + std::string{id} + "'";
-  return report_error(message, loc);
-}
-
-std::string error_unexpected_identifier(char expected, char actual,
-                                        SourceLocation loc) {
-  auto expected_str = std::string{expected};
-  auto actual_str = std::string{actual};
-  auto message = "Expected '" + expected_str + "' but got '" + actual_str + "'";
-  return report_error(message, loc);
-}
-
-std::string error_unexpected_eof(char expected, SourceLocation loc) {
-  auto message = "Expected '" + std::string{expected} + "' but got End of File";
-  return report_error(message, loc);
-}
-
-std::string report_error(std::string error, SourceLocation loc) {
-  return "Error: " + error + " at " + loc.to_string();
-}
 } // namespace FileReading::Lexer
@@ -0,0 +1,106 @@
+#include <cstdio>
+
+#include "file_reading/diagnostic.hpp"
+#include "file_reading/logging/diagnostic_printer.hpp"
+
+namespace FileReading::Logging {
+
+namespace {
+
+void append_json_string(std::string &out, std::string_view s) {
+  out += '"';
+  for (const char c : s) {
+    switch (c) {
+    case '"':
+      out += "\\\"";
+      break;
+    case '\\':
+      out += "\\\\";
+      break;
+    case '\n':
+      out += "\\n";
+      break;
+    case '\t':
+      out += "\\t";
+      break;
+    default:
+      // Bytes past ASCII are escaped as well: a diagnostic can hold a single
+      // byte of a multibyte character, which on its own isn't valid UTF-8
+      if (const auto byte = static_cast<unsigned char>(c);
+          byte < 0x20 || byte >= 0x80) {
+        char escaped[8];
+        std::snprintf(escaped, sizeof(escaped), "\\u%04x",
+                      static_cast<unsigned>(byte));
+        out += escaped;
+      } else {
+        out += c;
+      }
+    }
+  }
+  out += '"';
+}
+
+} // namespace
+
+std::string diagnostic_to_json(const Diagnostic &diagnostic) {
+  std::string json = "{\"code\":";
+  append_json_string(json, diagnostic_code_to_str(diagnostic.code));
+  json += ",\"line\":" + std::to_string(diagnostic.loc.line);
+  json += ",\"col\":" + std::to_string(diagnostic.loc.col);
+  json += ",\"offset\":" + std::to_string(diagnostic.offset);
+
+  auto character = [&](const char *name, std::uint32_t c) {
+    json += ",\"";
+    json += name;
+    json += "\":";
+    append_json_string(json, std::string(1, static_cast<char>(c)));
+  };
+  auto kind = [&](const char *name, std::uint32_t k) {
+    json += ",\"";
+    json += name;
+    json += "\":";
+    append_json_string(
+        json, Lexer::token_kind_to_str(static_cast<Lexer::TokenKind>(k)));
+  };
+  switch (diagnostic.code) {
+  case DiagnosticCode::UnexpectedCharacter:
+    character("actual", diagnostic.actual);
+    break;
+  case DiagnosticCode::ExpectedCharacter:
+    character("expected", diagnostic.expected);
+    character("actual", diagnostic.actual);
+    break;
+  case DiagnosticCode::UnexpectedEof:
+    character("expected", diagnostic.expected);
+    break;
+  case DiagnosticCode::UnexpectedToken:
+    kind("expected", diagnostic.expected);
+    kind("actual", diagnostic.actual);
+    break;
+  case DiagnosticCode::EmptyChord:
+    break;
+  }
+
+  json += ",\"message\":";
+  append_json_string(json, diagnostic.message());
+  json += '}';
+  return json;
+}
+
+void log_diagnostics(const Diagnostics &diagnostics, bool json,
+                     std::ostream &out) {
+  if (!json) {
+    for (const auto &message : diagnostics.messages())
+      out << message << '\n';
+    out.flush();
+    return;
+  }
+  for (const auto &diagnostic : diagnostics.kept())
+    out << diagnostic_to_json(diagnostic) << '\n';
+  if (diagnostics.dropped() > 0)
+    out << "{\"code\":\"more_errors\",\"count\":" << diagnostics.dropped()
+        << "}\n";
+  out.flush();
+}
+
+} // namespace FileReading::Logging
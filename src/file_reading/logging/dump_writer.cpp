@@ -0,0 +1,96 @@
+#include <algorithm>
+#include <cstring>
+
+#include "file_reading/logging/dump_writer.hpp"
+
+namespace FileReading::Logging {
+
+std::optional<DumpFormat> parse_dump_format(std::string_view name) {
+  if (name == "text")
+    return DumpFormat::Text;
+  if (name == "jsonl")
+    return DumpFormat::Jsonl;
+  if (name == "binary")
+    return DumpFormat::Binary;
+  return std::nullopt;
+}
+
+DumpWriter::DumpWriter(int fd)
+    : _out(fd, kBlockBytes), _block(_out.acquire()) {}
+
+void DumpWriter::send() {
+  if (_used == 0)
+    return;
+  _out.commit(_used);
+  _block = _out.acquire();
+  _used = 0;
+}
+
+void DumpWriter::put(std::string_view s) {
+  // Labels and lexemes can be as long as a line, so they may span blocks
+  while (!s.empty()) {
+    if (_used == _block.size())
+      send();
+    const auto n = std::min(s.size(), _block.size() - _used);
+    std::memcpy(_block.data() + _used, s.data(), n);
+    _used += n;
+    s.remove_prefix(n);
+  }
+}
+
+void DumpWriter::pad(std::size_t count) {
+  while (count > 0) {
+    if (_used == _block.size())
+      send();
+    const auto n = std::min(count, _block.size() - _used);
+    std::memset(_block.data() + _used, ' ', n);
+    _used += n;
+    count -= n;
+  }
+}
+
+void DumpWriter::put_json(std::string_view s) {
+  static constexpr char kHex[] = "0123456789abcdef";
+  put('"');
+  while (!s.empty()) {
+    // Runs that need no escaping go in with one copy
+    const auto plain = static_cast<std::size_t>(
+        std::find_if(s.begin(), s.end(),
+                     [](char c) {
+                       return c == '"' || c == '\\' ||
+                              static_cast<unsigned char>(c) < 0x20;
+                     }) -
+        s.begin());
+    put(s.substr(0, plain));
+    s.remove_prefix(plain);
+    if (s.empty())
+      break;
+
+    const char c = s.front();
+    s.remove_prefix(1);
+    switch (c) {
+    case '"':
+      put("\\\"");
+      break;
+    case '\\':
+      put("\\\\");
+      break;
+    case '\n':
+      put("\\n");
+      break;
+    case '\t':
+      put("\\t");
+      break;
+    default:
+      put("\\u00");
+      put(kHex[static_cast<unsigned char>(c) >> 4]);
+      put(kHex[static_cast<unsigned char>(c) & 0xf]);
+      break;
+    }
+  }
+  put('"');
+}
+
+void DumpWriter::flush() { send(); }
+
+} // namespace FileReading::Logging
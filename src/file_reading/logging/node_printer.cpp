@@ -1,10 +1,12 @@
-#include <iostream>
-
+#include "file_reading/lexer/token.hpp"
 #include "file_reading/logging/node_printer.hpp"
 #include "file_reading/parser/node.hpp"
 #include "file_reading/parser/node_kinds.hpp"
 
 namespace FileReading::Logging {
+
+namespace {
+
 std::string node_kind_to_str(FileReading::Parser::NodeKind kind) {
   switch (kind) {
   case Parser::NodeKind::Bpm_Decl:
@@ -25,6 +27,7 @@ std::string node_kind_to_str(FileReading::Parser::NodeKind kind) {
     return "Eof";
     break;
   }
+  return "unknown";
 }
 
 std::string duration_to_string(FileReading::Parser::DurationKind dur) {
@@ -42,6 +45,7 @@ std::string duration_to_string(FileReading::Parser::DurationKind dur) {
   case Parser::DurationKind::ThirtySecond:
     return "T";
   }
+  return "unknown";
 }
 
 std::string note_to_str(FileReading::Parser::Note note) {
@@ -61,6 +65,7 @@ std::string note_to_str(FileReading::Parser::Note note) {
   case Parser::Note::G:
     return "G";
   }
+  return "unknown";
 }
 std::string acc_to_str(FileReading::Parser::Accidental acc) {
   switch (acc) {
@@ -71,81 +76,221 @@ std::string acc_to_str(FileReading::Parser::Accidental acc) {
   case Parser::Accidental::Sharp:
     return "Sharp";
   }
+  return "unknown";
 }
 
-void log_node(Parser::Node *node, std::string pad) {
+constexpr std::size_t kIndent = 4;
+
+void dump_text(const Parser::Node *node, std::size_t depth, DumpWriter &out) {
+  const auto pad = depth * kIndent;
+  out.pad(pad);
   if (node == nullptr) {
-    log_error(pad);
+    out.put("[Error]\n");
     return;
   }
 
   switch (node->kind()) {
-  case Parser::NodeKind::Bpm_Decl:
-    log_bpm(static_cast<FileReading::Parser::BpmNode *>(node), pad);
+  case Parser::NodeKind::Bpm_Decl: {
+    const auto *bpm = static_cast<const Parser::BpmNode *>(node);
+    out.put("[BPM] ");
+    out.put_number(bpm->bpm());
+    out.put('\n');
+    dump_text(bpm->duration(), depth + 1, out);
     break;
-  case Parser::NodeKind::Note_Info:
-    log_note_info(static_cast<FileReading::Parser::NoteInfoNode *>(node), pad);
+  }
+  case Parser::NodeKind::Note_Info: {
+    const auto *info = static_cast<const Parser::NoteInfoNode *>(node);
+    out.put(info->is_chord() ? "[Chord]\n" : "[NoteInfo]\n");
+    if (!info->is_rest()) {
+      for (const auto *note : info->notes())
+        dump_text(note, depth + 1, out);
+    } else {
+      out.pad(pad + kIndent);
+      out.put("Rest\n");
+    }
+    dump_text(info->duration(), depth + 1, out);
     break;
-  case Parser::NodeKind::Note:
-    log_note(static_cast<FileReading::Parser::NoteNode *>(node), pad);
+  }
+  case Parser::NodeKind::Note: {
+    const auto *note = static_cast<const Parser::NoteNode *>(node);
+    out.put("[Note] ");
+    out.put(note_to_str(note->note()));
+    out.put(acc_to_str(note->accidental()));
+    out.put(' ');
+    out.put_number(note->octave());
+    out.put('\n');
     break;
-  case Parser::NodeKind::Duration:
-    log_duration(static_cast<FileReading::Parser::DurationNode *>(node), pad);
+  }
+  case Parser::NodeKind::Duration: {
+    const auto *duration = static_cast<const Parser::DurationNode *>(node);
+    out.put("[Duration] ");
+    out.put(duration_to_string(duration->duration()));
+    out.put(duration->dotted() ? "[dotted? yes]\n" : "[dotted? no]\n");
     break;
+  }
   case Parser::NodeKind::Label:
-    log_label(static_cast<FileReading::Parser::LabelNode *>(node), pad);
+    out.put("[Label] ");
+    out.put(static_cast<const Parser::LabelNode *>(node)->label());
+    out.put('\n');
     break;
   case Parser::NodeKind::Song:
     break;
   case Parser::NodeKind::Error:
-    log_error(pad);
+    out.put("[Error]\n");
     break;
   case Parser::NodeKind::Eof:
-    std::cout << pad << "[EOF]" << std::endl;
+    out.put("[EOF]\n");
     break;
   }
 }
 
-void log_nodes(std::vector<Parser::Node *> nodes) {
-  std::cout << nodes.size() << std::endl;
-  for (auto node : nodes) {
-    log_node(node);
+void dump_json(const Parser::Node *node, DumpWriter &out) {
+  out.put("{\"kind\":\"");
+  out.put(node_kind_to_str(node != nullptr ? node->kind()
+                                           : Parser::NodeKind::Error));
+  out.put('"');
+  if (node == nullptr) {
+    out.put('}');
+    return;
+  }
+  if (const auto *token = node->token()) {
+    out.put(",\"line\":");
+    out.put_number(token->loc.line);
+    out.put(",\"col\":");
+    out.put_number(token->loc.col);
   }
-}
-
-void log_label(Parser::LabelNode *node, std::string pad) {
-  std::cout << pad << "[Label] " << node->label() << std::endl;
-}
-
-void log_duration(Parser::DurationNode *node, std::string pad) {
-  auto duration_kind = node->duration();
-  auto dotted = node->dotted() ? "yes" : "no";
 
-  std::cout << pad << "[Duration] " << duration_to_string(duration_kind)
-            << "[dotted? " << dotted << "]" << std::endl;
+  switch (node->kind()) {
+  case Parser::NodeKind::Bpm_Decl: {
+    const auto *bpm = static_cast<const Parser::BpmNode *>(node);
+    out.put(",\"bpm\":");
+    out.put_number(bpm->bpm());
+    out.put(",\"duration\":");
+    dump_json(bpm->duration(), out);
+    break;
+  }
+  case Parser::NodeKind::Note_Info: {
+    const auto *info = static_cast<const Parser::NoteInfoNode *>(node);
+    out.put(info->is_chord() ? ",\"chord\":true" : ",\"chord\":false");
+    out.put(info->is_rest() ? ",\"rest\":true" : ",\"rest\":false");
+    out.put(",\"notes\":[");
+    bool first = true;
+    for (const auto *note : info->notes()) {
+      if (!first)
+        out.put(',');
+      first = false;
+      dump_json(note, out);
+    }
+    out.put("],\"duration\":");
+    dump_json(info->duration(), out);
+    break;
+  }
+  case Parser::NodeKind::Note: {
+    const auto *note = static_cast<const Parser::NoteNode *>(node);
+    out.put(",\"note\":\"");
+    out.put(note_to_str(note->note()));
+    out.put("\",\"accidental\":\"");
+    out.put(acc_to_str(note->accidental()));
+    out.put("\",\"octave\":");
+    out.put_number(note->octave());
+    break;
+  }
+  case Parser::NodeKind::Duration: {
+    const auto *duration = static_cast<const Parser::DurationNode *>(node);
+    out.put(",\"value\":\"");
+    out.put(duration_to_string(duration->duration()));
+    out.put(duration->dotted() ? "\",\"dotted\":true"
+                               : "\",\"dotted\":false");
+    break;
+  }
+  case Parser::NodeKind::Label:
+    out.put(",\"label\":");
+    out.put_json(static_cast<const Parser::LabelNode *>(node)->label());
+    break;
+  default:
+    break;
+  }
+  out.put('}');
 }
 
-void log_note(Parser::NoteNode *node, std::string pad) {
-  auto note = note_to_str(node->note());
-  auto acc = acc_to_str(node->accidental());
-  auto oct = node->octave();
+void dump_binary(const Parser::Node *node, DumpWriter &out) {
+  const auto kind =
+      node != nullptr ? node->kind() : Parser::NodeKind::Error;
+  const auto *token = node != nullptr ? node->token() : nullptr;
+  out.put_le(static_cast<std::uint8_t>(kind));
+  out.put_le(
+      static_cast<std::uint32_t>(token != nullptr ? token->loc.line : 0));
+  out.put_le(static_cast<std::uint32_t>(token != nullptr ? token->loc.col : 0));
+  if (node == nullptr)
+    return;
 
-  std::cout << pad << "[Note] " << note << acc << " " << oct << std::endl;
+  switch (kind) {
+  case Parser::NodeKind::Bpm_Decl: {
+    const auto *bpm = static_cast<const Parser::BpmNode *>(node);
+    out.put_le(static_cast<std::uint32_t>(bpm->bpm()));
+    dump_binary(bpm->duration(), out);
+    break;
+  }
+  case Parser::NodeKind::Note_Info: {
+    const auto *info = static_cast<const Parser::NoteInfoNode *>(node);
+    const auto notes = info->notes();
+    out.put_le(static_cast<std::uint8_t>((info->is_chord() ? 1 : 0) |
+                                         (info->is_rest() ? 2 : 0)));
+    out.put_le(static_cast<std::uint32_t>(notes.size()));
+    for (const auto *note : notes)
+      dump_binary(note, out);
+    dump_binary(info->duration(), out);
+    break;
+  }
+  case Parser::NodeKind::Note: {
+    const auto *note = static_cast<const Parser::NoteNode *>(node);
+    out.put(note_to_str(note->note()));
+    out.put_le(static_cast<std::uint8_t>(note->accidental()));
+    out.put_le(static_cast<std::uint32_t>(note->octave()));
+    break;
+  }
+  case Parser::NodeKind::Duration: {
+    const auto *duration = static_cast<const Parser::DurationNode *>(node);
+    out.put_le(static_cast<std::uint8_t>(duration->duration()));
+    out.put_le(static_cast<std::uint8_t>(duration->dotted()));
+    break;
+  }
+  case Parser::NodeKind::Label: {
+    const auto label = static_cast<const Parser::LabelNode *>(node)->label();
+    out.put_le(static_cast<std::uint32_t>(label.size()));
+    out.put(label);
+    break;
+  }
+  default:
+    break;
+  }
 }
 
-void log_note_info(Parser::NoteInfoNode *node, std::string pad) {
-  std::cout << pad << "[NoteInfo]" << std::endl;
-  if (!node->is_rest())
-    log_node(node->note(), pad + "    ");
-  else
-    std::cout << pad << "    " << "Rest" << std::endl;
-  log_node(node->duration(), pad + "    ");
-}
+} // namespace
 
-void log_bpm(Parser::BpmNode *node, std::string pad) {
-  std::cout << pad << "[BPM] " << node->bpm() << std::endl;
-  log_node(node->duration(), "    ");
+void dump_nodes(std::span<Parser::Node *const> nodes, DumpFormat format,
+                DumpWriter &out) {
+  switch (format) {
+  case DumpFormat::Text:
+    out.put_number(nodes.size());
+    out.put('\n');
+    for (const auto *node : nodes)
+      dump_text(node, 0, out);
+    break;
+  case DumpFormat::Jsonl:
+    for (const auto *node : nodes) {
+      dump_json(node, out);
+      out.put('\n');
+    }
+    break;
+  case DumpFormat::Binary:
+    out.put("MGN1");
+    out.put_le(static_cast<std::uint32_t>(nodes.size()));
+    for (const auto *node : nodes)
+      dump_binary(node, out);
+    break;
+  }
+  out.flush();
 }
 
-void log_error(std::string pad) { std::cout << pad << "[Error]" << std::endl; }
 } // namespace FileReading::Logging
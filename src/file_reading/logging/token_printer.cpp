@@ -1,12 +1,70 @@
-#include <iostream>
-
 #include "file_reading/lexer/token.hpp"
 #include "file_reading/logging/token_printer.hpp"
 
 namespace FileReading::Logging {
-void log_tokens(std::vector<Lexer::Token *> tokens) {
-  for (auto token : tokens) {
-    std::cout << token->to_string();
+
+namespace {
+
+void dump_text(const Lexer::Token &token, DumpWriter &out) {
+  out.put('[');
+  out.put(Lexer::token_kind_to_str(token.kind));
+  out.put("] '");
+  out.put(token.lexeme);
+  out.put("' (");
+  out.put_number(token.loc.line);
+  out.put(", ");
+  out.put_number(token.loc.col);
+  out.put(")\n");
+}
+
+void dump_json(const Lexer::Token &token, std::size_t offset,
+               DumpWriter &out) {
+  out.put("{\"kind\":\"");
+  out.put(Lexer::token_kind_to_str(token.kind));
+  out.put("\",\"lexeme\":");
+  out.put_json(token.lexeme);
+  out.put(",\"line\":");
+  out.put_number(token.loc.line);
+  out.put(",\"col\":");
+  out.put_number(token.loc.col);
+  out.put(",\"offset\":");
+  out.put_number(offset);
+  out.put("}\n");
+}
+
+void dump_binary(const Lexer::Token &token, std::size_t offset,
+                 DumpWriter &out) {
+  out.put_le(static_cast<std::uint8_t>(token.kind));
+  out.put_le(static_cast<std::uint32_t>(token.loc.line));
+  out.put_le(static_cast<std::uint32_t>(token.loc.col));
+  out.put_le(static_cast<std::uint64_t>(offset));
+  out.put_le(static_cast<std::uint32_t>(token.lexeme.size()));
+  out.put(token.lexeme);
+}
+
+} // namespace
+
+void dump_tokens(std::span<Lexer::Token *const> tokens,
+                 std::string_view source, DumpFormat format,
+                 DumpWriter &out) {
+  if (format == DumpFormat::Binary)
+    out.put("MGT1");
+  for (const auto *token : tokens) {
+    const auto offset =
+        static_cast<std::size_t>(token->lexeme.data() - source.data());
+    switch (format) {
+    case DumpFormat::Text:
+      dump_text(*token, out);
+      break;
+    case DumpFormat::Jsonl:
+      dump_json(*token, offset, out);
+      break;
+    case DumpFormat::Binary:
+      dump_binary(*token, offset, out);
+      break;
+    }
   }
+  out.flush();
 }
+
 } // namespace FileReading::Logging
@@ -6,12 +6,26 @@ namespace FileReading::Parser {
 
 NoteInfoNode::NoteInfoNode(FileReading::Lexer::Token *token, NoteNode *note,
                            DurationNode *duration)
-    : Node(token), _note(note), _duration(duration), _is_rest(note == nullptr) {
+    : Node(token), _duration(duration), _is_rest(note == nullptr) {
+  if (note != nullptr)
+    _notes.push_back(note);
 }
 
+NoteInfoNode::NoteInfoNode(FileReading::Lexer::Token *token,
+                           std::vector<NoteNode *> chord,
+                           DurationNode *duration)
+    : Node(token), _notes(std::move(chord)), _duration(duration),
+      _is_rest(_notes.empty()), _is_chord(true) {}
+
 NodeKind NoteInfoNode::kind() const { return NodeKind::Note_Info; }
 
-NoteNode *NoteInfoNode::note() const { return _note; }
+NoteNode *NoteInfoNode::note() const {
+  return _notes.empty() ? nullptr : _notes.front();
+}
+
+std::span<NoteNode *const> NoteInfoNode::notes() const { return _notes; }
+
+bool NoteInfoNode::is_chord() const { return _is_chord; }
 
 DurationNode *NoteInfoNode::duration() const { return _duration; }
 
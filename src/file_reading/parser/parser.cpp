@@ -1,3 +1,6 @@
+#include <algorithm>
+#include <charconv>
+#include <utility>
 #include <iostream>
 
 #include "file_reading/lexer/lexer.hpp"
@@ -8,6 +11,13 @@
 
 namespace FileReading::Parser {
 
+/// Value of a Number token, read straight out of the source text.
+long long number_value(std::string_view digits) {
+  long long value = 0;
+  std::from_chars(digits.data(), digits.data() + digits.size(), value);
+  return value;
+}
+
 DurationKind dur_from_char(char c) {
   switch (c) {
   case 'w':
@@ -29,27 +39,62 @@ DurationKind dur_from_char(char c) {
   }
 }
 
-Parser::Parser(std::string_view contents) : _contents(contents) {
-  auto const lexer = new FileReading::Lexer::Lexer(contents);
-  _tokens = lexer->lex();
-  _diagnostics = lexer->diagnostics();
+TextEdit diff_text(std::string_view before, std::string_view after) {
+  const auto shorter = std::min(before.size(), after.size());
+  std::size_t prefix = 0;
+  while (prefix < shorter && before[prefix] == after[prefix])
+    ++prefix;
+  std::size_t suffix = 0;
+  while (suffix < shorter - prefix &&
+         before[before.size() - 1 - suffix] == after[after.size() - 1 - suffix])
+    ++suffix;
+  return TextEdit{
+      .offset = prefix,
+      .removed = before.size() - prefix - suffix,
+      .inserted = after.substr(prefix, after.size() - prefix - suffix)};
 }
 
-ParseResult::ParseResult(SongNode *song, std::vector<Node *> nodes,
-                         std::vector<std::string> diag)
-    : _song_node(song), _nodes(nodes), _diagnostics(diag) {}
+Parser::Parser(std::string_view contents, std::pmr::memory_resource *memory)
+    : _contents(contents), _lexer(contents, memory), _tokens(memory),
+      _memory(memory), _owned_nodes(memory) {
+  _tokens = _lexer.lex();
+  index_lines();
+}
+
+void Parser::index_lines() {
+  _line_starts.assign(1, 0);
+  for (auto at = _contents.find('\n'); at != std::string_view::npos;
+       at = _contents.find('\n', at + 1))
+    _line_starts.push_back(at + 1);
+}
+
+Parser::~Parser() { free_nodes(); }
 
-std::vector<std::string> ParseResult::diagnostics() const {
-  return _diagnostics;
+void Parser::free_nodes() {
+  for (auto &[node, destroy] : _owned_nodes) {
+    if (node != nullptr)
+      destroy(_memory, node);
+  }
+  _owned_nodes.clear();
 }
 
-std::vector<Node *> ParseResult::nodes() const { return _nodes; }
+ParseResult::ParseResult(SongNode *song, std::vector<Node *> nodes,
+                         Diagnostics diag)
+    : _song_node(song), _nodes(std::move(nodes)),
+      _diagnostics(std::move(diag)) {}
+
+const Diagnostics &ParseResult::diagnostics() const { return _diagnostics; }
+
+std::span<Node *const> ParseResult::nodes() const { return _nodes; }
 
 bool ParseResult::error() const { return !_diagnostics.empty(); }
 
 SongNode *ParseResult::song() const { return _song_node; }
 
-FileReading::Lexer::Token *Parser::_peek() const { return _tokens[_idx]; }
+FileReading::Lexer::Token *Parser::_peek() const {
+  // Past the end everything looks like the Eof token, as with [_next]
+  return _tokens[std::min(_idx, _tokens.size() - 1)];
+}
 
 FileReading::Lexer::Token *Parser::_next() {
   if (_idx >= _tokens.size())
@@ -60,42 +105,240 @@ FileReading::Lexer::Token *Parser::_next() {
   return tok;
 }
 
-ParseResult *Parser::parse() {
-  if (!_diagnostics.empty()) {
-    return new ParseResult(nullptr, {}, _diagnostics);
-  }
-
-  auto bpm = parse_bpm_node();
-  auto start = parse_label_node();
+ParseResult Parser::parse() {
+  _top.clear();
+  _top_begin.clear();
+  _song = nullptr;
+  _diagnostics.clear();
+
+  // Any error skips ahead to where the next note or label can start, so one
+  // mistake is reported once and the ones after it are still found
+  auto bpm = parse_top(&Parser::parse_bpm_node);
+  if (bpm->kind() == NodeKind::Error)
+    synchronize();
+  auto start = parse_top(&Parser::parse_label_node);
+  if (start->kind() == NodeKind::Error)
+    synchronize();
   LabelNode *end = nullptr;
-  std::vector<Node *> nodes{bpm, start};
-  std::vector<NoteInfoNode *> note_info_nodes{};
+  std::vector<std::vector<NoteInfoNode *>> voices(1);
   bool eof = false;
   while (!eof) {
-    auto node = parse_node();
-    nodes.push_back(node);
+    auto node = parse_top(&Parser::parse_node);
     auto kind = node->kind();
     switch (kind) {
     case NodeKind::Label:
-      end = static_cast<LabelNode *>(node);
+      // Every further [START] opens another voice playing alongside
+      if (static_cast<LabelNode *>(node)->label() == "START")
+        voices.emplace_back();
+      else
+        end = static_cast<LabelNode *>(node);
       break;
     case NodeKind::Eof:
       eof = true;
       break;
     case NodeKind::Note_Info:
-      note_info_nodes.push_back(static_cast<NoteInfoNode *>(node));
+      voices.back().push_back(static_cast<NoteInfoNode *>(node));
+      break;
+    case NodeKind::Error:
+      synchronize();
       break;
     default:
       break;
     }
   }
+  _diagnostics.merge(_lexer.diagnostics());
+
+  auto song_node = make_node<SongNode>(
+      _tokens.front(), dynamic_cast<BpmNode *>(bpm),
+      dynamic_cast<LabelNode *>(start), voices,
+      dynamic_cast<LabelNode *>(end));
+
+  _song = song_node;
+  return ParseResult(song_node, _top, _diagnostics);
+}
 
-  auto song_node =
-      new SongNode(_tokens.front(), dynamic_cast<BpmNode *>(bpm),
-                   dynamic_cast<LabelNode *>(start), note_info_nodes,
-                   dynamic_cast<LabelNode *>(end));
+Node *Parser::parse_top(Node *(Parser::*parse)()) {
+  _top_begin.push_back(_idx);
+  auto node = (this->*parse)();
+  _top.push_back(node);
+  return node;
+}
+
+ParseResult Parser::reparse(std::string_view contents, const TextEdit &edit) {
+  if (auto result = splice(contents, edit)) {
+    _spliced = true;
+    return *result;
+  }
 
-  return new ParseResult(song_node, nodes, _diagnostics);
+  _spliced = false;
+  _contents = contents;
+  _lexer.reset(contents);
+  free_nodes();
+  _idx = 0;
+  _dead_tokens = 0;
+  _tokens = _lexer.lex();
+  index_lines();
+  return parse();
+}
+
+bool Parser::spliced() const { return _spliced; }
+
+std::optional<ParseResult> Parser::splice(std::string_view contents,
+                                          const TextEdit &edit) {
+  using Lexer::TokenKind;
+  const auto old_size = _contents.size();
+  if (_song == nullptr || !_diagnostics.empty() ||
+      _dead_tokens > _tokens.size() || edit.offset + edit.removed > old_size ||
+      contents.size() != old_size - edit.removed + edit.inserted.size())
+    return std::nullopt;
+
+  // Lines the edit touches, as indices into [_line_starts], and where they
+  // start and end (past their last line break) before and after the edit
+  auto line_of = [&](std::size_t offset) {
+    return static_cast<std::size_t>(
+        std::upper_bound(_line_starts.begin(), _line_starts.end(), offset) -
+        _line_starts.begin() - 1);
+  };
+  const auto first = line_of(edit.offset);
+  const auto last = line_of(edit.offset + edit.removed);
+  const bool to_end = last + 1 == _line_starts.size();
+  const auto begin = _line_starts[first];
+  const auto old_end = to_end ? old_size : _line_starts[last + 1];
+  const auto new_end = old_end - edit.removed + edit.inserted.size();
+  const auto fragment = contents.substr(begin, new_end - begin);
+
+  // Old tokens on those lines (token lines count from 1), which have to be a
+  // run of whole notes. The Eof token stays, it only moves.
+  const auto eof_token = _tokens.size() - 1;
+  auto token_at_line = [&](std::size_t line) {
+    return static_cast<std::size_t>(
+        std::partition_point(_tokens.begin(), _tokens.end() - 1,
+                             [&](const Lexer::Token *t) {
+                               return t->loc.line < line;
+                             }) -
+        _tokens.begin());
+  };
+  const auto tok_begin = token_at_line(first + 1);
+  const auto tok_end = token_at_line(last + 2);
+  const auto node_begin = static_cast<std::size_t>(
+      std::lower_bound(_top_begin.begin(), _top_begin.end(), tok_begin) -
+      _top_begin.begin());
+  const auto node_end = static_cast<std::size_t>(
+      std::lower_bound(_top_begin.begin(), _top_begin.end(), tok_end) -
+      _top_begin.begin());
+  if (node_begin < 2 || node_end == _top.size() ||
+      _top_begin[node_begin] != tok_begin || _top_begin[node_end] != tok_end)
+    return std::nullopt;
+  for (auto n = node_begin; n < node_end; ++n) {
+    if (_top[n]->kind() != NodeKind::Note_Info)
+      return std::nullopt;
+  }
+
+  // Lex and parse the new lines on their own; the fragment's own Eof token
+  // stands in for whatever follows
+  const auto fragment_tokens = _lexer.lex_fragment(
+      fragment, Lexer::SourceLocation{.line = first + 1, .col = 1});
+  if (_lexer.error())
+    return std::nullopt;
+  std::vector<Node *> nodes;
+  std::vector<std::size_t> nodes_begin;
+  // Diagnostics measure offsets against [_contents]; a failed splice parses
+  // the new text from scratch anyway
+  const auto old_contents = std::exchange(_contents, contents);
+  {
+    auto tokens = std::move(_tokens);
+    _tokens = fragment_tokens;
+    _idx = 0;
+    bool ok = true;
+    while (ok && _peek()->kind != TokenKind::Eof) {
+      nodes_begin.push_back(tok_begin + _idx);
+      nodes.push_back(parse_node());
+      ok = nodes.back()->kind() == NodeKind::Note_Info && _diagnostics.empty();
+    }
+    _tokens = std::move(tokens);
+    if (!ok)
+      return std::nullopt;
+  }
+
+  // Voice the notes belong to, and where in it they start
+  std::size_t voice = 0;
+  std::size_t position = 0;
+  for (std::size_t n = 2; n < node_begin; ++n) {
+    const auto kind = _top[n]->kind();
+    if (kind == NodeKind::Label &&
+        static_cast<LabelNode *>(_top[n])->label() == "START") {
+      ++voice;
+      position = 0;
+    } else if (kind == NodeKind::Note_Info) {
+      ++position;
+    }
+  }
+  std::vector<NoteInfoNode *> notes;
+  notes.reserve(nodes.size());
+  for (auto node : nodes)
+    notes.push_back(static_cast<NoteInfoNode *>(node));
+  _song->splice_notes(voice, position, node_end - node_begin, notes);
+
+  // Everything after the edited lines moves by the difference in lines,
+  // tokens and bytes
+  const auto new_tokens = fragment_tokens.size() - 1;
+  const auto old_lines = static_cast<std::ptrdiff_t>(last - first) + !to_end;
+  const auto new_lines = static_cast<std::ptrdiff_t>(
+      std::count(fragment.begin(), fragment.end(), '\n'));
+  const auto line_shift = new_lines - old_lines;
+  const auto byte_shift = static_cast<std::ptrdiff_t>(edit.inserted.size()) -
+                          static_cast<std::ptrdiff_t>(edit.removed);
+  // Lexemes of the tokens kept still point into the old text; the same bytes
+  // are in the new one, [byte_shift] further on past the edit
+  auto rebase = [&](Lexer::Token *token, std::ptrdiff_t shift) {
+    const auto at = token->lexeme.data() - old_contents.data() + shift;
+    token->lexeme =
+        contents.substr(static_cast<std::size_t>(at), token->lexeme.size());
+  };
+  for (std::size_t t = 0; t < tok_begin; ++t)
+    rebase(_tokens[t], 0);
+  for (auto t = tok_end; t < _tokens.size(); ++t) {
+    _tokens[t]->loc.line = static_cast<std::size_t>(
+        static_cast<std::ptrdiff_t>(_tokens[t]->loc.line) + line_shift);
+    rebase(_tokens[t], byte_shift);
+  }
+  if (to_end)
+    _tokens[eof_token]->loc = fragment_tokens.back()->loc;
+
+  _dead_tokens += tok_end - tok_begin + 1;
+  _tokens.erase(_tokens.begin() + static_cast<std::ptrdiff_t>(tok_begin),
+                _tokens.begin() + static_cast<std::ptrdiff_t>(tok_end));
+  _tokens.insert(_tokens.begin() + static_cast<std::ptrdiff_t>(tok_begin),
+                 fragment_tokens.begin(), fragment_tokens.end() - 1);
+
+  const auto token_shift = static_cast<std::ptrdiff_t>(new_tokens) -
+                           static_cast<std::ptrdiff_t>(tok_end - tok_begin);
+  for (auto n = node_end; n < _top_begin.size(); ++n)
+    _top_begin[n] = static_cast<std::size_t>(
+        static_cast<std::ptrdiff_t>(_top_begin[n]) + token_shift);
+  const auto top_at = static_cast<std::ptrdiff_t>(node_begin);
+  const auto top_end = static_cast<std::ptrdiff_t>(node_end);
+  _top.erase(_top.begin() + top_at, _top.begin() + top_end);
+  _top.insert(_top.begin() + top_at, nodes.begin(), nodes.end());
+  _top_begin.erase(_top_begin.begin() + top_at, _top_begin.begin() + top_end);
+  _top_begin.insert(_top_begin.begin() + top_at, nodes_begin.begin(),
+                    nodes_begin.end());
+
+  std::vector<std::size_t> line_starts;
+  for (auto at = fragment.find('\n'); at != std::string_view::npos;
+       at = fragment.find('\n', at + 1))
+    line_starts.push_back(begin + at + 1);
+  for (auto l = last + 1; l < _line_starts.size(); ++l)
+    _line_starts[l] = static_cast<std::size_t>(
+        static_cast<std::ptrdiff_t>(_line_starts[l]) + byte_shift);
+  const auto lines_at = static_cast<std::ptrdiff_t>(first + 1);
+  _line_starts.erase(_line_starts.begin() + lines_at,
+                     _line_starts.begin() + lines_at +
+                         static_cast<std::ptrdiff_t>(old_lines));
+  _line_starts.insert(_line_starts.begin() + lines_at, line_starts.begin(),
+                      line_starts.end());
+
+  return ParseResult(_song, _top, _diagnostics);
 }
 
 Node *Parser::parse_node() {
@@ -109,86 +352,76 @@ Node *Parser::parse_node() {
   case Lexer::TokenKind::Duration:
     return parse_duration_node();
   case Lexer::TokenKind::LBracket:
+    if (_idx + 1 < _tokens.size() &&
+        _tokens[_idx + 1]->kind != Lexer::TokenKind::Identifier &&
+        _tokens[_idx + 1]->kind != Lexer::TokenKind::Error)
+      return parse_chord_node();
     return parse_label_node();
   case Lexer::TokenKind::Error:
-    return new ErrorNode(_next()); // TODO: handle error type
+    // Already reported by the lexer
+    return make_node<ErrorNode>(_next());
   case Lexer::TokenKind::Eof:
     return parse_eof_node();
   default:
-    return new ErrorNode(_next()); // TODO: handle error type
+    // Nothing starts with this token; skip it so parsing moves on
+    report(DiagnosticCode::UnexpectedToken, _peek(), Lexer::TokenKind::NoteId,
+           kind);
+    return make_node<ErrorNode>(_next());
   }
 }
 
 Node *Parser::parse_label_node() {
-  FileReading::Lexer::Token *err_tok = nullptr;
-
-  auto l_bracket_token = _next();
-  match_and_flag(l_bracket_token, err_tok,
-                 FileReading::Lexer::TokenKind::LBracket);
+  if (expect(Lexer::TokenKind::LBracket) == nullptr)
+    return error_node();
 
-  auto id_token = _next();
-  match_and_flag(id_token, err_tok, FileReading::Lexer::TokenKind::Identifier);
+  auto id_token = expect(Lexer::TokenKind::Identifier);
+  if (id_token == nullptr)
+    return error_node();
 
-  auto r_bracket_token = _next();
-  match_and_flag(r_bracket_token, err_tok,
-                 FileReading::Lexer::TokenKind::RBracket);
+  if (expect(Lexer::TokenKind::RBracket) == nullptr)
+    return error_node();
 
-  if (err_tok != nullptr)
-    return new ErrorNode(err_tok);
-
-  return new LabelNode(id_token, id_token->lexeme);
+  return make_node<LabelNode>(id_token, std::string{id_token->lexeme});
 }
 
 Node *Parser::parse_bpm_node() {
-  FileReading::Lexer::Token *err_tok = nullptr;
-
-  auto bpm_token = _next();
-  match_and_flag(bpm_token, err_tok, FileReading::Lexer::TokenKind::Bpm);
-
-  auto colon_token = _next(); // ':'
-  match_and_flag(colon_token, err_tok, FileReading::Lexer::TokenKind::Colon);
+  auto bpm_token = expect(Lexer::TokenKind::Bpm);
+  if (bpm_token == nullptr || expect(Lexer::TokenKind::Colon) == nullptr)
+    return error_node();
 
   auto duration_node = parse_duration_node();
-  if (duration_node->kind() == NodeKind::Error) {
-    // do something
-  }
-
-  auto eq_token = _next(); // '='
-  match_and_flag(eq_token, err_tok, FileReading::Lexer::TokenKind::Equal);
+  if (duration_node->kind() == NodeKind::Error)
+    return duration_node;
 
-  auto bpm_number_token = _next();
-  match_and_flag(bpm_number_token, err_tok,
-                 FileReading::Lexer::TokenKind::Number);
+  if (expect(Lexer::TokenKind::Equal) == nullptr)
+    return error_node();
 
-  if (err_tok != nullptr)
-    return new ErrorNode(err_tok);
+  auto bpm_number_token = expect(Lexer::TokenKind::Number);
+  if (bpm_number_token == nullptr)
+    return error_node();
 
-  return new BpmNode(bpm_token, std::atoll(bpm_number_token->lexeme.c_str()),
-                     dynamic_cast<DurationNode *>(duration_node));
+  return make_node<BpmNode>(bpm_token, number_value(bpm_number_token->lexeme),
+                            static_cast<DurationNode *>(duration_node));
 }
 
 Node *Parser::parse_eof_node() {
   auto token = _next();
-  return new EofNode(token);
+  return make_node<EofNode>(token);
 }
 
 Node *Parser::parse_duration_node() {
-  FileReading::Lexer::Token *err_tok = nullptr;
+  auto duration_token = expect(Lexer::TokenKind::Duration);
+  if (duration_token == nullptr)
+    return error_node();
 
-  auto duration_token = _next();
-  match_and_flag(duration_token, err_tok,
-                 FileReading::Lexer::TokenKind::Duration);
   FileReading::Lexer::Token *dot_token = nullptr;
   if (_peek()->kind == FileReading::Lexer::TokenKind::Dot) {
     dot_token = _next();
   }
 
-  if (err_tok != nullptr)
-    return new ErrorNode(err_tok);
-
-  return new DurationNode(duration_token,
-                          dur_from_char(duration_token->lexeme[0]),
-                          dot_token != nullptr);
+  return make_node<DurationNode>(duration_token,
+                                 dur_from_char(duration_token->lexeme[0]),
+                                 dot_token != nullptr);
 }
 
 Note note_from_char(char c) {
@@ -211,32 +444,26 @@ Accidental accidental_from_char(char c) {
 }
 
 Node *Parser::parse_note_node() {
-  FileReading::Lexer::Token *err_tok = nullptr;
-
-  auto note_token = _next();
-  match_and_flag(note_token, err_tok, FileReading::Lexer::TokenKind::NoteId);
+  auto note_token = expect(Lexer::TokenKind::NoteId);
+  if (note_token == nullptr)
+    return error_node();
 
   FileReading::Lexer::Token *accidental_token = nullptr;
   if (_peek()->kind == FileReading::Lexer::TokenKind::Accidental) {
     accidental_token = _next();
   }
-  unsigned int note_octave = 99;
-  auto octave_token = _next();
-  if (!match_and_flag(octave_token, err_tok,
-                      FileReading::Lexer::TokenKind::Number)) {
-  } else {
-    note_octave = std::atoll(octave_token->lexeme.c_str());
-  }
 
-  if (err_tok != nullptr) {
-    return new ErrorNode(err_tok);
-  }
+  auto octave_token = expect(Lexer::TokenKind::Number);
+  if (octave_token == nullptr)
+    return error_node();
+  auto note_octave =
+      static_cast<unsigned int>(number_value(octave_token->lexeme));
 
   auto accidental = accidental_token != nullptr
                         ? accidental_from_char(accidental_token->lexeme[0])
                         : FileReading::Parser::Accidental::None;
   auto note_letter = note_from_char(note_token->lexeme[0]);
-  return new NoteNode(note_token, note_letter, accidental, note_octave);
+  return make_node<NoteNode>(note_token, note_letter, accidental, note_octave);
 }
 
 Node *Parser::parse_note_info_node() {
@@ -244,52 +471,94 @@ Node *Parser::parse_note_info_node() {
   FileReading::Lexer::Token *tok = nullptr;
   if (_peek()->kind != FileReading::Lexer::TokenKind::Rest) {
     note_node = parse_note_node();
+    if (note_node->kind() == NodeKind::Error)
+      return note_node;
     tok = note_node->token();
   } else {
-    auto rest_token = _next();
-    match(rest_token, FileReading::Lexer::TokenKind::Rest);
-    tok = rest_token;
+    tok = _next();
   }
+
   auto duration_node = parse_duration_node();
+  if (duration_node->kind() == NodeKind::Error)
+    return duration_node;
 
-  return new NoteInfoNode(tok, dynamic_cast<NoteNode *>(note_node),
-                          dynamic_cast<DurationNode *>(duration_node));
+  return make_node<NoteInfoNode>(tok, static_cast<NoteNode *>(note_node),
+                                 static_cast<DurationNode *>(duration_node));
 }
 
-bool Parser::match(FileReading::Lexer::Token *token,
-                   FileReading::Lexer::TokenKind expected) {
+Node *Parser::parse_chord_node() {
+  auto l_bracket_token = expect(Lexer::TokenKind::LBracket);
+  if (l_bracket_token == nullptr)
+    return error_node();
+
+  std::vector<NoteNode *> chord;
+  while (_peek()->kind == FileReading::Lexer::TokenKind::NoteId) {
+    auto note_node = parse_note_node();
+    if (note_node->kind() == NodeKind::Error)
+      return note_node;
+    chord.push_back(static_cast<NoteNode *>(note_node));
+  }
+
+  if (expect(Lexer::TokenKind::RBracket) == nullptr)
+    return error_node();
 
-  if (token->kind != expected) {
-    report_unexpected_token(expected, token->kind, token->loc);
-    return false;
+  auto duration_node = parse_duration_node();
+  if (duration_node->kind() == NodeKind::Error)
+    return duration_node;
+
+  if (chord.empty()) {
+    report(DiagnosticCode::EmptyChord, l_bracket_token);
+    return make_node<ErrorNode>(l_bracket_token);
   }
 
-  return true;
+  return make_node<NoteInfoNode>(l_bracket_token, chord,
+                                 static_cast<DurationNode *>(duration_node));
 }
 
-bool Parser::match_and_flag(FileReading::Lexer::Token *token,
-                            FileReading::Lexer::Token *&err_tok,
-                            FileReading::Lexer::TokenKind expected) {
-  auto matches = match(token, expected);
-  if (!matches) {
-    err_tok = token;
+FileReading::Lexer::Token *Parser::expect(FileReading::Lexer::TokenKind kind) {
+  auto token = _peek();
+  if (token->kind == kind)
+    return _next();
+
+  // The lexer has already said what's wrong with an Error token
+  if (token->kind != FileReading::Lexer::TokenKind::Error)
+    report(DiagnosticCode::UnexpectedToken, token, kind, token->kind);
+  return nullptr;
+}
+
+Node *Parser::error_node() { return make_node<ErrorNode>(_peek()); }
+
+bool Parser::starts_node(FileReading::Lexer::TokenKind kind) {
+  switch (kind) {
+  case FileReading::Lexer::TokenKind::NoteId:
+  case FileReading::Lexer::TokenKind::Rest:
+  case FileReading::Lexer::TokenKind::LBracket:
+  case FileReading::Lexer::TokenKind::Bpm:
+  case FileReading::Lexer::TokenKind::Eof:
+    return true;
+  default:
+    return false;
   }
-  return matches;
 }
 
-void Parser::report_error(std::string message,
-                          FileReading::Lexer::SourceLocation loc) {
-  _diagnostics.push_back("Error: " + message + " at " + loc.to_string());
+void Parser::synchronize() {
+  const auto line = _idx > 0 ? _tokens[_idx - 1]->loc.line : 0;
+  while (!starts_node(_peek()->kind) && _peek()->loc.line == line)
+    ++_idx;
 }
 
-void Parser::report_unexpected_token(FileReading::Lexer::TokenKind expected,
-                                     FileReading::Lexer::TokenKind actual,
-                                     FileReading::Lexer::SourceLocation loc) {
-  auto expected_tok = FileReading::Lexer::token_kind_to_str(expected);
-  auto actual_tok = FileReading::Lexer::token_kind_to_str(actual);
-  auto message = "Unexpected token [" + actual_tok + "], (expected [" +
-                 expected_tok + "])";
-  report_error(message, loc);
+void Parser::report(DiagnosticCode code, const FileReading::Lexer::Token *token,
+                    FileReading::Lexer::TokenKind expected,
+                    FileReading::Lexer::TokenKind actual) {
+  // Lexemes point into the source, which gives the offset for free
+  const auto offset =
+      static_cast<std::size_t>(token->lexeme.data() - _contents.data());
+  _diagnostics.report(
+      Diagnostic{.code = code,
+                 .loc = token->loc,
+                 .offset = offset,
+                 .expected = static_cast<std::uint32_t>(expected),
+                 .actual = static_cast<std::uint32_t>(actual)});
 }
 
 } // namespace FileReading::Parser
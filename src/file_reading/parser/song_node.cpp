@@ -5,8 +5,10 @@
 namespace FileReading::Parser {
 
 SongNode::SongNode(Lexer::Token *token, BpmNode *bpm, LabelNode *start,
-                   std::vector<NoteInfoNode *> notes, LabelNode *end)
-    : Node(token), _bpm(bpm), _start(start), _notes(notes), _end(end) {}
+                   std::vector<std::vector<NoteInfoNode *>> voices,
+                   LabelNode *end)
+    : Node(token), _bpm(bpm), _start(start), _voices(std::move(voices)),
+      _end(end) {}
 
 NodeKind SongNode::kind() const { return NodeKind::Song; }
 
@@ -14,7 +16,24 @@ BpmNode *SongNode::bpm() const { return _bpm; }
 
 LabelNode *SongNode::start() const { return _start; }
 
-std::vector<NoteInfoNode *> SongNode::notes() const { return _notes; }
+std::span<NoteInfoNode *const> SongNode::notes() const {
+  if (_voices.empty())
+    return {};
+  return _voices.front();
+}
+
+std::span<const std::vector<NoteInfoNode *>> SongNode::voices() const {
+  return _voices;
+}
+
+void SongNode::splice_notes(std::size_t voice, std::size_t first,
+                            std::size_t count,
+                            const std::vector<NoteInfoNode *> &notes) {
+  auto &line = _voices[voice];
+  const auto at = line.begin() + static_cast<std::ptrdiff_t>(first);
+  line.insert(line.erase(at, at + static_cast<std::ptrdiff_t>(count)),
+              notes.begin(), notes.end());
+}
 
 LabelNode *SongNode::end() const { return _end; }
 
@@ -0,0 +1,557 @@
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <utility>
+
+#include "file_reading/lexer/lexer.hpp"
+#include "file_reading/lexer/token.hpp"
+#include "file_reading/validator/validator.hpp"
+
+namespace FileReading::Validator {
+
+namespace {
+
+using Lexer::TokenKind;
+
+// What the lexer would make of a byte; all but the first three and [Bad]
+// are one byte tokens, or the first byte of a number
+enum Class : std::uint8_t {
+  Space,     // ' ', '\t', '\r'
+  Newline,
+  Semicolon, // a comment to the end of the line
+  Digit,
+  NoteLetter, // A-G; a B may also be the start of "BPM"
+  RestLetter,
+  AccidentalMark, // '#', 'b'
+  DurationLetter,
+  ColonMark,
+  EqualMark,
+  DotMark,
+  LBracketMark,
+  RBracketMark,
+  Bad, // starts no token
+  kClasses
+};
+
+// Where [Parser::parse] is in the grammar. The Head states are the BPM line
+// at the top, the Bpm states a tempo change among the notes.
+enum State : std::uint8_t {
+  HeadBpm,
+  HeadColon,
+  HeadDuration,
+  HeadDotOrEqual,
+  HeadEqual,
+  HeadNumber,
+  BpmColon,
+  BpmDuration,
+  BpmDotOrEqual,
+  BpmEqual,
+  BpmNumber,
+  LabelOpen, // the '[' of the label after the BPM line
+  LabelName, // a '[' the lexer took for a chord where a label has to be
+  Body,
+  AfterDuration, // a dot may follow
+  NoteOctave,    // an accidental may come first
+  NoteNumber,
+  NoteDuration,
+  ChordOpen,
+  ChordOctave,
+  ChordNumber,
+  ChordNext,
+  ChordEmptyDuration,
+  ChordDuration,
+  kStates
+};
+
+// Each state comes in three rows: between tokens, in the middle of a number
+// (whose state is the one after it) and in a comment
+enum Variant : std::uint8_t { Plain, InNumber, InComment, kVariants };
+
+constexpr std::size_t kColumns = 16;
+static_assert(kClasses <= kColumns);
+
+// Table entries are the offset of the next row; anything from [kAction] on
+// leaves the table for [Validation::run] to deal with
+constexpr std::uint16_t kAction = 0xFF00;
+constexpr std::uint16_t kGrammarError = kAction;
+constexpr std::uint16_t kBadByte = kAction + 1;
+constexpr std::uint16_t kBracket = kAction + 2;    // label or chord
+constexpr std::uint16_t kEmptyChord = kAction + 3; // at its duration
+
+constexpr std::uint16_t row(State state, Variant variant) {
+  return static_cast<std::uint16_t>(
+      (std::size_t{state} * kVariants + variant) * kColumns);
+}
+
+constexpr State state_of(std::uint16_t row) {
+  return static_cast<State>(row / (kVariants * kColumns));
+}
+
+constexpr bool in_header(State state) { return state <= HeadNumber; }
+
+constexpr std::array<std::uint8_t, 256> make_classes() {
+  std::array<std::uint8_t, 256> classes{};
+  classes.fill(Bad);
+  classes[' '] = classes['\t'] = classes['\r'] = Space;
+  classes['\n'] = Newline;
+  classes[';'] = Semicolon;
+  for (unsigned char c = '0'; c <= '9'; ++c)
+    classes[c] = Digit;
+  for (unsigned char c = 'A'; c <= 'G'; ++c)
+    classes[c] = NoteLetter;
+  classes['R'] = RestLetter;
+  classes['#'] = classes['b'] = AccidentalMark;
+  for (unsigned char c : {'w', 'h', 'q', 'e', 's', 't'})
+    classes[c] = DurationLetter;
+  classes[':'] = ColonMark;
+  classes['='] = EqualMark;
+  classes['.'] = DotMark;
+  classes['['] = LBracketMark;
+  classes[']'] = RBracketMark;
+  return classes;
+}
+
+constexpr auto kClass = make_classes();
+
+constexpr TokenKind kind_of(std::uint8_t cls) {
+  switch (cls) {
+  case Digit:
+    return TokenKind::Number;
+  case NoteLetter:
+    return TokenKind::NoteId;
+  case RestLetter:
+    return TokenKind::Rest;
+  case AccidentalMark:
+    return TokenKind::Accidental;
+  case DurationLetter:
+    return TokenKind::Duration;
+  case ColonMark:
+    return TokenKind::Colon;
+  case EqualMark:
+    return TokenKind::Equal;
+  case DotMark:
+    return TokenKind::Dot;
+  case LBracketMark:
+    return TokenKind::LBracket;
+  case RBracketMark:
+    return TokenKind::RBracket;
+  default:
+    return TokenKind::Error;
+  }
+}
+
+/// State after a [kind] token in [state], -1 if the parser reports it.
+/// Labels and chords are opened by [Validation::bracket].
+constexpr int next_state(State state, TokenKind kind) {
+  switch (state) {
+  case HeadBpm:
+    return kind == TokenKind::Bpm ? HeadColon : -1;
+  case HeadColon:
+    return kind == TokenKind::Colon ? HeadDuration : -1;
+  case HeadDuration:
+    return kind == TokenKind::Duration ? HeadDotOrEqual : -1;
+  case HeadDotOrEqual:
+    if (kind == TokenKind::Dot)
+      return HeadEqual;
+    return kind == TokenKind::Equal ? HeadNumber : -1;
+  case HeadEqual:
+    return kind == TokenKind::Equal ? HeadNumber : -1;
+  case HeadNumber:
+    return kind == TokenKind::Number ? LabelOpen : -1;
+  case BpmColon:
+    return kind == TokenKind::Colon ? BpmDuration : -1;
+  case BpmDuration:
+    return kind == TokenKind::Duration ? BpmDotOrEqual : -1;
+  case BpmDotOrEqual:
+    if (kind == TokenKind::Dot)
+      return BpmEqual;
+    return kind == TokenKind::Equal ? BpmNumber : -1;
+  case BpmEqual:
+    return kind == TokenKind::Equal ? BpmNumber : -1;
+  case BpmNumber:
+    return kind == TokenKind::Number ? Body : -1;
+  case AfterDuration:
+    if (kind == TokenKind::Dot)
+      return Body;
+    [[fallthrough]];
+  case Body:
+    switch (kind) {
+    case TokenKind::Bpm:
+      return BpmColon;
+    case TokenKind::NoteId:
+      return NoteOctave;
+    case TokenKind::Rest:
+      return NoteDuration;
+    case TokenKind::Duration:
+      return AfterDuration;
+    default:
+      return -1;
+    }
+  case NoteOctave:
+    if (kind == TokenKind::Accidental)
+      return NoteNumber;
+    [[fallthrough]];
+  case NoteNumber:
+    return kind == TokenKind::Number ? NoteDuration : -1;
+  case NoteDuration:
+  case ChordDuration:
+    return kind == TokenKind::Duration ? AfterDuration : -1;
+  case ChordOpen:
+    if (kind == TokenKind::RBracket)
+      return ChordEmptyDuration;
+    return kind == TokenKind::NoteId ? ChordOctave : -1;
+  case ChordOctave:
+    if (kind == TokenKind::Accidental)
+      return ChordNumber;
+    [[fallthrough]];
+  case ChordNumber:
+    return kind == TokenKind::Number ? ChordNext : -1;
+  case ChordNext:
+    if (kind == TokenKind::RBracket)
+      return ChordDuration;
+    return kind == TokenKind::NoteId ? ChordOctave : -1;
+  default:
+    return -1;
+  }
+}
+
+/// The token kind [Parser::parse] names as expected when [state] goes wrong.
+constexpr TokenKind expected_in(State state) {
+  switch (state) {
+  case HeadBpm:
+    return TokenKind::Bpm;
+  case HeadColon:
+  case BpmColon:
+    return TokenKind::Colon;
+  case HeadDuration:
+  case BpmDuration:
+  case NoteDuration:
+  case ChordEmptyDuration:
+  case ChordDuration:
+    return TokenKind::Duration;
+  case HeadDotOrEqual:
+  case HeadEqual:
+  case BpmDotOrEqual:
+  case BpmEqual:
+    return TokenKind::Equal;
+  case HeadNumber:
+  case BpmNumber:
+  case NoteOctave:
+  case NoteNumber:
+  case ChordOctave:
+  case ChordNumber:
+    return TokenKind::Number;
+  case LabelOpen:
+    return TokenKind::LBracket;
+  case LabelName:
+    return TokenKind::Identifier;
+  case ChordOpen:
+  case ChordNext:
+    return TokenKind::RBracket;
+  default:
+    return TokenKind::NoteId;
+  }
+}
+
+constexpr std::uint16_t plain_entry(State state, std::uint8_t cls) {
+  switch (cls) {
+  case Space:
+  case Newline:
+    return row(state, Plain);
+  case Semicolon:
+    return row(state, InComment);
+  case Bad:
+    return kBadByte;
+  default:
+    break;
+  }
+  const auto kind = kind_of(cls);
+  if (kind == TokenKind::LBracket &&
+      (state == LabelOpen || state == Body || state == AfterDuration))
+    return kBracket;
+  if (kind == TokenKind::Duration && state == ChordEmptyDuration)
+    return kEmptyChord;
+  const auto next = next_state(state, kind);
+  if (next < 0)
+    return kGrammarError;
+  return row(static_cast<State>(next),
+             kind == TokenKind::Number ? InNumber : Plain);
+}
+
+constexpr auto make_table() {
+  std::array<std::uint16_t, std::size_t{kStates} * kVariants * kColumns>
+      table{};
+  table.fill(kBadByte);
+  for (std::uint8_t s = 0; s < kStates; ++s) {
+    const auto state = static_cast<State>(s);
+    for (std::uint8_t cls = 0; cls < kClasses; ++cls) {
+      const auto plain = plain_entry(state, cls);
+      table[row(state, Plain) + cls] = plain;
+      table[row(state, InNumber) + cls] =
+          cls == Digit ? row(state, InNumber) : plain;
+      table[row(state, InComment) + cls] =
+          cls == Newline ? row(state, Plain) : row(state, InComment);
+    }
+  }
+  return table;
+}
+
+constexpr auto kTable = make_table();
+
+// The same table two bytes at a time, indexed by row * kColumns plus the
+// first byte's class * kColumns plus the second's, which halves the chain of
+// dependent loads the input goes through. Where either byte leads out of the
+// table the pair does too, and [Validation::run] takes them one at a time.
+constexpr std::size_t kPairColumns = kColumns * kColumns;
+
+constexpr auto make_pair_table() {
+  std::array<std::uint16_t, std::size_t{kStates} * kVariants * kPairColumns>
+      table{};
+  table.fill(kBadByte);
+  for (std::size_t r = 0; r < std::size_t{kStates} * kVariants; ++r) {
+    for (std::uint8_t first = 0; first < kClasses; ++first) {
+      for (std::uint8_t second = 0; second < kClasses; ++second) {
+        auto next = kTable[r * kColumns + first];
+        if (next < kAction)
+          next = kTable[next + second];
+        table[r * kPairColumns + first * kColumns + second] =
+            next < kAction ? static_cast<std::uint16_t>(next * kColumns)
+                           : next;
+      }
+    }
+  }
+  return table;
+}
+
+constexpr auto kPairTable = make_pair_table();
+
+class Validation {
+private:
+  std::string_view _input;
+  std::size_t _max_errors;
+  Diagnostics _diagnostics;
+  std::size_t _chord_start = 0; // the '[' of the chord being read
+  // Line of the last error, so finding the next one only counts the lines
+  // in between
+  std::size_t _located = 0;
+  std::size_t _line = 1;
+  std::size_t _line_start = 0;
+
+  Lexer::SourceLocation locate(std::size_t offset) {
+    if (offset < _located) {
+      _located = 0;
+      _line = 1;
+      _line_start = 0;
+    }
+    for (auto nl = _input.find('\n', _located); nl < offset;
+         nl = _input.find('\n', nl + 1)) {
+      ++_line;
+      _line_start = nl + 1;
+    }
+    _located = offset;
+    return Lexer::SourceLocation{.line = _line,
+                                 .col = offset - _line_start + 1};
+  }
+
+  void report(DiagnosticCode code, std::size_t offset, std::uint32_t expected,
+              std::uint32_t actual, std::size_t located) {
+    _diagnostics.report(Diagnostic{.code = code,
+                                   .loc = locate(located),
+                                   .offset = offset,
+                                   .expected = expected,
+                                   .actual = actual});
+  }
+
+  void report(DiagnosticCode code, std::size_t offset, std::uint32_t expected,
+              std::uint32_t actual) {
+    report(code, offset, expected, actual, offset);
+  }
+
+  /// A [actual] token at [offset] where the parser wants [expected]. Tokens
+  /// are located by the lexer where they end, so that's where this goes.
+  void unexpected(std::size_t offset, TokenKind expected, TokenKind actual) {
+    auto end = offset;
+    if (actual == TokenKind::Number) {
+      while (end < _input.size() && _input[end] >= '0' && _input[end] <= '9')
+        ++end;
+    } else if (actual == TokenKind::Bpm) {
+      end += 3;
+    } else if (actual != TokenKind::Eof) {
+      ++end;
+    }
+    report(DiagnosticCode::UnexpectedToken, offset,
+           static_cast<std::uint32_t>(expected),
+           static_cast<std::uint32_t>(actual), end);
+  }
+
+  char at(std::size_t i) const { return i < _input.size() ? _input[i] : '\0'; }
+
+  /// "BPM" starting at [t] in [state]. The lexer wants all of it once it has
+  /// seen "BP", and says so after the P.
+  bool bpm(std::size_t &i, std::uint16_t &row_at, State state, std::size_t t) {
+    if (at(t + 2) != 'M') {
+      i = t + 2;
+      report(DiagnosticCode::ExpectedCharacter, t + 2, 'M',
+             static_cast<unsigned char>(at(t + 2)));
+      return false;
+    }
+    const auto next = next_state(state, TokenKind::Bpm);
+    if (next < 0) {
+      i = t;
+      unexpected(t, expected_in(state), TokenKind::Bpm);
+      return false;
+    }
+    i = t + 3;
+    row_at = row(static_cast<State>(next), Plain);
+    return true;
+  }
+
+  bool bad_byte(std::size_t &i, std::uint16_t &row_at, State state) {
+    const char c = _input[i];
+    // The note letter before it was the B of "BPM" all along
+    if (c == 'P' && i > 0 && _input[i - 1] == 'B' &&
+        (state == NoteOctave || state == ChordOctave))
+      return bpm(i, row_at, state == NoteOctave ? Body : ChordOpen, i - 1);
+
+    report(DiagnosticCode::UnexpectedCharacter, i, 0,
+           static_cast<unsigned char>(c));
+    return false;
+  }
+
+  bool grammar_error(std::size_t &i, std::uint16_t &row_at, State state) {
+    if (_input[i] == 'B' && at(i + 1) == 'P')
+      return bpm(i, row_at, state, i);
+    unexpected(i, expected_in(state),
+               kind_of(kClass[static_cast<unsigned char>(_input[i])]));
+    return false;
+  }
+
+  /// Whitespace and comments from [i] on, as the lexer skips them.
+  std::size_t skip_blank(std::size_t i) const {
+    while (i < _input.size()) {
+      const char c = _input[i];
+      if (c == ';') {
+        i = std::min(_input.find('\n', i), _input.size());
+      } else if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+        ++i;
+      } else {
+        break;
+      }
+    }
+    return i;
+  }
+
+  /// A '[' at [i]. It opens a chord or a label as the lexer decides, see
+  /// [Lexer::bracket_holds_chord]; a label is read whole here.
+  bool bracket(std::size_t &i, std::uint16_t &row_at, State state) {
+    if (Lexer::bracket_holds_chord(_input, i)) {
+      _chord_start = i;
+      ++i;
+      row_at = row(state == LabelOpen ? LabelName : ChordOpen, Plain);
+      return true;
+    }
+
+    // The name is everything from its first character up to the ']', which
+    // may be the first character itself
+    const auto name = skip_blank(i + 1);
+    if (name == _input.size()) {
+      i = name;
+      unexpected(name,
+                 state == LabelOpen ? TokenKind::Identifier
+                                    : TokenKind::RBracket,
+                 TokenKind::Eof);
+      return false;
+    }
+    const auto close = _input.find_first_of("]\n", name + 1);
+    if (close == std::string_view::npos) {
+      i = _input.size();
+      report(DiagnosticCode::UnexpectedEof, i, ']', 0);
+      return false;
+    }
+    i = close;
+    if (_input[close] == '\n') {
+      report(DiagnosticCode::ExpectedCharacter, close, ']', '\n');
+      return false;
+    }
+    ++i;
+    row_at = row(Body, Plain);
+    return true;
+  }
+
+public:
+  Validation(std::string_view input, std::size_t max_errors)
+      : _input(input), _max_errors(max_errors) {}
+
+  Diagnostics run() {
+    const auto *bytes = reinterpret_cast<const unsigned char *>(_input.data());
+    const auto size = _input.size();
+    std::size_t i = 0;
+    std::uint16_t row_at = row(HeadBpm, Plain);
+    while (true) {
+      // Everything but the odd label and "BPM" stays in this loop
+      auto pair_at = static_cast<std::uint16_t>(row_at * kColumns);
+      for (; i + 1 < size; i += 2) {
+        const auto next = kPairTable[pair_at + kClass[bytes[i]] * kColumns +
+                                     kClass[bytes[i + 1]]];
+        if (next >= kAction)
+          break;
+        pair_at = next;
+      }
+      row_at = static_cast<std::uint16_t>(pair_at / kColumns);
+      std::uint16_t next = 0;
+      for (const auto stop = std::min(i + 2, size); i < stop; ++i) {
+        next = kTable[row_at + kClass[bytes[i]]];
+        if (next >= kAction)
+          break;
+        row_at = next;
+      }
+      if (i < size && next < kAction)
+        continue;
+
+      const auto state = state_of(row_at);
+      if (i == size) {
+        if (state != Body && state != AfterDuration)
+          unexpected(size, expected_in(state), TokenKind::Eof);
+        break;
+      }
+
+      bool ok = false;
+      switch (next) {
+      case kBracket:
+        ok = bracket(i, row_at, state);
+        break;
+      case kEmptyChord:
+        report(DiagnosticCode::EmptyChord, _chord_start, 0, 0,
+               _chord_start + 1);
+        break;
+      case kBadByte:
+        ok = bad_byte(i, row_at, state);
+        break;
+      default:
+        ok = grammar_error(i, row_at, state);
+        break;
+      }
+      if (ok)
+        continue;
+
+      // Carry on from the next line, at the label if the BPM line was the
+      // trouble; the parser recovers differently, so what's found after the
+      // first error may not be what it finds
+      if (_diagnostics.count() >= _max_errors)
+        break;
+      i = _input.find('\n', i);
+      if (i == std::string_view::npos)
+        break;
+      row_at = row(in_header(state) ? LabelOpen : Body, Plain);
+    }
+    return std::move(_diagnostics);
+  }
+};
+
+} // namespace
+
+Diagnostics validate(std::string_view input, std::size_t max_errors) {
+  return Validation(input, max_errors).run();
+}
+
+} // namespace FileReading::Validator
@@ -0,0 +1,141 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "io/fd_writer.hpp"
+
+namespace Io {
+
+#if defined(__linux__)
+// Pipes default to 64KiB on Linux; ask for more so bigger renders need fewer
+// wake-ups of the reader. 1MiB is the default unprivileged ceiling.
+constexpr int kWantedPipeBytes = 1 << 20;
+
+std::size_t prepare_pipe(int fd) {
+  struct stat st {};
+  if (::fstat(fd, &st) != 0 || !S_ISFIFO(st.st_mode))
+    return 0;
+
+  ::fcntl(fd, F_SETPIPE_SZ, kWantedPipeBytes); // best effort
+  const int size = ::fcntl(fd, F_GETPIPE_SZ);
+  return size > 0 ? static_cast<std::size_t>(size) : 0;
+}
+#endif
+
+FdWriter::FdWriter(int fd, std::size_t block_bytes)
+    : _fd(fd), _block_bytes(block_bytes) {
+  // Whole pages only, so a spliced block never shares a page with the next
+  const auto page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+  _block_bytes = std::max(page, (_block_bytes + page - 1) / page * page);
+
+#if defined(__linux__)
+  _splice = prepare_pipe(fd) > 0;
+#endif
+  map_buffer();
+}
+
+FdWriter::~FdWriter() {
+  if (_buffer != nullptr)
+    ::munmap(_buffer, _block_bytes);
+}
+
+void FdWriter::map_buffer() {
+  // mmap'd rather than heap allocated, so unmapping spliced pages can't hand
+  // them back to malloc while the pipe still holds them
+  void *buf = ::mmap(nullptr, _block_bytes, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (buf == MAP_FAILED)
+    throw std::runtime_error("Failed to allocate output buffers");
+  _buffer = static_cast<std::uint8_t *>(buf);
+}
+
+std::span<std::uint8_t> FdWriter::acquire() { return {_buffer, _block_bytes}; }
+
+void FdWriter::commit(std::size_t bytes) {
+  bytes = std::min(bytes, _block_bytes);
+  if (_splice && splice_fully(_buffer, bytes)) {
+    // The pipe has its own references to these pages now, and whatever we
+    // wrote into them later would be what the reader gets
+    ::munmap(_buffer, _block_bytes);
+    _buffer = nullptr;
+    map_buffer();
+    return;
+  }
+  write_fully(_buffer, bytes);
+}
+
+void FdWriter::write(std::span<const std::uint8_t> data) {
+  write_fully(data.data(), data.size());
+}
+
+std::size_t FdWriter::block_bytes() const { return _block_bytes; }
+
+bool FdWriter::zero_copy() const { return _splice; }
+
+std::uint64_t FdWriter::bytes_written() const { return _written; }
+
+void FdWriter::wait_writable() {
+  pollfd pfd{.fd = _fd, .events = POLLOUT, .revents = 0};
+  while (::poll(&pfd, 1, -1) < 0 && errno == EINTR) {
+  }
+}
+
+void FdWriter::write_fully(const std::uint8_t *data, std::size_t n) {
+  while (n > 0) {
+    const auto w = ::write(_fd, data, n);
+    if (w < 0) {
+      if (errno == EINTR)
+        continue;
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        wait_writable();
+        continue;
+      }
+      throw std::runtime_error(std::string("write failed: ") +
+                               std::strerror(errno));
+    }
+    data += w;
+    n -= static_cast<std::size_t>(w);
+    _written += static_cast<std::uint64_t>(w);
+  }
+}
+
+bool FdWriter::splice_fully(const std::uint8_t *data, std::size_t n) {
+#if defined(__linux__)
+  while (n > 0) {
+    iovec iov{.iov_base = const_cast<std::uint8_t *>(data), .iov_len = n};
+    const auto w = ::vmsplice(_fd, &iov, 1, 0);
+    if (w < 0) {
+      if (errno == EINTR)
+        continue;
+      if (errno == EAGAIN) {
+        wait_writable();
+        continue;
+      }
+      if (errno == EPIPE)
+        throw std::runtime_error("write failed: reader closed the pipe");
+      // Not supported here after all, let write(2) take it from this point.
+      _splice = false;
+      write_fully(data, n);
+      return true;
+    }
+    data += w;
+    n -= static_cast<std::size_t>(w);
+    _written += static_cast<std::uint64_t>(w);
+  }
+  return true;
+#else
+  (void)data;
+  (void)n;
+  return false;
+#endif
+}
+
+} // namespace Io
@@ -0,0 +1,97 @@
+#include "io/file_watcher.hpp"
+
+#include <thread>
+
+#if defined(__linux__) && __has_include(<sys/inotify.h>)
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#define HAVE_INOTIFY 1
+#endif
+
+namespace Io {
+
+namespace {
+
+// How often the mtime gets looked at without inotify
+constexpr std::chrono::milliseconds kPollInterval{50};
+
+} // namespace
+
+FileWatcher::FileWatcher(std::filesystem::path path)
+    : _path(std::move(path)), _name(_path.filename().string()) {
+  std::error_code ec;
+  _mtime = std::filesystem::last_write_time(_path, ec);
+#if defined(HAVE_INOTIFY)
+  _fd = ::inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+  if (_fd < 0)
+    return;
+  const auto dir = _path.has_parent_path() ? _path.parent_path()
+                                           : std::filesystem::path(".");
+  if (::inotify_add_watch(_fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) <
+      0) {
+    ::close(_fd);
+    _fd = -1;
+  }
+#endif
+}
+
+FileWatcher::~FileWatcher() {
+#if defined(HAVE_INOTIFY)
+  if (_fd >= 0)
+    ::close(_fd);
+#endif
+}
+
+void FileWatcher::wait() {
+  wait_for_event(-1);
+  while (wait_for_event(static_cast<int>(kDebounce.count()))) {
+  }
+}
+
+/// True once the file is written or replaced, false if [timeout_ms] (-1 for
+/// no limit) passes first.
+bool FileWatcher::wait_for_event(int timeout_ms) {
+#if defined(HAVE_INOTIFY)
+  while (_fd >= 0) {
+    pollfd pfd{_fd, POLLIN, 0};
+    const int ready = ::poll(&pfd, 1, timeout_ms);
+    if (ready < 0 && errno == EINTR)
+      continue;
+    if (ready <= 0)
+      return false;
+
+    // Other files in the same directory wake us up too
+    bool ours = false;
+    alignas(inotify_event) char buf[4096];
+    ssize_t n;
+    while ((n = ::read(_fd, buf, sizeof(buf))) > 0) {
+      for (char *p = buf; p < buf + n;) {
+        const auto *event = reinterpret_cast<const inotify_event *>(p);
+        if (event->len > 0 && _name == event->name)
+          ours = true;
+        p += sizeof(inotify_event) + event->len;
+      }
+    }
+    if (ours)
+      return true;
+  }
+#endif
+
+  auto waited = std::chrono::milliseconds{0};
+  while (timeout_ms < 0 || waited.count() < timeout_ms) {
+    std::this_thread::sleep_for(kPollInterval);
+    waited += kPollInterval;
+    std::error_code ec;
+    const auto mtime = std::filesystem::last_write_time(_path, ec);
+    if (!ec && mtime != _mtime) {
+      _mtime = mtime;
+      return true;
+    }
+  }
+  return false;
+}
+
+} // namespace Io
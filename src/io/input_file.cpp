@@ -0,0 +1,108 @@
+#include "io/input_file.hpp"
+
+#include <cerrno>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if __has_include(<sys/mman.h>)
+#include <sys/mman.h>
+#define HAVE_MMAP 1
+#endif
+
+namespace Io {
+
+namespace {
+
+// Read size for inputs whose length isn't known up front
+constexpr std::size_t kReadChunk = 1 << 16;
+
+int open_input(const std::string &path) {
+  if (path == "-")
+    return STDIN_FILENO;
+  const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    throw std::runtime_error("Failed to open file: " + path);
+  return fd;
+}
+
+void close_input(int fd) {
+  if (fd != STDIN_FILENO)
+    ::close(fd);
+}
+
+/// Reads [fd] to the end into [out]; [hint] is the expected size, 0 if
+/// unknown. One spare byte lets the read that sees the end land without
+/// growing the buffer.
+void read_all(int fd, const std::string &path, std::size_t hint,
+              std::string &out) {
+  out.resize(hint > 0 ? hint + 1 : kReadChunk);
+  std::size_t size = 0;
+  for (;;) {
+    if (size == out.size())
+      out.resize(out.size() * 2);
+    const auto n = ::read(fd, out.data() + size, out.size() - size);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n < 0) {
+      close_input(fd);
+      throw std::runtime_error("Failed to read file: " + path);
+    }
+    if (n == 0)
+      break;
+    size += static_cast<std::size_t>(n);
+  }
+  out.resize(size);
+}
+
+} // namespace
+
+InputFile::InputFile(const std::string &path) {
+  const int fd = open_input(path);
+  struct stat st {};
+  const bool regular = ::fstat(fd, &st) == 0 && S_ISREG(st.st_mode);
+  const auto size = regular ? static_cast<std::size_t>(st.st_size) : 0;
+
+#if defined(HAVE_MMAP)
+  if (size > 0) {
+    void *map = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map != MAP_FAILED) {
+      ::madvise(map, size, MADV_SEQUENTIAL); // only a hint
+      _map = static_cast<const char *>(map);
+      _size = size;
+      close_input(fd);
+      return;
+    }
+  }
+#endif
+
+  read_all(fd, path, size, _buffer);
+  close_input(fd);
+}
+
+InputFile::~InputFile() {
+#if defined(HAVE_MMAP)
+  if (_map != nullptr)
+    ::munmap(const_cast<char *>(_map), _size);
+#endif
+}
+
+std::string_view InputFile::text() const {
+  return _map != nullptr ? std::string_view(_map, _size)
+                         : std::string_view(_buffer);
+}
+
+bool InputFile::mapped() const { return _map != nullptr; }
+
+std::string read_file(const std::string &path) {
+  const int fd = open_input(path);
+  struct stat st {};
+  const bool regular = ::fstat(fd, &st) == 0 && S_ISREG(st.st_mode);
+  std::string text;
+  read_all(fd, path, regular ? static_cast<std::size_t>(st.st_size) : 0, text);
+  close_input(fd);
+  return text;
+}
+
+} // namespace Io
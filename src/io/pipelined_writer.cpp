@@ -0,0 +1,210 @@
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+
+#include "io/pipelined_writer.hpp"
+#include "io/uring.hpp"
+
+namespace Io {
+
+PipelinedWriter::PipelinedWriter(int fd, std::size_t block_bytes,
+                                 Backend backend)
+    : _fd(fd), _block_bytes(std::max<std::size_t>(block_bytes, 1)) {
+  _pool.resize(kBuffers, std::vector<std::uint8_t>(_block_bytes));
+  for (std::uint32_t i = 0; i < kBuffers; ++i)
+    _free.push(i);
+
+  const auto pos = ::lseek(_fd, 0, SEEK_CUR);
+  _seekable = pos >= 0;
+  _offset = _seekable ? static_cast<std::uint64_t>(pos) : 0;
+  if (_seekable && backend == Backend::Auto)
+    _uring = Uring::create(kBuffers);
+
+  _io = std::thread([this] { io_loop(); });
+}
+
+PipelinedWriter::~PipelinedWriter() {
+  try {
+    finish();
+  } catch (...) {
+    // Destructors can't report anything; callers wanting errors use finish().
+  }
+}
+
+std::span<std::uint8_t> PipelinedWriter::acquire() {
+  if (_current == kEnd) {
+    rethrow_if_failed();
+    _current = _free.wait_pop();
+  }
+  return _pool[_current];
+}
+
+void PipelinedWriter::commit(std::size_t bytes) {
+  if (_current == kEnd)
+    acquire();
+  const auto n = static_cast<std::uint32_t>(std::min(bytes, _block_bytes));
+  _full.wait_push(Block{.index = _current, .bytes = n});
+  _current = kEnd;
+}
+
+void PipelinedWriter::write(std::span<const std::uint8_t> data) {
+  while (!data.empty()) {
+    auto buf = acquire();
+    const auto n = std::min(buf.size(), data.size());
+    std::copy_n(data.begin(), n, buf.begin());
+    commit(n);
+    data = data.subspan(n);
+  }
+}
+
+void PipelinedWriter::finish() {
+  if (_finished)
+    return;
+  _finished = true;
+
+  // Hand back an acquired but uncommitted buffer so the pool stays whole.
+  if (_current != kEnd) {
+    _full.wait_push(Block{.index = _current, .bytes = 0});
+    _current = kEnd;
+  }
+  _full.wait_push(Block{});
+  _io.join();
+  rethrow_if_failed();
+}
+
+bool PipelinedWriter::uses_io_uring() const { return _uring != nullptr; }
+
+std::uint64_t PipelinedWriter::bytes_written() const { return _written; }
+
+void PipelinedWriter::rethrow_if_failed() {
+  if (_failed.load(std::memory_order_acquire))
+    std::rethrow_exception(_error);
+}
+
+void PipelinedWriter::io_loop() {
+  std::vector<Block> batch;
+  batch.reserve(kBuffers);
+  bool done = false;
+  while (!done) {
+    // Block for one buffer, then take whatever else is already waiting so it
+    // can all be submitted together.
+    batch.clear();
+    Block block = _full.wait_pop();
+    while (true) {
+      if (block.index == kEnd) {
+        done = true;
+        break;
+      }
+      batch.push_back(block);
+      if (!_full.pop(block))
+        break;
+    }
+
+    if (!_failed.load(std::memory_order_relaxed)) {
+      try {
+        write_batch(batch);
+      } catch (...) {
+        // Keep cycling buffers so the producer never deadlocks; it picks
+        // the error up on its next acquire or in finish().
+        _error = std::current_exception();
+        _failed.store(true, std::memory_order_release);
+      }
+    }
+
+    for (const auto &b : batch)
+      _free.wait_push(b.index);
+  }
+}
+
+void PipelinedWriter::write_batch(const std::vector<Block> &batch) {
+  if (_uring) {
+    submit_batch(batch);
+    return;
+  }
+
+  for (const auto &b : batch) {
+    write_at(_pool[b.index].data(), b.bytes, _offset);
+    _offset += b.bytes;
+  }
+}
+
+void PipelinedWriter::submit_batch(const std::vector<Block> &batch) {
+  std::array<std::uint64_t, kBuffers> offsets{};
+  std::array<std::uint32_t, kBuffers> sizes{};
+  std::vector<std::uint32_t> retry; // blocks the ring didn't write for us
+
+  std::uint64_t offset = _offset;
+  unsigned int queued = 0;
+  for (const auto &b : batch) {
+    offsets[b.index] = offset;
+    sizes[b.index] = b.bytes;
+    offset += b.bytes;
+    if (b.bytes == 0)
+      continue;
+    if (_uring->queue_write(_fd, _pool[b.index].data(), b.bytes,
+                            offsets[b.index], b.index))
+      ++queued;
+    else
+      write_at(_pool[b.index].data(), b.bytes, offsets[b.index]);
+  }
+
+  // Every submitted write has to complete before its buffer can go back to
+  // the producer, so drain them all before reporting any failure.
+  int error = 0;
+  for (unsigned int done = 0; done < queued;) {
+    _uring->submit_and_wait(1);
+    std::uint64_t index = 0;
+    std::int32_t res = 0;
+    while (_uring->next_completion(index, res)) {
+      ++done;
+      if (res == -EINVAL || res == -EOPNOTSUPP) {
+        retry.push_back(static_cast<std::uint32_t>(index)); // no WRITE op
+      } else if (res < 0) {
+        error = -res;
+      } else {
+        const auto n = static_cast<std::uint32_t>(res);
+        _written += n;
+        if (n < sizes[index])
+          write_at(_pool[index].data() + n, sizes[index] - n,
+                   offsets[index] + n);
+      }
+    }
+  }
+  if (error != 0)
+    throw std::runtime_error(std::string("write failed: ") +
+                             std::strerror(error));
+
+  if (!retry.empty()) {
+    // Kernel predates IORING_OP_WRITE; stick to pwrite from now on.
+    _uring.reset();
+    for (auto index : retry)
+      write_at(_pool[index].data(), sizes[index], offsets[index]);
+  }
+
+  _offset = offset;
+}
+
+void PipelinedWriter::write_at(const std::uint8_t *data, std::size_t n,
+                               std::uint64_t offset) {
+  while (n > 0) {
+    const auto w = _seekable
+                       ? ::pwrite(_fd, data, n, static_cast<off_t>(offset))
+                       : ::write(_fd, data, n);
+    if (w < 0) {
+      if (errno == EINTR)
+        continue;
+      throw std::runtime_error(std::string("write failed: ") +
+                               std::strerror(errno));
+    }
+    data += w;
+    n -= static_cast<std::size_t>(w);
+    offset += static_cast<std::uint64_t>(w);
+    _written += static_cast<std::uint64_t>(w);
+  }
+}
+
+} // namespace Io
@@ -0,0 +1,188 @@
+#include "io/uring.hpp"
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <linux/io_uring.h>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define HAVE_IO_URING 1
+#endif
+
+namespace Io {
+
+#if defined(HAVE_IO_URING)
+
+namespace {
+
+// Ring indices are shared with the kernel; the atomic builtins give them the
+// acquire/release ordering the io_uring ABI asks for.
+unsigned int load_acquire(const unsigned int *p) {
+  return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+void store_release(unsigned int *p, unsigned int v) {
+  __atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+
+} // namespace
+
+struct Uring::Rings {
+  int fd = -1;
+  void *sq_ptr = MAP_FAILED;
+  std::size_t sq_len = 0;
+  void *cq_ptr = MAP_FAILED;
+  std::size_t cq_len = 0;
+  io_uring_sqe *sqes = static_cast<io_uring_sqe *>(MAP_FAILED);
+  std::size_t sqes_len = 0;
+
+  unsigned int entries = 0;
+  unsigned int *sq_head = nullptr;
+  unsigned int *sq_tail = nullptr;
+  unsigned int *sq_mask = nullptr;
+  unsigned int *sq_array = nullptr;
+  unsigned int *cq_head = nullptr;
+  unsigned int *cq_tail = nullptr;
+  unsigned int *cq_mask = nullptr;
+  io_uring_cqe *cqes = nullptr;
+
+  ~Rings() {
+    if (sqes != MAP_FAILED)
+      ::munmap(sqes, sqes_len);
+    if (cq_ptr != MAP_FAILED && cq_ptr != sq_ptr)
+      ::munmap(cq_ptr, cq_len);
+    if (sq_ptr != MAP_FAILED)
+      ::munmap(sq_ptr, sq_len);
+    if (fd >= 0)
+      ::close(fd);
+  }
+};
+
+Uring::Uring(std::unique_ptr<Rings> rings) : _rings(std::move(rings)) {}
+
+Uring::~Uring() = default;
+
+std::unique_ptr<Uring> Uring::create(unsigned int entries) {
+  auto r = std::make_unique<Rings>();
+  io_uring_params params{};
+  r->fd = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+  if (r->fd < 0)
+    return nullptr;
+
+  r->entries = params.sq_entries;
+  r->sq_len = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+  r->cq_len = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  const bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+  if (single_mmap)
+    r->sq_len = r->cq_len = std::max(r->sq_len, r->cq_len);
+
+  r->sq_ptr = ::mmap(nullptr, r->sq_len, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_SQ_RING);
+  if (r->sq_ptr == MAP_FAILED)
+    return nullptr;
+  r->cq_ptr = single_mmap ? r->sq_ptr
+                          : ::mmap(nullptr, r->cq_len, PROT_READ | PROT_WRITE,
+                                   MAP_SHARED | MAP_POPULATE, r->fd,
+                                   IORING_OFF_CQ_RING);
+  if (r->cq_ptr == MAP_FAILED)
+    return nullptr;
+  r->sqes_len = params.sq_entries * sizeof(io_uring_sqe);
+  r->sqes = static_cast<io_uring_sqe *>(
+      ::mmap(nullptr, r->sqes_len, PROT_READ | PROT_WRITE,
+             MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_SQES));
+  if (r->sqes == MAP_FAILED)
+    return nullptr;
+
+  auto *sq = static_cast<char *>(r->sq_ptr);
+  r->sq_head = reinterpret_cast<unsigned int *>(sq + params.sq_off.head);
+  r->sq_tail = reinterpret_cast<unsigned int *>(sq + params.sq_off.tail);
+  r->sq_mask = reinterpret_cast<unsigned int *>(sq + params.sq_off.ring_mask);
+  r->sq_array = reinterpret_cast<unsigned int *>(sq + params.sq_off.array);
+  auto *cq = static_cast<char *>(r->cq_ptr);
+  r->cq_head = reinterpret_cast<unsigned int *>(cq + params.cq_off.head);
+  r->cq_tail = reinterpret_cast<unsigned int *>(cq + params.cq_off.tail);
+  r->cq_mask = reinterpret_cast<unsigned int *>(cq + params.cq_off.ring_mask);
+  r->cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+
+  return std::unique_ptr<Uring>(new Uring(std::move(r)));
+}
+
+unsigned int Uring::capacity() const { return _rings->entries; }
+
+bool Uring::queue_write(int fd, const void *buf, std::uint32_t len,
+                        std::uint64_t offset, std::uint64_t user_data) {
+  auto &r = *_rings;
+  const unsigned int tail = *r.sq_tail; // we're the only producer
+  if (tail - load_acquire(r.sq_head) >= r.entries)
+    return false;
+
+  const unsigned int idx = tail & *r.sq_mask;
+  io_uring_sqe *sqe = &r.sqes[idx];
+  std::memset(sqe, 0, sizeof(*sqe));
+  sqe->opcode = IORING_OP_WRITE;
+  sqe->fd = fd;
+  sqe->addr = reinterpret_cast<std::uint64_t>(buf);
+  sqe->len = len;
+  sqe->off = offset;
+  sqe->user_data = user_data;
+  r.sq_array[idx] = idx;
+  store_release(r.sq_tail, tail + 1);
+  ++_to_submit;
+  return true;
+}
+
+void Uring::submit_and_wait(unsigned int wait_nr) {
+  while (true) {
+    const auto ret = ::syscall(__NR_io_uring_enter, _rings->fd, _to_submit,
+                               wait_nr, IORING_ENTER_GETEVENTS, nullptr, 0);
+    if (ret >= 0) {
+      _to_submit -= static_cast<unsigned int>(ret);
+      return;
+    }
+    if (errno != EINTR)
+      throw std::runtime_error(std::string("io_uring_enter failed: ") +
+                               std::strerror(errno));
+  }
+}
+
+bool Uring::next_completion(std::uint64_t &user_data, std::int32_t &result) {
+  auto &r = *_rings;
+  const unsigned int head = *r.cq_head; // we're the only consumer
+  if (head == load_acquire(r.cq_tail))
+    return false;
+
+  const auto &cqe = r.cqes[head & *r.cq_mask];
+  user_data = cqe.user_data;
+  result = cqe.res;
+  store_release(r.cq_head, head + 1);
+  return true;
+}
+
+#else
+
+struct Uring::Rings {};
+
+Uring::Uring(std::unique_ptr<Rings> rings) : _rings(std::move(rings)) {}
+
+Uring::~Uring() = default;
+
+std::unique_ptr<Uring> Uring::create(unsigned int) { return nullptr; }
+
+unsigned int Uring::capacity() const { return 0; }
+
+bool Uring::queue_write(int, const void *, std::uint32_t, std::uint64_t,
+                        std::uint64_t) {
+  return false;
+}
+
+void Uring::submit_and_wait(unsigned int) {}
+
+bool Uring::next_completion(std::uint64_t &, std::int32_t &) { return false; }
+
+#endif
+
+} // namespace Io
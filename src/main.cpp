@@ -1,18 +1,71 @@
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <fcntl.h>
+#include <filesystem>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <memory>
+#include <optional>
+#include <sstream>
 #include <string>
+#include <type_traits>
+#include <unistd.h>
 #include <vector>
 
 #include "adapter/note_info_adapter.hpp"
 #include "arg_parser.hpp"
+#include "audio/flac_writer.hpp"
+#include "audio/mix_renderer.hpp"
+#include "audio/note_info.hpp"
+#include "audio/pcm_format.hpp"
+#include "audio/reverb.hpp"
+#include "audio/segment_renderer.hpp"
+#include "audio/wav_reader.hpp"
 #include "audio/wav_writer.hpp"
+#include "audio/wavetable.hpp"
+#include "cache/render_cache.hpp"
+#include "cache/render_index.hpp"
+#include "cache/xxhash.hpp"
 #include "file_reading/lexer/lexer.hpp"
+#include "file_reading/logging/diagnostic_printer.hpp"
 #include "file_reading/logging/node_printer.hpp"
 #include "file_reading/logging/token_printer.hpp"
 #include "file_reading/parser/parser.hpp"
+#include "file_reading/validator/validator.hpp"
+#include "io/fd_writer.hpp"
+#include "io/file_watcher.hpp"
+#include "io/input_file.hpp"
+#include "io/pipelined_writer.hpp"
+#include "musicgen/musicgen.hpp"
+#include "server/render_client.hpp"
+#include "server/render_server.hpp"
 
-std::string read_file_to_string(const std::string &path);
-void log_diagnostics(std::vector<std::string> diagnostics);
+void log_diagnostics(const Args &args,
+                     const FileReading::Diagnostics &diagnostics);
+int render_remote(const Args &args, std::string_view text);
+MusicGen::RenderOptions render_options(const Args &args);
+void load_wavetables(const Args &args);
+bool flac_output(const Args &args);
+bool incremental_supported(const MusicGen::RenderOptions &options, bool flac);
+int watch(const Args &args);
+std::uint64_t render_cache_key(const Args &args, std::string_view score);
+int render_stream(const Args &args, const MusicGen::RenderOptions &options,
+                  const std::vector<Audio::Voice> &voices, bool to_stdout);
+int render_flac(const Args &args, const MusicGen::RenderOptions &options,
+                const std::vector<Audio::Voice> &voices, bool to_stdout);
+int render_incremental(const Args &args,
+                       const MusicGen::RenderOptions &options,
+                       const std::vector<Audio::Voice> &voices, bool flac);
+void stop_serving(int signal);
+
+/// The daemon SIGINT and SIGTERM stop, while one is running.
+std::atomic<Server::RenderServer *> serving{nullptr};
 
 int main(int argc, char *argv[]) {
   auto args = parse_args(argc, argv);
@@ -20,67 +73,659 @@ int main(int argc, char *argv[]) {
     std::cout << get_help() << std::endl;
     return 0;
   }
+  if (args.serve) {
+    load_wavetables(args);
+    Server::ServerOptions options{.socket_path = std::string{args.serve_socket},
+                                  .threads = args.threads,
+                                  .render = render_options(args)};
+    // The daemon's parallelism is across requests
+    options.render.threads = 1;
+    Server::RenderServer server(options);
+    serving = &server;
+    std::signal(SIGINT, stop_serving);
+    std::signal(SIGTERM, stop_serving);
+    std::cout << "Serving on " << args.serve_socket << std::endl;
+    server.run();
+    serving = nullptr;
+    return 0;
+  }
   if (!args.input_file_provided) {
     std::cerr << "Error: need input file" << std::endl;
     std::cerr << get_help() << std::endl;
     return 1;
   }
 
-  auto text = read_file_to_string(std::string(args.input_file));
+  if (args.watch) {
+    return watch(args);
+  }
+
+  // Tokens point into [text], so the file stays mapped until we're done
+  const Io::InputFile input{std::string(args.input_file)};
+  const auto text = input.text();
+  if (args.connect) {
+    return render_remote(args, text);
+  }
+  if (args.check) {
+    const auto diagnostics =
+        FileReading::Validator::validate(text, args.max_errors);
+    if (!diagnostics.empty()) {
+      log_diagnostics(args, diagnostics);
+      return 1;
+    }
+    std::cout << "OK" << std::endl;
+    return 0;
+  }
   if (args.lex_only) {
-    auto lexer = new FileReading::Lexer::Lexer(text);
-    auto contents = lexer->lex();
-    if (lexer->error()) {
-      log_diagnostics(lexer->diagnostics());
+    FileReading::Lexer::Lexer lexer(text);
+    auto contents = lexer.lex();
+    if (lexer.error()) {
+      log_diagnostics(args, lexer.diagnostics());
       return 1;
     }
-    FileReading::Logging::log_tokens(contents);
+    FileReading::Logging::DumpWriter out(STDOUT_FILENO);
+    FileReading::Logging::dump_tokens(contents, text, args.dump_format, out);
     return 0;
   }
-  auto parser = new FileReading::Parser::Parser(text);
-  auto result = parser->parse();
-  if (result->error()) {
-    log_diagnostics(result->diagnostics());
+
+  if (!args.parse_only) {
+    const bool limited = args.limit || args.normalize;
+    if (args.amplitude < 0.0 || (args.amplitude > 1.0 && !limited)) {
+      std::cerr << "Amplitude must be in [0,1] range." << std::endl;
+    }
+  }
+
+  // A hit skips lexing, parsing and rendering altogether, and prints the
+  // warnings the render that stored it printed
+  const std::filesystem::path output{args.output_file};
+  const bool to_file = args.output_file_provided && args.output_file != "-";
+  std::optional<Cache::RenderCache> cache;
+  std::uint64_t cache_key = 0;
+  // An incremental render's index does the caching for its output
+  if (to_file && !args.no_cache && !args.incremental && !args.parse_only) {
+    cache.emplace(args.cache_dir.empty()
+                      ? Cache::RenderCache::default_dir()
+                      : std::filesystem::path{args.cache_dir});
+    cache_key = render_cache_key(args, text);
+    if (const auto warnings = cache->fetch(cache_key, output)) {
+      for (const auto &warning : *warnings) {
+        std::cerr << warning << std::endl;
+      }
+      std::cout << "Wrote " << args.output_file << " (cached)" << std::endl;
+      return 0;
+    }
+  }
+
+  load_wavetables(args);
+  FileReading::Parser::Parser parser(text);
+  auto result = parser.parse();
+  if (result.error()) {
+    log_diagnostics(args, result.diagnostics());
     return 1;
   }
 
   if (args.parse_only) {
-    FileReading::Logging::log_nodes(result->nodes());
+    FileReading::Logging::DumpWriter out(STDOUT_FILENO);
+    FileReading::Logging::dump_nodes(result.nodes(), args.dump_format, out);
     return 0;
   }
 
+  const bool to_stdout = args.output_file_provided
+                             ? args.output_file == "-"
+                             : args.raw;
+  if (!args.output_file_provided && !to_stdout) {
+    std::cerr << "Error: need output file" << std::endl;
+    std::cerr << get_help() << std::endl;
+    return 1;
+  }
+
+  Adapter::NoteInfoAdapter adapter(result.song());
+  auto voices = adapter.convert();
+  for (const auto &warning : adapter.warnings()) {
+    std::cerr << warning << std::endl;
+  }
+  const auto options = render_options(args);
+  const bool flac = flac_output(args);
+  if (args.incremental) {
+    if (!to_file) {
+      std::cerr << "Error: --incremental needs an output file" << std::endl;
+      return 1;
+    }
+    return render_incremental(args, options, voices, flac);
+  }
+  // The output may be a cache entry's other name, don't write through it
+  if (to_file)
+    Cache::RenderCache::detach(output);
+  const int status = flac ? render_flac(args, options, voices, to_stdout)
+                          : render_stream(args, options, voices, to_stdout);
+  if (status == 0 && cache)
+    cache->store(cache_key, output, adapter.warnings());
+  return status;
+}
+
+void load_wavetables(const Args &args) {
+  // Must come before anything renders, the first caller decides where the
+  // shared bank comes from
+  if (!args.wavetable_cache.empty() && Audio::timbre_waveform(args.timbre))
+    Audio::WavetableBank::shared(std::filesystem::path{args.wavetable_cache});
+}
+
+bool flac_output(const Args &args) {
+  return args.format == "flac" ||
+         (args.format.empty() && args.output_file.ends_with(".flac"));
+}
+
+/// Hash of everything that decides the bytes of the output file. Thread counts
+/// and the wavetable cache don't change them, so they're left out.
+std::uint64_t render_cache_key(const Args &args, std::string_view score) {
+  std::string key = Cache::normalize_score(score);
+  auto field = [&key](std::string_view name, auto value) {
+    key += '\0';
+    key += name;
+    key += '=';
+    if constexpr (std::is_convertible_v<decltype(value), std::string_view>) {
+      key += value;
+    } else {
+      // Shortest form that reads back to the same value
+      char buf[32];
+      const auto end = std::to_chars(buf, buf + sizeof(buf), value).ptr;
+      key.append(buf, end);
+    }
+  };
+
+  const bool flac = flac_output(args);
+  field("format", flac ? "flac" : args.raw ? "raw" : "wav");
+  field("bits", args.bits);
+  field("amplitude", args.amplitude);
+  field("attack", args.envelope.attack_s);
+  field("decay", args.envelope.decay_s);
+  field("sustain", args.envelope.sustain);
+  field("release", args.envelope.release_s);
+  field("curve", static_cast<unsigned int>(args.envelope.curve));
+  field("timbre", Audio::timbre_name(args.timbre));
+  for (const auto &eq : args.eq) {
+    field("eq", static_cast<unsigned int>(eq.kind));
+    field("freq", eq.freq_hz);
+    field("gain", eq.gain_db);
+    field("q", eq.q);
+  }
+  field("reverb", args.reverb);
+  field("reverb_mix", args.reverb_mix);
+  if (args.reverb.ends_with(".wav")) {
+    // An impulse response is part of the sound, whatever its file is called
+    field("ir", Cache::xxh64(Io::InputFile{std::string{args.reverb}}.text()));
+  }
+  field("rate", args.sample_rate);
+  field("resample", static_cast<unsigned int>(args.resample_quality));
+  field("limit", static_cast<unsigned int>(args.limit));
+  field("loudness", args.normalize ? args.loudness_db : 0.0);
+  field("normalize", static_cast<unsigned int>(args.normalize));
+  field("dither", static_cast<unsigned int>(args.dither));
+  return Cache::xxh64(key, Cache::binary_fingerprint());
+}
+
+MusicGen::RenderOptions render_options(const Args &args) {
+  MusicGen::RenderOptions options{};
+  options.amplitude = args.amplitude;
+  options.envelope = args.envelope;
+  options.timbre = args.timbre;
+  options.threads = args.threads;
+  options.eq = args.eq;
+  options.sample_rate = args.sample_rate;
+  options.resample_quality = args.resample_quality;
+  options.dither = args.dither;
+  if (args.limit)
+    options.limiter = Audio::LimiterSettings{};
+  if (args.normalize)
+    options.loudness_db = args.loudness_db;
+  if (args.reverb.empty())
+    return options;
+
+  // A preset, a reverb time in seconds or an impulse response file
+  Audio::ReverbSettings reverb{};
+  reverb.wet = static_cast<float>(args.reverb_mix);
+  if (args.reverb == "room") {
+    reverb.impulse_response = Audio::synthetic_impulse_response(0.6);
+  } else if (args.reverb == "hall") {
+    reverb.impulse_response = Audio::synthetic_impulse_response(2.5);
+  } else if (const auto rt60 = std::atof(std::string{args.reverb}.c_str());
+             rt60 > 0.0 && !args.reverb.ends_with(".wav")) {
+    reverb.impulse_response = Audio::synthetic_impulse_response(rt60);
+  } else {
+    auto wav = Audio::read_wav_mono(std::filesystem::path{args.reverb});
+    if (wav.sample_rate != Audio::kSampleRate) {
+      throw std::runtime_error("Impulse response must be sampled at " +
+                               std::to_string(Audio::kSampleRate) + "Hz");
+    }
+    reverb.impulse_response = std::move(wav.samples);
+  }
+  options.reverb = std::move(reverb);
+  return options;
+}
+
+void log_diagnostics(const Args &args,
+                     const FileReading::Diagnostics &diagnostics) {
+  FileReading::Logging::log_diagnostics(diagnostics, args.json_diagnostics,
+                                        std::cerr);
+}
+
+int render_remote(const Args &args, std::string_view text) {
   if (!args.output_file_provided) {
     std::cerr << "Error: need output file" << std::endl;
     std::cerr << get_help() << std::endl;
     return 1;
   }
 
-  auto adapter = new Adapter::NoteInfoAdapter(result->song());
-  auto samples = Audio::encode_melody(adapter->convert(), args.amplitude);
-  Audio::write_pcm16_mono_wav(std::string{args.output_file}, samples);
+  std::ofstream out(std::string{args.output_file}, std::ios::binary);
+  if (!out)
+    throw std::runtime_error("Failed to open output file: " +
+                             std::string{args.output_file});
+
+  auto result = Server::request_render(std::string{args.connect_socket},
+                                       Server::OutputFormat::Wav, text, out);
+  if (result.status != Server::ResponseStatus::Ok) {
+    std::cerr << result.diagnostics;
+    return 1;
+  }
 
-  std::cout << "Wrote " << args.output_file << " (" << samples.size()
+  std::cout << "Wrote " << args.output_file << " ("
+            << Audio::wav_samples_in_file(result.bytes)
             << " samples)" << std::endl;
   return 0;
 }
 
-std::string read_file_to_string(const std::string &path) {
-  std::ifstream file(path, std::ios::binary | std::ios::ate);
-  if (!file) {
-    throw std::runtime_error("Failed to open file: " + path);
+/// Renders straight into the writer's buffers: [Writer] is either
+/// Io::FdWriter or Io::PipelinedWriter, which share acquire/commit/write.
+template <typename Writer>
+void stream_pcm(Writer &writer, Audio::MixRenderer &renderer, bool header,
+                unsigned int bits) {
+  if (header) {
+    std::ostringstream wav_header;
+    Audio::write_pcm_mono_header(wav_header, renderer.total_samples(),
+                                 renderer.output_rate(),
+                                 static_cast<std::uint16_t>(bits));
+    const auto bytes = wav_header.str();
+    writer.write(std::span(reinterpret_cast<const std::uint8_t *>(bytes.data()),
+                           bytes.size()));
   }
 
-  std::size_t size = file.tellg();
-  file.seekg(0);
+  while (!renderer.done()) {
+    auto buf = writer.acquire();
+    if (bits == 24) {
+      const auto n = renderer.render_pcm24(buf);
+      writer.commit(n * Audio::kPcm24Bytes);
+      continue;
+    }
+    std::span<std::int16_t> block(reinterpret_cast<std::int16_t *>(buf.data()),
+                                  buf.size() / sizeof(std::int16_t));
+    const auto n = renderer.render(block);
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+    for (std::size_t i = 0; i < n; ++i) {
+      const auto v = static_cast<std::uint16_t>(block[i]);
+      block[i] = static_cast<std::int16_t>((v >> 8) | (v << 8));
+    }
+#endif
+    writer.commit(n * sizeof(std::int16_t));
+  }
+}
 
-  std::string buffer(size, '\0');
-  file.read(buffer.data(), size);
+int render_stream(const Args &args, const MusicGen::RenderOptions &options,
+                  const std::vector<Audio::Voice> &voices, bool to_stdout) {
+  auto renderer_ptr = MusicGen::make_renderer(voices, options);
+  auto &renderer = *renderer_ptr;
 
-  return buffer;
+  if (to_stdout) {
+    Io::FdWriter writer(STDOUT_FILENO);
+    stream_pcm(writer, renderer, !args.raw, args.bits);
+    return 0;
+  }
+
+  const std::string path{args.output_file};
+  const int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0)
+    throw std::runtime_error("Failed to open output file: " + path);
+
+  try {
+    if (args.no_pipeline) {
+      Io::FdWriter writer(fd);
+      stream_pcm(writer, renderer, !args.raw, args.bits);
+    } else {
+      Io::PipelinedWriter writer(fd);
+      stream_pcm(writer, renderer, !args.raw, args.bits);
+      writer.finish();
+    }
+  } catch (...) {
+    ::close(fd);
+    throw;
+  }
+  ::close(fd);
+
+  std::cout << "Wrote " << args.output_file << " ("
+            << renderer.total_samples() << " samples)" << std::endl;
+  return 0;
 }
 
-void log_diagnostics(std::vector<std::string> diagnostics) {
-  for (auto diag : diagnostics) {
-    std::cerr << diag << std::endl;
+int render_flac(const Args &args, const MusicGen::RenderOptions &options,
+                const std::vector<Audio::Voice> &voices, bool to_stdout) {
+  if (args.raw) {
+    std::cerr << "Error: --raw can't be combined with FLAC output" << std::endl;
+    return 1;
+  }
+  if (args.bits != 16) {
+    std::cerr << "Error: FLAC output is 16 bit only" << std::endl;
+    return 1;
+  }
+
+  std::ofstream file;
+  if (!to_stdout) {
+    file.open(std::string{args.output_file}, std::ios::binary);
+    if (!file)
+      throw std::runtime_error("Failed to open output file: " +
+                               std::string{args.output_file});
+  }
+  std::ostream &out = to_stdout ? std::cout : file;
+
+  auto renderer_ptr = MusicGen::make_renderer(voices, options);
+  auto &renderer = *renderer_ptr;
+  Audio::FlacWriter writer(out, renderer.total_samples(), args.threads,
+                           renderer.output_rate());
+  std::vector<std::int16_t> block(1 << 16);
+  while (!renderer.done()) {
+    const auto n = renderer.render(block);
+    writer.write(std::span<const std::int16_t>(block.data(), n));
+  }
+  writer.finish();
+  out.flush();
+
+  if (!to_stdout) {
+    std::cout << "Wrote " << args.output_file << " ("
+              << renderer.total_samples() << " samples)" << std::endl;
+  }
+  return 0;
+}
+
+namespace {
+
+void read_at(int fd, std::uint8_t *data, std::size_t n, std::uint64_t offset) {
+  while (n > 0) {
+    const auto r = ::pread(fd, data, n, static_cast<off_t>(offset));
+    if (r < 0 && errno == EINTR)
+      continue;
+    if (r <= 0)
+      throw std::runtime_error("Failed to read back the output file");
+    data += r;
+    n -= static_cast<std::size_t>(r);
+    offset += static_cast<std::uint64_t>(r);
+  }
+}
+
+void write_at(int fd, const std::uint8_t *data, std::size_t n,
+              std::uint64_t offset) {
+  while (n > 0) {
+    const auto w = ::pwrite(fd, data, n, static_cast<off_t>(offset));
+    if (w < 0 && errno == EINTR)
+      continue;
+    if (w < 0)
+      throw std::runtime_error("Failed to patch the output file");
+    data += w;
+    n -= static_cast<std::size_t>(w);
+    offset += static_cast<std::uint64_t>(w);
+  }
+}
+
+/// memmove within a file: back to front when moving towards the end, so no
+/// chunk gets overwritten before it's been read.
+void move_bytes(int fd, std::uint64_t from, std::uint64_t to,
+                std::uint64_t bytes) {
+  if (from == to)
+    return;
+  std::vector<std::uint8_t> buf(1 << 20);
+  for (std::uint64_t done = 0; done < bytes;) {
+    const auto n =
+        static_cast<std::size_t>(std::min<std::uint64_t>(buf.size(),
+                                                         bytes - done));
+    const auto offset = to > from ? bytes - done - n : done;
+    read_at(fd, buf.data(), n, from + offset);
+    write_at(fd, buf.data(), n, to + offset);
+    done += n;
+  }
+}
+
+/// Renders samples [begin, end) of the song into the file at [data_offset].
+void patch_range(int fd, Audio::SegmentRenderer &renderer,
+                 std::uint64_t data_offset, std::uint64_t begin,
+                 std::uint64_t end, unsigned int bits) {
+  const std::size_t bytes_per_sample = bits / 8;
+  std::vector<std::uint8_t> buf(1 << 16);
+  const std::size_t block = buf.size() / bytes_per_sample;
+  for (auto at = begin; at < end;) {
+    const auto n = static_cast<std::size_t>(
+        std::min<std::uint64_t>(block, end - at));
+    if (bits == 24) {
+      renderer.render_pcm24(at, std::span(buf.data(), n * bytes_per_sample));
+    } else {
+      std::span<std::int16_t> samples(
+          reinterpret_cast<std::int16_t *>(buf.data()), n);
+      renderer.render(at, samples);
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+      for (auto &sample : samples) {
+        const auto v = static_cast<std::uint16_t>(sample);
+        sample = static_cast<std::int16_t>((v >> 8) | (v << 8));
+      }
+#endif
+    }
+    write_at(fd, buf.data(), n * bytes_per_sample,
+             data_offset + at * bytes_per_sample);
+    at += n;
+  }
+}
+
+} // namespace
+
+/// Each sample has to depend on nothing but the notes sounding at it.
+bool incremental_supported(const MusicGen::RenderOptions &options, bool flac) {
+  return !flac && options.eq.empty() && !options.reverb && !options.limiter &&
+         !options.loudness_db && options.sample_rate == Audio::kSampleRate &&
+         options.dither == Audio::Dither::None;
+}
+
+/// Brings the output up to date with [voices] using the index the last
+/// incremental render left next to it: the unchanged end of the song is
+/// moved to where it now starts, and only the samples under changed notes
+/// are rendered again (see Cache::plan_patch). Without a usable index the
+/// song is rendered in full and indexed for next time.
+int render_incremental(const Args &args,
+                       const MusicGen::RenderOptions &options,
+                       const std::vector<Audio::Voice> &voices, bool flac) {
+  if (!incremental_supported(options, flac)) {
+    std::cerr << "Error: --incremental only works for WAV or raw output "
+                 "without effects, loudness, resampling or dither"
+              << std::endl;
+    return 1;
+  }
+
+  const std::filesystem::path output{args.output_file};
+  const auto index_file = Cache::index_path(output);
+  auto index = Cache::RenderIndex::of(voices, render_cache_key(args, ""));
+  const auto old_index = Cache::RenderIndex::load(index_file);
+
+  const auto header_bytes = [&](std::uint64_t samples) -> std::uint64_t {
+    return args.raw ? 0
+                    : Audio::wav_header_bytes(
+                          samples, static_cast<std::uint16_t>(args.bits));
+  };
+  const std::uint64_t bytes_per_sample = args.bits / 8;
+  const auto samples = index.song_samples();
+
+  std::optional<Cache::RenderPatch> patch;
+  if (old_index && old_index->options == index.options &&
+      old_index->describes(output) &&
+      header_bytes(old_index->song_samples()) == header_bytes(samples) &&
+      Cache::RenderCache::unshare(output)) {
+    patch = Cache::plan_patch(*old_index, index);
+  }
+  // Whatever happens next, the old index no longer describes the file
+  std::error_code ec;
+  std::filesystem::remove(index_file, ec);
+
+  if (!patch) {
+    Cache::RenderCache::detach(output);
+    const int status = render_stream(args, options, voices, false);
+    if (status == 0) {
+      index.pin(output);
+      index.save(index_file);
+    }
+    return status;
+  }
+
+  const std::string path{args.output_file};
+  const int fd = ::open(path.c_str(), O_RDWR);
+  if (fd < 0)
+    throw std::runtime_error("Failed to open output file: " + path);
+
+  try {
+    const auto data = header_bytes(samples);
+    move_bytes(fd, data + patch->tail_from * bytes_per_sample,
+               data + patch->tail_to * bytes_per_sample,
+               patch->tail_samples * bytes_per_sample);
+    if (::ftruncate(fd, static_cast<off_t>(data + samples * bytes_per_sample)))
+      throw std::runtime_error("Failed to resize output file: " + path);
+
+    Audio::SegmentRenderer renderer(voices, options.amplitude,
+                                    options.envelope, options.timbre);
+    for (const auto &[begin, end] : patch->dirty)
+      patch_range(fd, renderer, data, begin, end, args.bits);
+
+    if (!args.raw) {
+      std::ostringstream wav_header;
+      Audio::write_pcm_mono_header(wav_header, samples, Audio::kSampleRate,
+                                   static_cast<std::uint16_t>(args.bits));
+      const auto bytes = wav_header.str();
+      write_at(fd, reinterpret_cast<const std::uint8_t *>(bytes.data()),
+               bytes.size(), 0);
+    }
+  } catch (...) {
+    ::close(fd);
+    throw;
+  }
+  ::close(fd);
+
+  index.pin(output);
+  index.save(index_file);
+  std::cout << "Wrote " << args.output_file << " (" << samples
+            << " samples, " << patch->dirty_samples() << " rendered)"
+            << std::endl;
+  return 0;
+}
+
+/// SIGINT and SIGTERM handler for --serve: stops the daemon if one is
+/// running. [RenderServer::stop] only writes to a pipe, so this is safe to
+/// call from a handler.
+void stop_serving(int) {
+  if (auto *server = serving.load())
+    server->stop();
+}
+
+/// Renders the score, then again every time it's saved, until killed. The
+/// options, impulse response and wavetables are set up once; a save that
+/// leaves the normalized score alone stops after reading it, one that
+/// leaves the notes alone stops after parsing, and renders go through
+/// [render_incremental] whenever the options allow. Errors in the score are
+/// reported and the next save is waited for.
+int watch(const Args &args) {
+  if (!args.output_file_provided || args.output_file == "-") {
+    std::cerr << "Error: --watch needs an output file" << std::endl;
+    return 1;
+  }
+  if (args.input_file == "-") {
+    std::cerr << "Error: --watch needs an input file, not stdin" << std::endl;
+    return 1;
+  }
+
+  load_wavetables(args);
+  const auto options = render_options(args);
+  const bool flac = flac_output(args);
+  const bool incremental = incremental_supported(options, flac);
+  const std::string input{args.input_file};
+  const std::filesystem::path output{args.output_file};
+  Io::FileWatcher watcher{std::filesystem::path{input}};
+
+  using Clock = std::chrono::steady_clock;
+  std::cout << std::fixed << std::setprecision(1);
+  auto ms = [](Clock::time_point from, Clock::time_point to) {
+    return std::chrono::duration<double, std::milli>(to - from).count();
+  };
+
+  std::string last_score;
+  std::optional<std::vector<std::vector<Cache::IndexedNote>>> last_notes;
+  // The parser keeps its tokens and nodes between rounds and only reparses
+  // the lines a save touched; [source] is the text it last saw
+  std::string source;
+  std::unique_ptr<FileReading::Parser::Parser> parser;
+  for (;; watcher.wait()) {
+    try {
+      const auto start = Clock::now();
+      // Read, not mapped: the editor may be writing it again already
+      auto text = Io::read_file(input);
+      auto score = Cache::normalize_score(text);
+      const auto read = Clock::now();
+      if (score == last_score) {
+        std::cout << "No changes (read " << ms(start, read) << "ms)"
+                  << std::endl;
+        continue;
+      }
+      last_score = std::move(score);
+
+      // The parser's tokens point into the old text, which has to outlive
+      // the reparse
+      source.swap(text);
+      const auto edit = FileReading::Parser::diff_text(text, source);
+      const bool first = !parser;
+      if (first)
+        parser = std::make_unique<FileReading::Parser::Parser>(source);
+      auto result = first ? parser->parse() : parser->reparse(source, edit);
+      if (result.error()) {
+        log_diagnostics(args, result.diagnostics());
+        continue;
+      }
+      Adapter::NoteInfoAdapter adapter(result.song());
+      const auto voices = adapter.convert();
+      for (const auto &warning : adapter.warnings()) {
+        std::cerr << warning << std::endl;
+      }
+      auto notes = Cache::RenderIndex::of(voices, 0).voices;
+      const auto parsed = Clock::now();
+      if (notes == last_notes) {
+        std::cout << "No changes to the notes (read " << ms(start, read)
+                  << "ms, parse " << ms(read, parsed) << "ms"
+                  << (parser->spliced() ? " incrementally" : "") << ")"
+                  << std::endl;
+        continue;
+      }
+
+      int status = 0;
+      if (incremental) {
+        status = render_incremental(args, options, voices, flac);
+      } else {
+        Cache::RenderCache::detach(output);
+        status = flac ? render_flac(args, options, voices, false)
+                      : render_stream(args, options, voices, false);
+      }
+      const auto rendered = Clock::now();
+      // A failed render gets retried on the next save even if neither the
+      // text nor the notes have changed
+      last_notes.reset();
+      if (status == 0)
+        last_notes = std::move(notes);
+      else
+        last_score.clear();
+      std::cout << "read " << ms(start, read) << "ms, parse "
+                << ms(read, parsed) << "ms"
+                << (parser->spliced() ? " incrementally" : "") << ", render "
+                << ms(parsed, rendered) << "ms" << std::endl;
+    } catch (const std::exception &e) {
+      std::cerr << "Error: " << e.what() << std::endl;
+      last_score.clear();
+      last_notes.reset();
+    }
   }
 }
@@ -0,0 +1,155 @@
+#include <algorithm>
+#include <vector>
+
+#include "adapter/note_info_adapter.hpp"
+#include "audio/biquad.hpp"
+#include "audio/limiter.hpp"
+#include "audio/loudness.hpp"
+#include "audio/mix_renderer.hpp"
+#include "audio/reverb.hpp"
+#include "file_reading/parser/parser.hpp"
+#include "musicgen/musicgen.hpp"
+#include "musicgen/render_context.hpp"
+
+namespace MusicGen {
+
+namespace {
+
+void check_options(const RenderOptions &options, RenderResult &result) {
+  // Past full scale is fine when the limiter brings it back down
+  const bool limited = options.limiter || options.loudness_db;
+  if (options.amplitude < 0.0 || (options.amplitude > 1.0 && !limited)) {
+    result.warnings.push_back("Amplitude must be in [0,1] range.");
+  }
+}
+
+RenderResult render_with(Audio::MixRenderer &renderer,
+                         const RenderOptions &options,
+                         const BlockCallback &on_block) {
+  RenderResult result{};
+  check_options(options, result);
+  result.samples = renderer.total_samples();
+
+  std::vector<std::int16_t> block(
+      std::max<std::size_t>(1, options.block_samples));
+  while (!renderer.done()) {
+    auto n = renderer.render(block);
+    on_block(std::span<const std::int16_t>(block.data(), n));
+  }
+
+  return result;
+}
+
+RenderResult render_with(Audio::MixRenderer &renderer,
+                         const RenderOptions &options,
+                         std::span<std::int16_t> out) {
+  RenderResult result{};
+  check_options(options, result);
+  result.samples = renderer.total_samples();
+  if (result.samples > out.size()) {
+    result.status = Status::BufferTooSmall;
+    return result;
+  }
+
+  renderer.render(out);
+  return result;
+}
+
+} // namespace
+
+RenderResult parse_voices(std::string_view score,
+                          std::vector<Audio::Voice> &voices) {
+  RenderResult result{};
+  FileReading::Parser::Parser parser(score);
+  auto parsed = parser.parse();
+  if (parsed.error()) {
+    result.status = Status::ParseError;
+    result.diagnostics = parsed.diagnostics().messages();
+    return result;
+  }
+
+  Adapter::NoteInfoAdapter adapter(parsed.song());
+  voices = adapter.convert();
+  const auto warnings = adapter.warnings();
+  result.warnings.assign(warnings.begin(), warnings.end());
+  return result;
+}
+
+RenderResult parse_notes(std::string_view score,
+                         std::vector<Audio::NoteInfo> &notes) {
+  std::vector<Audio::Voice> voices;
+  auto result = parse_voices(score, voices);
+  if (!result.ok())
+    return result;
+
+  notes = voices.empty() ? Audio::Voice{} : std::move(voices.front());
+  if (voices.size() > 1)
+    result.warnings.push_back("Warning: only the first voice was kept");
+  return result;
+}
+
+std::unique_ptr<Audio::MixRenderer>
+make_renderer(std::span<const Audio::Voice> voices,
+              const RenderOptions &options) {
+  const double amplitude =
+      options.loudness_db
+          ? Audio::normalized_amplitude(voices, options.envelope,
+                                        options.timbre, *options.loudness_db)
+          : options.amplitude;
+  auto renderer = std::make_unique<Audio::MixRenderer>(
+      voices, amplitude, options.envelope, options.timbre, options.threads);
+  if (!options.eq.empty()) {
+    renderer->add_effect(std::make_unique<Audio::BiquadChain>(options.eq));
+  }
+  if (options.reverb) {
+    renderer->add_effect(
+        std::make_unique<Audio::ConvolutionReverb>(*options.reverb));
+  }
+  if (options.limiter || options.loudness_db) {
+    renderer->add_effect(std::make_unique<Audio::LookaheadLimiter>(
+        options.limiter.value_or(Audio::LimiterSettings{})));
+  }
+  renderer->set_output_rate(options.sample_rate, options.resample_quality);
+  renderer->set_dither(options.dither);
+  return renderer;
+}
+
+RenderResult render_voices(std::span<const Audio::Voice> voices,
+                           const RenderOptions &options,
+                           const BlockCallback &on_block) {
+  return render_with(*make_renderer(voices, options), options, on_block);
+}
+
+RenderResult render_voices(std::span<const Audio::Voice> voices,
+                           const RenderOptions &options,
+                           std::span<std::int16_t> out) {
+  return render_with(*make_renderer(voices, options), options, out);
+}
+
+RenderResult render_notes(std::span<const Audio::NoteInfo> notes,
+                          const RenderOptions &options,
+                          const BlockCallback &on_block) {
+  const std::vector<Audio::Voice> voices{
+      Audio::Voice(notes.begin(), notes.end())};
+  return render_voices(voices, options, on_block);
+}
+
+RenderResult render_notes(std::span<const Audio::NoteInfo> notes,
+                          const RenderOptions &options,
+                          std::span<std::int16_t> out) {
+  const std::vector<Audio::Voice> voices{
+      Audio::Voice(notes.begin(), notes.end())};
+  return render_voices(voices, options, out);
+}
+
+RenderResult render(std::string_view score, const RenderOptions &options,
+                    const BlockCallback &on_block) {
+  return RenderContext(score).render(options, on_block);
+}
+
+RenderResult render(std::string_view score, const RenderOptions &options,
+                    std::span<std::int16_t> out) {
+  return RenderContext(score).render(options, out);
+}
+
+} // namespace MusicGen
@@ -0,0 +1,89 @@
+#include <algorithm>
+#include <utility>
+
+#include "adapter/note_info_adapter.hpp"
+#include "musicgen/render_context.hpp"
+
+namespace MusicGen {
+
+namespace {
+
+// A first arena block big enough for the tokens and nodes of most scores;
+// past that it grows by itself
+constexpr std::size_t kArenaBytesPerScoreByte = 8;
+constexpr std::size_t kMinArenaBytes = 4096;
+
+} // namespace
+
+RenderContext::RenderContext(std::string_view score,
+                             WarningCallback on_warning)
+    : _arena(std::max(kMinArenaBytes, score.size() * kArenaBytesPerScoreByte)),
+      _score(score, &_arena), _on_warning(std::move(on_warning)) {}
+
+void RenderContext::warn(std::string_view warning) const {
+  if (_on_warning)
+    _on_warning(warning);
+}
+
+bool RenderContext::parse() {
+  if (!_parsed) {
+    _parser.emplace(_score, &_arena);
+    _parsed = _parser->parse();
+    if (!_parsed->error()) {
+      Adapter::NoteInfoAdapter adapter(_parsed->song());
+      _voices = adapter.convert();
+      for (const auto &warning : adapter.warnings()) {
+        _warnings.push_back(warning);
+        warn(warning);
+      }
+    }
+  }
+  return !_parsed->error();
+}
+
+const FileReading::Diagnostics &RenderContext::diagnostics() const {
+  static const FileReading::Diagnostics none;
+  return _parsed ? _parsed->diagnostics() : none;
+}
+
+std::span<FileReading::Parser::Node *const> RenderContext::nodes() const {
+  if (!_parsed)
+    return {};
+  return _parsed->nodes();
+}
+
+std::span<const Audio::Voice> RenderContext::voices() const { return _voices; }
+
+std::span<const std::string> RenderContext::warnings() const {
+  return _warnings;
+}
+
+template <typename Sink>
+RenderResult RenderContext::render_to(const RenderOptions &options,
+                                      Sink &&sink) {
+  if (!parse()) {
+    RenderResult result{};
+    result.status = Status::ParseError;
+    result.diagnostics = _parsed->diagnostics().messages();
+    return result;
+  }
+
+  auto result = render_voices(_voices, options, std::forward<Sink>(sink));
+  for (const auto &warning : result.warnings)
+    warn(warning);
+  result.warnings.insert(result.warnings.begin(), _warnings.begin(),
+                         _warnings.end());
+  return result;
+}
+
+RenderResult RenderContext::render(const RenderOptions &options,
+                                   const BlockCallback &on_block) {
+  return render_to(options, on_block);
+}
+
+RenderResult RenderContext::render(const RenderOptions &options,
+                                   std::span<std::int16_t> out) {
+  return render_to(options, out);
+}
+
+} // namespace MusicGen
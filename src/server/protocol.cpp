@@ -0,0 +1,117 @@
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+#include "server/protocol.hpp"
+
+namespace Server {
+
+namespace {
+
+void store_u32_le(std::uint8_t *p, std::uint32_t v) {
+  for (int i = 0; i < 4; ++i)
+    p[i] = static_cast<std::uint8_t>((v >> (8 * i)) & 0xFFu);
+}
+
+void store_u64_le(std::uint8_t *p, std::uint64_t v) {
+  for (int i = 0; i < 8; ++i)
+    p[i] = static_cast<std::uint8_t>((v >> (8 * i)) & 0xFFu);
+}
+
+} // namespace
+
+std::uint32_t load_u32_le(const std::uint8_t *p) {
+  std::uint32_t v = 0;
+  for (int i = 3; i >= 0; --i)
+    v = (v << 8) | p[i];
+  return v;
+}
+
+std::uint64_t load_u64_le(const std::uint8_t *p) {
+  std::uint64_t v = 0;
+  for (int i = 7; i >= 0; --i)
+    v = (v << 8) | p[i];
+  return v;
+}
+
+sockaddr_un make_address(const std::string &path) {
+  sockaddr_un addr{};
+  addr.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(addr.sun_path))
+    throw std::runtime_error("Socket path too long: " + path);
+  std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+  return addr;
+}
+
+bool read_exact(int fd, std::span<std::uint8_t> buf) {
+  std::size_t got = 0;
+  while (got < buf.size()) {
+    const auto n = ::read(fd, buf.data() + got, buf.size() - got);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n < 0)
+      throw std::runtime_error(std::string("read failed: ") +
+                               std::strerror(errno));
+    if (n == 0) {
+      if (got == 0)
+        return false;
+      throw std::runtime_error("connection closed mid-message");
+    }
+    got += static_cast<std::size_t>(n);
+  }
+  return true;
+}
+
+void write_all(int fd, std::span<const std::uint8_t> buf) {
+  std::size_t sent = 0;
+  while (sent < buf.size()) {
+    const auto n = ::write(fd, buf.data() + sent, buf.size() - sent);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n < 0)
+      throw std::runtime_error(std::string("write failed: ") +
+                               std::strerror(errno));
+    sent += static_cast<std::size_t>(n);
+  }
+}
+
+void write_request(int fd, OutputFormat format, std::string_view score) {
+  if (score.size() > kMaxScoreBytes)
+    throw std::runtime_error("score too large to send");
+
+  std::uint8_t header[kRequestHeaderBytes];
+  header[0] = static_cast<std::uint8_t>(format);
+  store_u32_le(header + 1, static_cast<std::uint32_t>(score.size()));
+  write_all(fd, header);
+  write_all(fd, std::span(reinterpret_cast<const std::uint8_t *>(score.data()),
+                          score.size()));
+}
+
+void write_response_header(int fd, ResponseStatus status,
+                           std::uint64_t length) {
+  std::uint8_t header[kResponseHeaderBytes];
+  header[0] = static_cast<std::uint8_t>(status);
+  store_u64_le(header + 1, length);
+  write_all(fd, header);
+}
+
+void write_pcm16(int fd, std::span<const std::int16_t> samples) {
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+  std::vector<std::uint8_t> bytes(samples.size() * 2);
+  for (std::size_t i = 0; i < samples.size(); ++i) {
+    const auto v = static_cast<std::uint16_t>(samples[i]);
+    bytes[2 * i] = static_cast<std::uint8_t>(v & 0xFFu);
+    bytes[2 * i + 1] = static_cast<std::uint8_t>(v >> 8);
+  }
+  write_all(fd, bytes);
+#else
+  write_all(fd, std::span(reinterpret_cast<const std::uint8_t *>(
+                              samples.data()),
+                          samples.size() * sizeof(std::int16_t)));
+#endif
+}
+
+} // namespace Server
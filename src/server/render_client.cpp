@@ -0,0 +1,66 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+#include "server/render_client.hpp"
+
+namespace Server {
+
+ClientResult request_render(const std::string &socket_path,
+                            OutputFormat format, std::string_view score,
+                            std::ostream &out) {
+  const auto addr = make_address(socket_path);
+  const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0)
+    throw std::runtime_error(std::string("socket failed: ") +
+                             std::strerror(errno));
+  if (::connect(fd, reinterpret_cast<const sockaddr *>(&addr),
+                sizeof(addr)) < 0) {
+    ::close(fd);
+    throw std::runtime_error("Failed to connect to " + socket_path + ": " +
+                             std::strerror(errno));
+  }
+
+  ClientResult result{};
+  try {
+    write_request(fd, format, score);
+
+    std::uint8_t header[kResponseHeaderBytes];
+    if (!read_exact(fd, header))
+      throw std::runtime_error("server closed the connection");
+    result.status = static_cast<ResponseStatus>(header[0]);
+    auto remaining = load_u64_le(header + 1);
+
+    std::vector<std::uint8_t> buf(1 << 16);
+    while (remaining > 0) {
+      const auto chunk = static_cast<std::size_t>(
+          std::min<std::uint64_t>(remaining, buf.size()));
+      if (!read_exact(fd, std::span(buf.data(), chunk)))
+        throw std::runtime_error("server closed the connection mid-response");
+      if (result.status == ResponseStatus::Ok) {
+        out.write(reinterpret_cast<const char *>(buf.data()),
+                  static_cast<std::streamsize>(chunk));
+        if (!out)
+          throw std::runtime_error("I/O error while writing output");
+        result.bytes += chunk;
+      } else {
+        result.diagnostics.append(reinterpret_cast<const char *>(buf.data()),
+                                  chunk);
+      }
+      remaining -= chunk;
+    }
+  } catch (...) {
+    ::close(fd);
+    throw;
+  }
+
+  ::close(fd);
+  return result;
+}
+
+} // namespace Server
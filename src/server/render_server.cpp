@@ -0,0 +1,233 @@
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sstream>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "audio/mix_renderer.hpp"
+#include "audio/note_info.hpp"
+#include "audio/wav_writer.hpp"
+#include "server/protocol.hpp"
+#include "server/render_server.hpp"
+
+namespace Server {
+
+/// Per-thread scratch space that survives from one request to the next.
+struct RenderServer::Worker {
+  std::vector<std::uint8_t> score;
+  std::vector<Audio::Voice> voices;
+  std::vector<std::int16_t> block;
+};
+
+RenderServer::RenderServer(ServerOptions options)
+    : _options(std::move(options)) {
+  if (_options.threads == 0)
+    _options.threads = std::max(1u, std::thread::hardware_concurrency());
+  if (::pipe(_wake_fds) < 0)
+    throw std::runtime_error(std::string("pipe failed: ") +
+                             std::strerror(errno));
+  // A signal handler calling [stop] must never block on a full pipe
+  ::fcntl(_wake_fds[1], F_SETFL, O_NONBLOCK);
+}
+
+RenderServer::~RenderServer() {
+  shut_down();
+  for (auto &worker : _workers)
+    worker.join();
+  if (_listen_fd >= 0) {
+    ::close(_listen_fd);
+    ::unlink(_options.socket_path.c_str());
+  }
+  ::close(_wake_fds[0]);
+  ::close(_wake_fds[1]);
+}
+
+void RenderServer::run() {
+  // A client hanging up mid-response must not take the whole daemon down.
+  std::signal(SIGPIPE, SIG_IGN);
+
+  const auto addr = make_address(_options.socket_path);
+
+  // Only ever clear out a stale socket left behind by a previous run, never
+  // some unrelated file that happens to sit at the same path.
+  struct stat st {};
+  if (::lstat(_options.socket_path.c_str(), &st) == 0) {
+    if (!S_ISSOCK(st.st_mode))
+      throw std::runtime_error("Refusing to replace non-socket file: " +
+                               _options.socket_path);
+    ::unlink(_options.socket_path.c_str());
+  }
+
+  _listen_fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (_listen_fd < 0)
+    throw std::runtime_error(std::string("socket failed: ") +
+                             std::strerror(errno));
+  if (::bind(_listen_fd, reinterpret_cast<const sockaddr *>(&addr),
+             sizeof(addr)) < 0)
+    throw std::runtime_error("Failed to bind " + _options.socket_path + ": " +
+                             std::strerror(errno));
+  if (::listen(_listen_fd, SOMAXCONN) < 0)
+    throw std::runtime_error(std::string("listen failed: ") +
+                             std::strerror(errno));
+  // A client giving up between poll and accept must not leave us stuck in
+  // accept where [stop] can't reach
+  ::fcntl(_listen_fd, F_SETFL, O_NONBLOCK);
+
+  for (unsigned int i = 0; i < _options.threads; ++i)
+    _workers.emplace_back([this] { worker_loop(); });
+
+  pollfd fds[] = {{_listen_fd, POLLIN, 0}, {_wake_fds[0], POLLIN, 0}};
+  while (true) {
+    if (::poll(fds, 2, -1) < 0) {
+      if (errno == EINTR)
+        continue;
+      break;
+    }
+    if (fds[1].revents != 0)
+      break; // stop() was called
+    if (fds[0].revents == 0)
+      continue;
+
+    const int client = ::accept(_listen_fd, nullptr, nullptr);
+    if (client < 0) {
+      if (errno == EINTR || errno == ECONNABORTED || errno == EAGAIN ||
+          errno == EWOULDBLOCK)
+        continue;
+      break;
+    }
+    // Some systems hand out the listening socket's flags; workers block
+    ::fcntl(client, F_SETFL, 0);
+
+    std::lock_guard lock(_mutex);
+    _pending.push_back(client);
+    _cv.notify_one();
+  }
+
+  shut_down();
+  for (auto &worker : _workers)
+    worker.join();
+  _workers.clear();
+}
+
+void RenderServer::stop() {
+  const char byte = 1;
+  // A full pipe already has a stop in it
+  [[maybe_unused]] const auto written = ::write(_wake_fds[1], &byte, 1);
+}
+
+void RenderServer::shut_down() {
+  std::lock_guard lock(_mutex);
+  _stopping = true;
+  for (const int fd : _pending)
+    ::close(fd);
+  _pending.clear();
+  // Wakes workers waiting on an idle keep-alive client or writing to one
+  // that stopped reading; the worker still owns and closes the fd
+  for (const int fd : _clients)
+    ::shutdown(fd, SHUT_RDWR);
+  _cv.notify_all();
+}
+
+void RenderServer::worker_loop() {
+  Worker worker{};
+  while (true) {
+    int fd = -1;
+    {
+      std::unique_lock lock(_mutex);
+      _cv.wait(lock, [this] { return _stopping || !_pending.empty(); });
+      if (_stopping)
+        return;
+      fd = _pending.front();
+      _pending.pop_front();
+      _clients.push_back(fd);
+    }
+
+    serve_client(fd, worker);
+    {
+      // Out of [_clients] before the number can be reused by another accept
+      std::lock_guard lock(_mutex);
+      _clients.erase(std::find(_clients.begin(), _clients.end(), fd));
+    }
+    ::close(fd);
+  }
+}
+
+void RenderServer::serve_client(int fd, Worker &worker) {
+  try {
+    while (serve_request(fd, worker)) {
+    }
+  } catch (const std::exception &) {
+    // The client vanished or sent garbage, either way we're done with it.
+  }
+}
+
+bool RenderServer::serve_request(int fd, Worker &worker) {
+  std::uint8_t header[kRequestHeaderBytes];
+  if (!read_exact(fd, header))
+    return false;
+
+  const auto format = static_cast<OutputFormat>(header[0]);
+  const auto length = load_u32_le(header + 1);
+  if ((format != OutputFormat::RawPcm16 && format != OutputFormat::Wav) ||
+      length > kMaxScoreBytes) {
+    const std::string_view message = "Error: malformed request";
+    write_response_header(fd, ResponseStatus::BadRequest, message.size());
+    write_all(fd, std::span(reinterpret_cast<const std::uint8_t *>(
+                                message.data()),
+                            message.size()));
+    return false;
+  }
+
+  worker.score.resize(length);
+  if (!read_exact(fd, worker.score))
+    return false;
+
+  const std::string_view score(
+      reinterpret_cast<const char *>(worker.score.data()), length);
+  auto parsed = MusicGen::parse_voices(score, worker.voices);
+  if (!parsed.ok()) {
+    std::string message;
+    for (const auto &diag : parsed.diagnostics)
+      message += diag + "\n";
+    write_response_header(fd, ResponseStatus::ParseError, message.size());
+    write_all(fd, std::span(reinterpret_cast<const std::uint8_t *>(
+                                message.data()),
+                            message.size()));
+    return true;
+  }
+
+  // The note table tells us the exact length up front, so the header (and the
+  // WAV header inside the payload) can go out before any sample is rendered.
+  auto renderer = MusicGen::make_renderer(worker.voices, _options.render);
+  const auto samples = renderer->total_samples();
+
+  std::uint64_t payload = samples * sizeof(std::int16_t);
+  if (format == OutputFormat::Wav)
+    payload += Audio::wav_header_bytes(samples);
+  write_response_header(fd, ResponseStatus::Ok, payload);
+
+  if (format == OutputFormat::Wav) {
+    std::ostringstream wav_header;
+    Audio::write_pcm16_mono_header(wav_header, samples,
+                                   renderer->output_rate());
+    const auto bytes = wav_header.str();
+    write_all(fd, std::span(reinterpret_cast<const std::uint8_t *>(
+                                bytes.data()),
+                            bytes.size()));
+  }
+
+  worker.block.resize(std::max<std::size_t>(1, _options.render.block_samples));
+  while (!renderer->done()) {
+    const auto n = renderer->render(worker.block);
+    write_pcm16(fd, std::span<const std::int16_t>(worker.block.data(), n));
+  }
+  return true;
+}
+
+} // namespace Server
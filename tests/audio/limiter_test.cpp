@@ -0,0 +1,131 @@
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "audio/limiter.hpp"
+#include "audio/pcm_format.hpp"
+#include "check.hpp"
+
+// LookaheadLimiter against a brute force model of the same limiter: the
+// sliding minimum and the moving average recomputed from scratch for every
+// sample.
+
+namespace {
+
+struct Reference {
+  std::vector<float> out;
+  float peak = 0.0f; // highest output before the final clamp
+};
+
+Reference reference(std::span<const float> in,
+                    const Audio::LimiterSettings &settings) {
+  const auto sr = static_cast<double>(Audio::kSampleRate);
+  const auto window = std::max<std::size_t>(
+      2, static_cast<std::size_t>(std::lround(settings.lookahead_s * sr)));
+  const auto release = static_cast<float>(
+      1.0 - std::exp(-1.0 / (std::max(settings.release_s, 1e-4) * sr)));
+
+  std::vector<float> needed(in.size()), held(in.size());
+  for (std::size_t i = 0; i < in.size(); ++i) {
+    const float magnitude = std::abs(in[i]);
+    needed[i] = magnitude > settings.ceiling ? settings.ceiling / magnitude
+                                             : 1.0f;
+    const auto first = i + 1 >= window ? i + 1 - window : 0;
+    held[i] = *std::min_element(needed.begin() + static_cast<long>(first),
+                                needed.begin() + static_cast<long>(i) + 1);
+  }
+
+  Reference result;
+  float gain = 1.0f;
+  for (std::size_t i = 0; i < in.size(); ++i) {
+    double sum = 0.0;
+    for (std::size_t k = 0; k < window; ++k)
+      sum += i >= k ? held[i - k] : 1.0;
+    const auto target = static_cast<float>(sum / static_cast<double>(window));
+    if (target < gain) {
+      gain = target;
+    } else {
+      gain += (target - gain) * release;
+      if (target - gain < 1e-5f)
+        gain = target;
+    }
+    const float delayed = i + 1 >= window ? in[i + 1 - window] : 0.0f;
+    result.peak = std::max(result.peak, std::abs(delayed * gain));
+    result.out.push_back(
+        std::clamp(delayed * gain, -settings.ceiling, settings.ceiling));
+  }
+  return result;
+}
+
+void check_limiter(const std::string &name, const std::vector<float> &in,
+                   const Audio::LimiterSettings &settings) {
+  const auto expected = reference(in, settings);
+  Test::check(expected.peak <= settings.ceiling * 1.0001f,
+              name + ": model goes above the ceiling");
+
+  // Odd block sizes, so the rings wrap anywhere
+  Audio::LookaheadLimiter limiter(settings);
+  auto out = in;
+  const std::size_t blocks[] = {1, 7, 64, 333};
+  for (std::size_t at = 0, b = 0; at < out.size(); ++b) {
+    const auto n = std::min(blocks[b % 4], out.size() - at);
+    limiter.process(std::span(out).subspan(at, n));
+    at += n;
+  }
+
+  for (std::size_t i = 0; i < out.size(); ++i) {
+    if (!Test::check(std::abs(out[i] - expected.out[i]) <= 1e-5f,
+                     name + ": sample " + std::to_string(i) + " is " +
+                         std::to_string(out[i]) + ", expected " +
+                         std::to_string(expected.out[i])))
+      return;
+  }
+}
+
+std::vector<float> ramp(float from, float to, std::size_t samples) {
+  std::vector<float> out(samples + 64, 0.0f); // silence lets the tail out
+  for (std::size_t i = 0; i < samples; ++i)
+    out[i] = from + (to - from) * static_cast<float>(i) /
+                        static_cast<float>(samples - 1);
+  return out;
+}
+
+} // namespace
+
+int main() {
+  const auto sr = static_cast<double>(Audio::kSampleRate);
+  const Audio::LimiterSettings short_window{.lookahead_s = 4.0 / sr};
+  const Audio::LimiterSettings defaults{};
+
+  // A falling magnitude above the ceiling asks for more gain on every sample,
+  // which is the longest the sliding minimum's queue ever gets
+  check_limiter("falling ramp, 4 samples", ramp(5.0f, 1.0f, 400),
+                short_window);
+  check_limiter("falling ramp", ramp(5.0f, 1.0f, 4000), defaults);
+  check_limiter("rising ramp, 4 samples", ramp(1.0f, 5.0f, 400),
+                short_window);
+  check_limiter("negative ramp, 4 samples", ramp(-5.0f, -1.0f, 400),
+                short_window);
+
+  // The falling side of a loud low note is the same thing in practice
+  std::vector<float> note(8000);
+  for (std::size_t i = 0; i < note.size(); ++i)
+    note[i] = 3.0f * static_cast<float>(std::sin(
+                         2.0 * 3.141592653589793 * 55.0 *
+                         static_cast<double>(i) / sr));
+  check_limiter("low note", note, defaults);
+  check_limiter("low note, 4 samples", note, short_window);
+
+  std::mt19937 rng(3);
+  std::uniform_real_distribution<float> loud(-4.0f, 4.0f);
+  std::vector<float> bursts(20000);
+  for (std::size_t i = 0; i < bursts.size(); ++i)
+    bursts[i] = (i / 1500) % 2 == 0 ? loud(rng) : loud(rng) / 8.0f;
+  check_limiter("bursts", bursts, defaults);
+  check_limiter("bursts, 4 samples", bursts, short_window);
+
+  return Test::finish("limiter_test");
+}
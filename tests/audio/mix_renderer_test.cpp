@@ -0,0 +1,73 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <numbers>
+#include <string>
+#include <vector>
+
+#include "audio/envelope.hpp"
+#include "audio/mix_renderer.hpp"
+#include "audio/note_info.hpp"
+#include "audio/pcm_format.hpp"
+#include "check.hpp"
+
+// A single voice close to full scale has to come out as the plain sine,
+// rounded, rather than bent by the soft limiter meant for summed voices.
+
+namespace {
+
+constexpr double kFreqHz = 440.0;
+constexpr double kSeconds = 0.5;
+
+std::vector<std::int16_t> rounded_sine(double amplitude,
+                                       const Audio::Adsr &adsr, int samples) {
+  Audio::Envelope envelope(adsr);
+  envelope.start(samples);
+  std::vector<double> env(static_cast<std::size_t>(samples));
+  envelope.render(env, 0);
+
+  const auto sr = static_cast<double>(Audio::kSampleRate);
+  std::vector<std::int16_t> out;
+  for (int i = 0; i < samples; ++i) {
+    const double x =
+        amplitude * env[static_cast<std::size_t>(i)] *
+        std::sin(2.0 * std::numbers::pi * kFreqHz * static_cast<double>(i) /
+                 sr);
+    out.push_back(static_cast<std::int16_t>(std::lround(x * 32767.0)));
+  }
+  return out;
+}
+
+void check_mono(double amplitude) {
+  const auto adsr = Audio::fade_envelope(0.005);
+  const std::vector<Audio::Voice> voices{{Audio::NoteInfo(kFreqHz, kSeconds)}};
+  Audio::MixRenderer renderer(voices, amplitude, adsr, Audio::Timbre::Sine);
+  std::vector<std::int16_t> out(renderer.total_samples());
+  Test::check(renderer.render(out) == out.size(), "short render");
+
+  const auto expected =
+      rounded_sine(amplitude, adsr, static_cast<int>(out.size()));
+  int worst = 0;
+  for (std::size_t i = 0; i < out.size(); ++i)
+    worst = std::max(worst, std::abs(out[i] - expected[i]));
+  const auto label = "-a " + std::to_string(amplitude) + ": ";
+  // Rounding in float instead of double can land the other side of a half
+  Test::check(worst <= 1,
+              label + "off the rounded sine by " + std::to_string(worst));
+
+  const auto peak = *std::max_element(out.begin(), out.end());
+  const auto expected_peak =
+      *std::max_element(expected.begin(), expected.end());
+  Test::check(std::abs(peak - expected_peak) <= 1,
+              label + "peak " + std::to_string(peak) + " instead of " +
+                  std::to_string(expected_peak));
+}
+
+} // namespace
+
+int main() {
+  check_mono(0.95);
+  check_mono(1.0);
+  return Test::finish("mix_renderer_test");
+}
@@ -0,0 +1,85 @@
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+#include "audio/pcm_format.hpp"
+#include "audio/wav_writer.hpp"
+#include "check.hpp"
+
+// WAV headers on both sides of the 4GiB line: plain RIFF with 32 bit sizes
+// below it, RF64 with the sizes in a ds64 chunk above it, and the sample
+// count read back from the file size either way.
+
+namespace {
+
+std::uint64_t u32_at(std::string_view bytes, std::size_t at) {
+  std::uint64_t v = 0;
+  for (std::size_t i = 4; i-- > 0;)
+    v = v << 8 | static_cast<unsigned char>(bytes[at + i]);
+  return v;
+}
+
+std::uint64_t u64_at(std::string_view bytes, std::size_t at) {
+  return u32_at(bytes, at) | u32_at(bytes, at + 4) << 32;
+}
+
+std::string header(std::uint64_t samples) {
+  std::ostringstream out;
+  Audio::write_pcm16_mono_header(out, samples);
+  return out.str();
+}
+
+void check_riff(std::uint64_t samples) {
+  const auto bytes = header(samples);
+  const auto data = samples * Audio::kBlockAlign;
+  const auto label = std::to_string(samples) + " samples: ";
+  Test::check(bytes.size() == Audio::kWavHeaderBytes &&
+                  bytes.size() == Audio::wav_header_bytes(samples),
+              label + "RIFF header of " + std::to_string(bytes.size()));
+  Test::check(bytes.starts_with("RIFF") && u32_at(bytes, 4) == 36 + data,
+              label + "RIFF size");
+  Test::check(bytes.substr(36, 4) == "data" && u32_at(bytes, 40) == data,
+              label + "data size");
+  Test::check(Audio::wav_samples_in_file(bytes.size() + data) == samples,
+              label + "samples in file");
+}
+
+void check_rf64(std::uint64_t samples) {
+  const auto bytes = header(samples);
+  const auto data = samples * Audio::kBlockAlign;
+  const auto label = std::to_string(samples) + " samples: ";
+  Test::check(bytes.size() == Audio::wav_header_bytes(samples) &&
+                  bytes.size() == Audio::kWavHeaderBytes + 36,
+              label + "RF64 header of " + std::to_string(bytes.size()));
+  Test::check(bytes.starts_with("RF64") && u32_at(bytes, 4) == 0xFFFFFFFFu,
+              label + "RF64 size placeholder");
+  Test::check(bytes.substr(12, 4) == "ds64" && u32_at(bytes, 16) == 28,
+              label + "ds64 chunk");
+  Test::check(u64_at(bytes, 20) == bytes.size() - 8 + data &&
+                  u64_at(bytes, 28) == data && u64_at(bytes, 36) == samples,
+              label + "ds64 sizes");
+  Test::check(bytes.substr(72, 4) == "data" &&
+                  u32_at(bytes, 76) == 0xFFFFFFFFu,
+              label + "data size placeholder");
+  Test::check(Audio::wav_samples_in_file(bytes.size() + data) == samples,
+              label + "samples in file");
+}
+
+} // namespace
+
+int main() {
+  // The largest payload whose RIFF size still fits in 32 bits
+  constexpr std::uint64_t kLargestRiff = (0xFFFFFFFFull - 36) / 2;
+  check_riff(0);
+  check_riff(44100);
+  check_riff(kLargestRiff);
+  check_rf64(kLargestRiff + 1);
+  check_rf64(8ull * 3600 * 96000);
+
+  // Shorter than any header, e.g. a render that failed part way
+  for (std::uint64_t bytes = 0; bytes < Audio::kWavHeaderBytes; ++bytes)
+    Test::check(Audio::wav_samples_in_file(bytes) == 0,
+                std::to_string(bytes) + " byte file");
+  return Test::finish("wav_writer_test");
+}
@@ -0,0 +1,39 @@
+#pragma once
+#ifndef CHECK_HPP
+#define CHECK_HPP
+
+#include <iostream>
+#include <source_location>
+#include <string>
+#include <string_view>
+
+/// What the programs in tests/ report with. Each test is a program of its
+/// own; `make test` runs them all and fails if any of them exits non-zero.
+namespace Test {
+
+inline int failures = 0;
+
+/// Records a failure, with where it happened, unless [ok].
+inline bool
+check(bool ok, std::string_view what,
+      std::source_location where = std::source_location::current()) {
+  if (!ok) {
+    ++failures;
+    std::cerr << where.file_name() << ":" << where.line() << ": " << what
+              << "\n";
+  }
+  return ok;
+}
+
+/// Prints the outcome of test [name] and gives main its exit code.
+inline int finish(std::string_view name) {
+  std::cout << name << ": "
+            << (failures == 0 ? std::string("ok")
+                              : std::to_string(failures) + " failed")
+            << "\n";
+  return failures == 0 ? 0 : 1;
+}
+
+} // namespace Test
+
+#endif
@@ -0,0 +1,151 @@
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "check.hpp"
+#include "file_reading/lexer/token.hpp"
+#include "file_reading/parser/node.hpp"
+#include "file_reading/parser/node_kinds.hpp"
+#include "file_reading/parser/parser.hpp"
+
+// Parser::reparse against a fresh Parser::parse of the same text, over
+// random edits to every score in examples/: whole note lines added, removed
+// and rewritten, which splice, and stray characters anywhere, which mostly
+// don't.
+
+namespace {
+
+using FileReading::Parser::NodeKind;
+
+std::string describe(const FileReading::Lexer::Token *token) {
+  if (token == nullptr)
+    return "-";
+  std::ostringstream out;
+  out << static_cast<unsigned int>(token->kind) << '@' << token->loc.line
+      << ':' << token->loc.col << '\'' << token->lexeme << '\'';
+  return out.str();
+}
+
+/// Everything a caller can see of a result.
+std::string describe(const FileReading::Parser::ParseResult &result) {
+  std::ostringstream out;
+  for (const auto &message : result.diagnostics().messages())
+    out << "error " << message << '\n';
+  if (result.error())
+    return out.str();
+
+  for (const auto *node : result.nodes()) {
+    out << static_cast<unsigned int>(node->kind()) << ' '
+        << describe(node->token());
+    if (node->kind() == NodeKind::Note_Info) {
+      const auto *info =
+          static_cast<const FileReading::Parser::NoteInfoNode *>(node);
+      for (const auto *note : info->notes())
+        out << " note " << describe(note->token()) << ' '
+            << static_cast<unsigned int>(note->accidental()) << ' '
+            << note->octave();
+      out << " for " << describe(info->duration()->token())
+          << (info->duration()->dotted() ? "." : "");
+    }
+    out << '\n';
+  }
+  for (const auto &voice : result.song()->voices()) {
+    out << "voice";
+    for (const auto *info : voice)
+      out << ' ' << describe(info->token());
+    out << '\n';
+  }
+  return out.str();
+}
+
+std::string read(const std::filesystem::path &path) {
+  std::ifstream in(path, std::ios::binary);
+  std::stringstream text;
+  text << in.rdbuf();
+  return text.str();
+}
+
+/// Start of a random line of [text].
+std::size_t line_start(std::mt19937 &rng, const std::string &text) {
+  std::vector<std::size_t> starts{0};
+  for (std::size_t i = 0; i < text.size(); ++i)
+    if (text[i] == '\n' && i + 1 < text.size())
+      starts.push_back(i + 1);
+  return starts[rng() % starts.size()];
+}
+
+/// [text] with one random edit applied.
+std::string edit(std::mt19937 &rng, const std::string &text) {
+  static const char *const note_lines[] = {"C4 q\n", "D#3 e.\n", "R h\n",
+                                           "Bb5 s\n", "[C4 E4 G4] q\n"};
+  static const char *const strays[] = {"\n", "; hi\n", "E", "q", "5", " ",
+                                       "[START]\n", "BPM", "X", "[C4\nE4] q\n",
+                                       ";", "["};
+  std::size_t offset = 0, removed = 0;
+  std::string inserted;
+  if (rng() % 6 != 0) {
+    // Whole lines, which is what an editor mostly sends
+    offset = line_start(rng, text);
+    for (auto lines = rng() % 3; lines > 0; --lines) {
+      const auto end = text.find('\n', offset + removed);
+      if (end == std::string::npos)
+        break;
+      removed = end + 1 - offset;
+    }
+    for (auto lines = rng() % 3; lines > 0; --lines)
+      inserted += note_lines[rng() % std::size(note_lines)];
+  } else {
+    offset = rng() % (text.size() + 1);
+    removed = std::min<std::size_t>(rng() % 6, text.size() - offset);
+    for (auto pieces = rng() % 3; pieces > 0; --pieces)
+      inserted += strays[rng() % std::size(strays)];
+  }
+  return text.substr(0, offset) + inserted + text.substr(offset + removed);
+}
+
+} // namespace
+
+int main() {
+  std::size_t edits = 0, spliced = 0;
+  for (const auto &file : std::filesystem::directory_iterator("examples")) {
+    const auto original = read(file.path());
+    std::mt19937 rng(7);
+
+    // The parser keeps pointing into the last text until the next reparse
+    auto text = std::make_unique<std::string>(original);
+    FileReading::Parser::Parser parser(*text);
+    parser.parse();
+
+    bool broken = false;
+    for (int i = 0; i < 400; ++i) {
+      // Errors make every reparse a full one, so they don't get to stay long
+      const bool revert = rng() % 25 == 0 || (broken && rng() % 3 == 0);
+      auto next = std::make_unique<std::string>(revert ? original
+                                                       : edit(rng, *text));
+      const auto result =
+          parser.reparse(*next, FileReading::Parser::diff_text(*text, *next));
+      FileReading::Parser::Parser fresh(*next);
+      const auto expected = fresh.parse();
+
+      ++edits;
+      spliced += parser.spliced();
+      broken = expected.error();
+      if (!Test::check(describe(result) == describe(expected),
+                       file.path().string() + ", edit " + std::to_string(i) +
+                           ": reparse differs from a parse of:\n" + *next))
+        break;
+      text = std::move(next);
+    }
+  }
+
+  // Not much of a test of splicing otherwise; the error examples never
+  // splice, about a quarter of all edits do
+  Test::check(spliced > edits / 8, std::to_string(spliced) + " of " +
+                                       std::to_string(edits) +
+                                       " edits spliced");
+  return Test::finish("reparse_test");
+}
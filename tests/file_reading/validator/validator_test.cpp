@@ -0,0 +1,123 @@
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "check.hpp"
+#include "file_reading/diagnostic.hpp"
+#include "file_reading/parser/parser.hpp"
+#include "file_reading/validator/validator.hpp"
+
+// Validator::validate against Parser::parse: the same scores accepted, and
+// the same first error, with the same location, for the rest. The scores
+// are examples/, copies of them with a few random edits, and strings of
+// score fragments thrown together.
+
+namespace {
+
+std::string read(const std::filesystem::path &path) {
+  std::ifstream in(path, std::ios::binary);
+  std::stringstream text;
+  text << in.rdbuf();
+  return text.str();
+}
+
+bool same(const FileReading::Diagnostic &a, const FileReading::Diagnostic &b) {
+  return a.code == b.code && a.offset == b.offset &&
+         a.loc.line == b.loc.line && a.loc.col == b.loc.col &&
+         a.expected == b.expected && a.actual == b.actual;
+}
+
+std::size_t accepted = 0;
+
+void check_score(const std::string &score) {
+  FileReading::Parser::Parser parser(score);
+  const auto parsed = parser.parse();
+  const auto checked = FileReading::Validator::validate(score, 10);
+
+  const auto &expected = parsed.diagnostics();
+  bool agree = expected.empty() == checked.empty();
+  if (agree && !checked.empty())
+    agree = same(expected.kept().front(), checked.kept().front());
+  accepted += agree && checked.empty();
+  auto first = [](const FileReading::Diagnostics &diagnostics) {
+    return diagnostics.empty() ? std::string("ok")
+                               : diagnostics.kept().front().message();
+  };
+  Test::check(agree, "--check and the parser disagree on:\n" + score +
+                         "\nparser: " + first(expected) +
+                         "\n--check: " + first(checked));
+}
+
+// Both have to point at the offending byte itself, not the one after it
+void check_position(const std::string &score, char bad) {
+  const auto offset = score.find(bad);
+  const auto line_start = score.rfind('\n', offset) + 1;
+  FileReading::Parser::Parser parser(score);
+  const auto parsed = parser.parse();
+  for (const auto &diagnostics :
+       {parsed.diagnostics(), FileReading::Validator::validate(score, 10)}) {
+    if (!Test::check(!diagnostics.empty(), "no error in:\n" + score))
+      continue;
+    const auto &first = diagnostics.kept().front();
+    Test::check(first.offset == offset &&
+                    first.loc.col == offset - line_start + 1,
+                first.message() + " at offset " +
+                    std::to_string(first.offset) + ", not " +
+                    std::to_string(offset));
+  }
+}
+
+} // namespace
+
+int main() {
+  check_position("BPM: q = 120\n\n[START]\nC4 q\nX4 q\n[END]\n", 'X');
+  check_position("BPM: q = 120\n[START]\nC4 Z\n[END]\n", 'Z');
+  check_position("BPM: q = 120\n[START]\nC4 q\nD4 x\n[END]\n", 'x');
+
+  std::vector<std::string> examples;
+  for (const auto &file : std::filesystem::directory_iterator("examples")) {
+    examples.push_back(read(file.path()));
+    check_score(examples.back());
+  }
+
+  const std::string bytes = "ABCDEFGRqehswt#b[]:=.0123456789 \n\t\r;xPMS\x80";
+  const char *const pieces[] = {
+      "BPM", "BP", "B", "[START]", "[END]", "[C4 E4 G4]", "[", "]", "C#4 q",
+      "Db3 e.", "R q", "q", ".", ";x\n", "\n", " ", "4", "[;4\n]",
+      "[ ;c\n X]", "[4", "= 90", ": q", "[PART2]", "[A2", "[C4E4] q",
+      "[Cb4 X] q", "[ B#12 ]", "[G]", "[C4 E]"};
+  std::mt19937 rng(11);
+  for (int i = 0; i < 20000 && Test::failures < 5; ++i) {
+    std::string score;
+    if (rng() % 3 == 0) {
+      for (auto n = rng() % 20; n > 0; --n)
+        score += pieces[rng() % std::size(pieces)];
+      if (rng() % 2)
+        score = "BPM: q = 120\n[START]\n" + score;
+    } else {
+      score = examples[rng() % examples.size()].substr(0, 3000);
+      for (auto n = rng() % 3; n > 0 && !score.empty(); --n) {
+        const auto at = rng() % score.size();
+        switch (rng() % 3) {
+        case 0:
+          score.erase(at, rng() % 4);
+          break;
+        case 1:
+          score.insert(at, 1, bytes[rng() % bytes.size()]);
+          break;
+        default:
+          score.insert(at, pieces[rng() % std::size(pieces)]);
+        }
+      }
+    }
+    check_score(score);
+  }
+
+  // Mostly errors by construction, but the valid side must be covered too
+  Test::check(accepted > 1000,
+              std::to_string(accepted) + " scores accepted by both");
+  return Test::finish("validator_test");
+}
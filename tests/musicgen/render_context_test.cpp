@@ -0,0 +1,114 @@
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "check.hpp"
+#include "musicgen/render_context.hpp"
+
+// Hundreds of RenderContexts rendering on many threads at once, each of
+// which has to come out exactly as when rendered on its own: samples,
+// status, diagnostics and warnings, with every warning also passed to its
+// own context's callback. `make tsan` runs this under ThreadSanitizer.
+
+namespace {
+
+constexpr std::size_t kSongs = 256;
+constexpr unsigned int kThreads = 16;
+
+struct Outcome {
+  bool ok = false;
+  std::vector<std::int16_t> samples;
+  std::vector<std::string> diagnostics;
+  std::vector<std::string> warnings;
+  std::vector<std::string> called_back;
+  std::size_t voices = 0;
+
+  bool operator==(const Outcome &) const = default;
+};
+
+Outcome render(const std::string &score,
+               const MusicGen::RenderOptions &options) {
+  Outcome outcome;
+  MusicGen::RenderContext context(score, [&](std::string_view warning) {
+    outcome.called_back.emplace_back(warning);
+  });
+  const auto result =
+      context.render(options, [&](std::span<const std::int16_t> block) {
+        outcome.samples.insert(outcome.samples.end(), block.begin(),
+                               block.end());
+      });
+  outcome.ok = result.ok();
+  outcome.diagnostics = result.diagnostics;
+  outcome.warnings = result.warnings;
+  outcome.voices = context.voices().size();
+  return outcome;
+}
+
+std::vector<std::string> scores() {
+  std::vector<std::string> scores;
+  for (const auto &file : std::filesystem::directory_iterator("examples")) {
+    std::ifstream in(file.path(), std::ios::binary);
+    std::stringstream text;
+    text << in.rdbuf();
+    // The first few bars are plenty, and keep the run short
+    auto score = text.str();
+    if (score.size() > 1000)
+      score = score.substr(0, score.rfind('\n', 1000)) + "\n[END]\n";
+    scores.push_back(std::move(score));
+  }
+  // Warns while parsing
+  scores.push_back("BPM: q. = 100\n[START]\nC4 q\n[C4 E4 G4] e.\n[END]\n");
+  return scores;
+}
+
+} // namespace
+
+int main() {
+  const auto songs = scores();
+  MusicGen::RenderOptions options;
+  options.sample_rate = 8000;
+  // Warns while rendering
+  MusicGen::RenderOptions loud = options;
+  loud.amplitude = 2.0;
+
+  auto options_for = [&](std::size_t song) -> const MusicGen::RenderOptions & {
+    return song % 3 == 0 ? loud : options;
+  };
+
+  std::vector<Outcome> expected;
+  for (std::size_t s = 0; s < songs.size() * 3; ++s)
+    expected.push_back(render(songs[s % songs.size()], options_for(s)));
+  std::size_t warned = 0;
+  for (const auto &outcome : expected) {
+    Test::check(outcome.warnings == outcome.called_back,
+                "warnings and callback differ");
+    warned += !outcome.warnings.empty();
+  }
+  Test::check(warned > 0, "no score warned");
+
+  std::atomic<std::size_t> next{0}, mismatches{0};
+  std::vector<std::thread> threads;
+  for (unsigned int t = 0; t < kThreads; ++t)
+    threads.emplace_back([&, t] {
+      for (std::size_t song; (song = next++) < kSongs;) {
+        const auto s = song % expected.size();
+        auto song_options = options_for(s);
+        // Some mix their voices on threads of their own as well
+        song_options.threads = t % 4 == 0 ? 2 : 1;
+        if (render(songs[s % songs.size()], song_options) != expected[s])
+          ++mismatches;
+      }
+    });
+  for (auto &thread : threads)
+    thread.join();
+
+  Test::check(mismatches == 0, std::to_string(mismatches.load()) + " of " +
+                                   std::to_string(kSongs) +
+                                   " concurrent renders differ");
+  return Test::finish("render_context_test");
+}